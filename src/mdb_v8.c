@@ -24,11 +24,14 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <libproc.h>
 #include <sys/avl.h>
+#include <sys/param.h>
+#include <sys/stat.h>
 #include <alloca.h>
 
 #include "v8dbg.h"
@@ -37,7 +40,9 @@
 #include "mdb_v8_dbg.h"
 #include "mdb_v8_dbi.h"
 
+#ifndef	offsetof
 #define	offsetof(s, m)	((size_t)(&(((s *)0)->m)))
+#endif
 
 #ifndef MDBV8_VERS_TAG
 #error build must define MDBV8_VERS_TAG
@@ -50,8 +55,10 @@ const char *mdbv8_vers_tag = MDBV8_VERS_TAG;
  */
 typedef struct v8_class {
 	struct v8_class *v8c_next;	/* list linkage */
+	struct v8_class *v8c_hnext;	/* hash linkage */
 	struct v8_class *v8c_parent;	/* parent class (inheritance) */
 	struct v8_field *v8c_fields;	/* array of class fields */
+	struct v8_field *v8c_lastfield;	/* last entry in v8c_fields */
 	size_t		v8c_start;	/* offset of first class field */
 	size_t		v8c_end;	/* offset of first subclass field */
 	char		v8c_name[64];	/* heap object class name */
@@ -59,6 +66,8 @@ typedef struct v8_class {
 
 typedef struct v8_field {
 	struct v8_field	*v8f_next;	/* list linkage */
+	struct v8_field	*v8f_hnext;	/* hash linkage */
+	struct v8_class	*v8f_class;	/* containing class */
 	ssize_t		v8f_offset;	/* field offset */
 	char 		v8f_name[64];	/* field name */
 	boolean_t	v8f_isbyte;	/* 1-byte int field */
@@ -75,10 +84,20 @@ typedef struct {
 
 /*
  * During configuration, the dmod updates these globals with the actual set of
- * classes, types, and frame types based on the debug metadata.
+ * classes, types, and frame types based on the debug metadata.  v8_classes is
+ * sorted by name, and each class's fields are sorted by offset.  Classes and
+ * fields are also hashed by name (see conf_class_lookup() and
+ * conf_field_lookup()) so that configuration doesn't take time quadratic in
+ * the number of classes and fields.
  */
 static v8_class_t	*v8_classes;
 
+#define	V8_CLASS_NHASH	256
+#define	V8_FIELD_NHASH	2048
+
+static v8_class_t	*v8_class_hash[V8_CLASS_NHASH];
+static v8_field_t	*v8_field_hash[V8_FIELD_NHASH];
+
 static v8_enum_t	v8_types[128];
 static int 		v8_next_type;
 
@@ -191,6 +210,7 @@ ssize_t V8_OFF_CONSSTRING_SECOND;
 ssize_t V8_OFF_EXTERNALSTRING_RESOURCE;
 ssize_t V8_OFF_FIXEDARRAY_DATA;
 ssize_t V8_OFF_FIXEDARRAY_LENGTH;
+ssize_t V8_OFF_FIXEDTYPEDARRAYBASE_BASE_POINTER;
 ssize_t V8_OFF_HEAPNUMBER_VALUE;
 ssize_t V8_OFF_HEAPOBJECT_MAP;
 ssize_t V8_OFF_JSARRAY_LENGTH;
@@ -242,6 +262,20 @@ ssize_t V8_OFF_JSARRAYBUFFER_BACKINGSTORE;
 ssize_t V8_OFF_JSARRAYBUFFERVIEW_BUFFER;
 ssize_t V8_OFF_JSARRAYBUFFERVIEW_CONTENT_OFFSET;
 
+/*
+ * The following are derived from the metadata when we configure, so that code
+ * that runs for every object or Map doesn't need to look up classes and fields
+ * by name (or compare version numbers).
+ */
+static boolean_t V8_MAP_BIT_FIELD3_ISSMI;	/* bit_field3 is an SMI */
+static ssize_t	V8_OFF_FIXEDTYPEDARRAY_DATA;	/* first uint32_t element */
+static size_t	V8_SIZE_FIXEDARRAY_HEADER;	/* map and length */
+size_t		V8_SIZE_JSBOUNDFUNCTION;	/* header size */
+size_t		V8_SIZE_JSFUNCTION;
+size_t		V8_SIZE_SCRIPT;
+size_t		V8_SIZE_SHAREDFUNCTIONINFO;
+size_t		V8_SIZE_STRING;			/* max header size */
+
 #define	V8_CONSTANT_OPTIONAL		1
 #define	V8_CONSTANT_HASFALLBACK		2
 #define	V8_CONSTANT_REMOVED		4
@@ -428,6 +462,8 @@ static v8_offset_t v8_offsets[] = {
 	    "FixedArray", "data" },
 	{ &V8_OFF_FIXEDARRAY_LENGTH,
 	    "FixedArray", "length" },
+	{ &V8_OFF_FIXEDTYPEDARRAYBASE_BASE_POINTER,
+	    "FixedTypedArrayBase", "base_pointer", B_TRUE },
 	{ &V8_OFF_HEAPNUMBER_VALUE,
 	    "HeapNumber", "value" },
 	{ &V8_OFF_HEAPOBJECT_MAP,
@@ -595,19 +631,27 @@ static uintptr_t v8_patch;
 
 static int autoconf_iter_symbol(mdb_symbol_t *, void *);
 static v8_class_t *conf_class_findcreate(const char *);
+static v8_class_t *conf_class_lookup(const char *);
 static v8_field_t *conf_field_create(v8_class_t *, const char *, size_t);
+static v8_field_t *conf_field_lookup(const char *, const char *);
+static void conf_class_sort(void);
+static void conf_field_sort(v8_class_t *);
 static char *conf_next_part(char *, char *);
 static int conf_update_parent(const char *);
-static int conf_update_field(v8_cfg_t *, const char *);
-static int conf_update_enum(v8_cfg_t *, const char *, const char *,
+static int conf_update_field(v8_cfg_t *, mdb_symbol_t *);
+static int conf_update_enum(v8_cfg_t *, mdb_symbol_t *, const char *,
     v8_enum_t *);
-static int conf_update_type(v8_cfg_t *, const char *);
-static int conf_update_frametype(v8_cfg_t *, const char *);
+static int conf_update_type(v8_cfg_t *, mdb_symbol_t *);
+static int conf_update_frametype(v8_cfg_t *, mdb_symbol_t *);
 static void conf_class_compute_offsets(v8_class_t *);
+static size_t conf_class_size(const char *);
 
 static int heap_offset(const char *, const char *, ssize_t *);
 static int jsfunc_name(uintptr_t, char **, size_t *);
 
+static void configure(void);
+static void enable_demangling(void);
+
 
 /*
  * When iterating properties, it's useful to keep track of what kinds of
@@ -638,9 +682,35 @@ typedef enum {
 	JPI_HASCONTENT		= 0x200, /* found a separate content array */
 } jspropinfo_t;
 
+/*
+ * Streaming output for ::jsprint: see jsobj_sink_reserve() for details.
+ */
+typedef struct jsobj_sink {
+	FILE	*jss_fp;	/* output file, or NULL for mdb_printf */
+	char	*jss_buf;	/* output buffer */
+	size_t	jss_bufsz;	/* size of jss_buf */
+	char	*jss_bufp;	/* current position in jss_buf */
+	size_t	jss_len;	/* bytes left in jss_buf */
+	size_t	jss_nflushed;	/* bytes written out so far */
+	char	jss_lastc;	/* last character written out */
+} jsobj_sink_t;
+
+#define	JSOBJ_SINK_BUFSZ	262144
+
+/*
+ * Objects already printed by ::jsprint: see jsobj_print_visit() for details.
+ */
+typedef struct jsobj_visited {
+	avl_node_t	jsv_node;
+	uintptr_t	jsv_addr;	/* address of object */
+	boolean_t	jsv_onpath;	/* object is still being printed */
+} jsobj_visited_t;
+
 typedef struct jsobj_print {
 	char **jsop_bufp;
 	size_t *jsop_lenp;
+	jsobj_sink_t *jsop_sink;
+	avl_tree_t *jsop_visited;
 	int jsop_indent;
 	uint64_t jsop_depth;
 	boolean_t jsop_printaddr;
@@ -650,9 +720,14 @@ typedef struct jsobj_print {
 	size_t jsop_maxstrlen;
 	boolean_t jsop_found;
 	boolean_t jsop_descended;
+	boolean_t jsop_utf8;
 	jspropinfo_t jsop_propinfo;
 } jsobj_print_t;
 
+static void jsobj_sink_reserve(jsobj_print_t *, size_t);
+static boolean_t jsobj_print_visit(uintptr_t, jsobj_print_t *,
+    jsobj_visited_t **);
+
 static int jsobj_print_number(uintptr_t, jsobj_print_t *);
 static int jsobj_print_oddball(uintptr_t, jsobj_print_t *);
 static int jsobj_print_jsobject(uintptr_t, jsobj_print_t *);
@@ -694,6 +769,45 @@ typedef struct {
 static int jsobj_layout_load(jsobj_layout_t *, uintptr_t);
 static boolean_t jsobj_layout_untagged(jsobj_layout_t *, uintptr_t);
 
+/*
+ * Map shapes: see jsobj_shape_load() for details.
+ */
+
+/*
+ * Describes one named property that's stored as a "field" of objects having a
+ * particular Map, including where to find the value for any such object.
+ */
+typedef struct jsobj_shapeprop {
+	char		*jsp_name;	/* property name */
+	boolean_t	jsp_inobject;	/* value is in the object itself */
+	boolean_t	jsp_untagged;	/* value is an unboxed double */
+	intptr_t	jsp_offset;	/* offset of in-object value */
+	intptr_t	jsp_propidx;	/* field index */
+	intptr_t	jsp_arrayidx;	/* index into "properties" array */
+} jsobj_shapeprop_t;
+
+typedef struct jsobj_shape {
+	uintptr_t		js_map;		/* address of Map */
+	boolean_t		js_cached;	/* in jsobj_shapes */
+	uint_t			js_refcnt;	/* active consumers */
+	boolean_t		js_haskind;	/* js_kind is valid */
+	uint8_t			js_kind;	/* elements kind */
+	boolean_t		js_dict;	/* dictionary mode */
+	jspropinfo_t		js_propinfo;	/* decoding flags */
+	ssize_t			js_ndescs;	/* descriptor count */
+	size_t			js_nprops;	/* valid js_props */
+	jsobj_shapeprop_t	*js_props;	/* field properties */
+} jsobj_shape_t;
+
+#define	JSOBJ_NSHAPES	1024
+
+static jsobj_shape_t *jsobj_shapes[JSOBJ_NSHAPES];
+static v8cache_stats_t jsobj_shape_stats;
+
+static jsobj_shape_t *jsobj_shape_load(uintptr_t);
+static void jsobj_shape_release(jsobj_shape_t *);
+static void jsobj_shape_clear(void);
+
 /*
  * Returns 1 if the V8 version v8_major.v8.minor is strictly older than
  * the V8 version represented by "flags".
@@ -740,8 +854,10 @@ static int
 autoconfigure(v8_cfg_t *cfgp)
 {
 	v8_class_t *clp;
+	v8_field_t *flp;
 	v8_enum_t *ep;
 	struct v8_constant *cnp;
+	ssize_t off;
 	int ii;
 	int failed = 0;
 	int constant_optional, constant_removed, constant_added;
@@ -752,9 +868,16 @@ autoconfigure(v8_cfg_t *cfgp)
 	assert(v8_classes == NULL);
 
 	/*
-	 * Iterate all global symbols looking for metadata.
+	 * Iterate all global symbols looking for metadata.  Classes and fields
+	 * are added in whatever order the symbols appear, so sort them once
+	 * we're done (even if we failed part way).
 	 */
-	if (cfgp->v8cfg_iter(cfgp, autoconf_iter_symbol, cfgp) != 0) {
+	failed = cfgp->v8cfg_iter(cfgp, autoconf_iter_symbol, cfgp);
+	conf_class_sort();
+	for (clp = v8_classes; clp != NULL; clp = clp->v8c_next)
+		conf_field_sort(clp);
+
+	if (failed != 0) {
 		mdb_warn("failed to autoconfigure V8 support\n");
 		return (-1);
 	}
@@ -1035,6 +1158,60 @@ again:
 	if (V8_OFF_MAP_BIT_FIELD2 == -1)
 		V8_OFF_MAP_BIT_FIELD2 = V8_OFF_MAP_INSTANCE_ATTRIBUTES + 3;
 
+	/*
+	 * Versions of V8 prior to Node 0.12 treated bit_field3 as an SMI, so it
+	 * was pointer-sized, and it has to be converted from an SMI before
+	 * using it.  In 0.12, it's treated as a raw uint32_t, meaning it's
+	 * always int-sized and it should not be converted.  We can tell which
+	 * case we're in because the debug constant
+	 * (v8dbg_class_map__bit_field3__TYPE) tells us whether the TYPE is
+	 * "SMI" or "int".  v8f_isbyte indicates the type is "int".
+	 */
+	flp = conf_field_lookup("Map", "bit_field3");
+	V8_MAP_BIT_FIELD3_ISSMI = flp != NULL && !flp->v8f_isbyte;
+
+	/*
+	 * Large layout descriptors are FixedTypedArrays of uint32_t (see
+	 * jsobj_layout_load()).  On V8 prior to 4.6.85.23, the data for a
+	 * FixedTypedArray starts at the first double-aligned address after the
+	 * base pointer.  With that V8 version (and possibly earlier), there's
+	 * an extra pointer-sized value that we need to skip.
+	 */
+	if (V8_OFF_FIXEDTYPEDARRAYBASE_BASE_POINTER == -1) {
+		V8_OFF_FIXEDTYPEDARRAY_DATA = -1;
+	} else {
+		off = V8_OFF_FIXEDTYPEDARRAYBASE_BASE_POINTER +
+		    sizeof (uintptr_t);
+		if (!v8_version_current_older(4, 6, 85, 23))
+			off += sizeof (uintptr_t);
+		off += (sizeof (double) - 1);
+		off &= ~(sizeof (double) - 1);
+		V8_OFF_FIXEDTYPEDARRAY_DATA = off;
+	}
+
+	/*
+	 * The loaders for functions and related objects read each object's
+	 * fixed-size header at once (see read_heap_header()), so figure out
+	 * how big those headers are.
+	 */
+	V8_SIZE_JSBOUNDFUNCTION = conf_class_size("JSBoundFunction");
+	V8_SIZE_JSFUNCTION = conf_class_size("JSFunction");
+	V8_SIZE_SCRIPT = conf_class_size("Script");
+	V8_SIZE_SHAREDFUNCTIONINFO = conf_class_size("SharedFunctionInfo");
+	V8_SIZE_FIXEDARRAY_HEADER = MAX(V8_OFF_HEAPOBJECT_MAP,
+	    V8_OFF_FIXEDARRAY_LENGTH) - V8_OFF_HEAP(0) + sizeof (uintptr_t);
+
+	/*
+	 * Strings are loaded the same way.  The header we read covers the
+	 * fields of every kind of string we know how to print.
+	 */
+	off = MAX(V8_OFF_STRING_LENGTH, V8_OFF_CONSSTRING_FIRST);
+	off = MAX(off, V8_OFF_CONSSTRING_SECOND);
+	off = MAX(off, V8_OFF_SLICEDSTRING_PARENT);
+	off = MAX(off, V8_OFF_SLICEDSTRING_OFFSET);
+	off = MAX(off, V8_OFF_EXTERNALSTRING_RESOURCE);
+	V8_SIZE_STRING = off - V8_OFF_HEAP(0) + sizeof (uintptr_t);
+
 	/*
 	 * V8_SCOPEINFO_IDX_FIRST_VARS' value was 4 in V8 3.7 and up,
 	 * then 5 when StrongModeFreeVariableCount was added with
@@ -1130,27 +1307,45 @@ again:
 	return (failed ? -1 : 0);
 }
 
+/*
+ * Called for every global symbol in the target, of which only a small fraction
+ * are V8 metadata.  We check the common "v8dbg_" prefix first so that other
+ * symbols are rejected with a single comparison, and then dispatch on the next
+ * character rather than comparing against each kind of metadata in turn.
+ */
 /* ARGSUSED */
 static int
 autoconf_iter_symbol(mdb_symbol_t *symp, void *arg)
 {
 	v8_cfg_t *cfgp = arg;
+	const char *name = symp->sym_name;
+	const char *kind;
 
-	if (strncmp(symp->sym_name, "v8dbg_parent_",
-	    sizeof ("v8dbg_parent_") - 1) == 0)
-		return (conf_update_parent(symp->sym_name));
-
-	if (strncmp(symp->sym_name, "v8dbg_class_",
-	    sizeof ("v8dbg_class_") - 1) == 0)
-		return (conf_update_field(cfgp, symp->sym_name));
-
-	if (strncmp(symp->sym_name, "v8dbg_type_",
-	    sizeof ("v8dbg_type_") - 1) == 0)
-		return (conf_update_type(cfgp, symp->sym_name));
+	if (name[0] != 'v' || strncmp(name, "v8dbg_",
+	    sizeof ("v8dbg_") - 1) != 0)
+		return (0);
 
-	if (strncmp(symp->sym_name, "v8dbg_frametype_",
-	    sizeof ("v8dbg_frametype_") - 1) == 0)
-		return (conf_update_frametype(cfgp, symp->sym_name));
+	kind = name + sizeof ("v8dbg_") - 1;
+	switch (*kind) {
+	case 'c':
+		if (strncmp(kind, "class_", sizeof ("class_") - 1) == 0)
+			return (conf_update_field(cfgp, symp));
+		break;
+	case 'f':
+		if (strncmp(kind, "frametype_", sizeof ("frametype_") - 1) == 0)
+			return (conf_update_frametype(cfgp, symp));
+		break;
+	case 'p':
+		if (strncmp(kind, "parent_", sizeof ("parent_") - 1) == 0)
+			return (conf_update_parent(name));
+		break;
+	case 't':
+		if (strncmp(kind, "type_", sizeof ("type_") - 1) == 0)
+			return (conf_update_type(cfgp, symp));
+		break;
+	default:
+		break;
+	}
 
 	return (0);
 }
@@ -1173,64 +1368,190 @@ conf_next_part(char *buf, char *start)
 	return (pp + sizeof ("__") - 1);
 }
 
-static v8_class_t *
-conf_class_findcreate(const char *name)
+static uint_t
+conf_hash(const char *str, uint_t hash)
 {
-	v8_class_t *clp, *iclp, *prev = NULL;
-	int cmp;
+	while (*str != '\0')
+		hash = hash * 31 + (uchar_t)*str++;
 
-	for (iclp = v8_classes; iclp != NULL; iclp = iclp->v8c_next) {
-		if ((cmp = strcmp(iclp->v8c_name, name)) == 0)
-			return (iclp);
+	return (hash);
+}
 
-		if (cmp > 0)
-			break;
+static v8_class_t *
+conf_class_lookup(const char *name)
+{
+	v8_class_t *clp;
 
-		prev = iclp;
+	clp = v8_class_hash[conf_hash(name, 0) % V8_CLASS_NHASH];
+	for (; clp != NULL; clp = clp->v8c_hnext) {
+		if (strcmp(clp->v8c_name, name) == 0)
+			break;
 	}
 
+	return (clp);
+}
+
+/*
+ * Returns the class called "name", creating it if necessary.  New classes are
+ * added to the front of v8_classes; callers that create classes must call
+ * conf_class_sort() once they're done.
+ */
+static v8_class_t *
+conf_class_findcreate(const char *name)
+{
+	v8_class_t *clp;
+	uint_t bucket;
+
+	if ((clp = conf_class_lookup(name)) != NULL)
+		return (clp);
+
 	if ((clp = mdb_zalloc(sizeof (*clp), UM_NOSLEEP)) == NULL)
 		return (NULL);
 
 	(void) strlcpy(clp->v8c_name, name, sizeof (clp->v8c_name));
 	clp->v8c_end = (size_t)-1;
-	clp->v8c_next = iclp;
-
-	if (prev != NULL) {
-		prev->v8c_next = clp;
-	} else {
-		v8_classes = clp;
-	}
+	clp->v8c_next = v8_classes;
+	v8_classes = clp;
 
+	bucket = conf_hash(clp->v8c_name, 0) % V8_CLASS_NHASH;
+	clp->v8c_hnext = v8_class_hash[bucket];
+	v8_class_hash[bucket] = clp;
 	return (clp);
 }
 
+/*
+ * Creates field "name" in class "clp".  New fields are added to the end of the
+ * class's list of fields, and callers must call conf_field_sort() once they're
+ * done.
+ */
 static v8_field_t *
 conf_field_create(v8_class_t *clp, const char *name, size_t offset)
 {
-	v8_field_t *flp, *iflp;
+	v8_field_t *flp;
+	uint_t bucket;
 
 	if ((flp = mdb_zalloc(sizeof (*flp), UM_NOSLEEP)) == NULL)
 		return (NULL);
 
 	(void) strlcpy(flp->v8f_name, name, sizeof (flp->v8f_name));
 	flp->v8f_offset = offset;
-
-	if (clp->v8c_fields == NULL || clp->v8c_fields->v8f_offset > offset) {
-		flp->v8f_next = clp->v8c_fields;
+	flp->v8f_class = clp;
+	if (clp->v8c_lastfield != NULL)
+		clp->v8c_lastfield->v8f_next = flp;
+	else
 		clp->v8c_fields = flp;
+	clp->v8c_lastfield = flp;
+
+	bucket = conf_hash(flp->v8f_name,
+	    conf_hash(clp->v8c_name, 0)) % V8_FIELD_NHASH;
+	flp->v8f_hnext = v8_field_hash[bucket];
+	v8_field_hash[bucket] = flp;
+	return (flp);
+}
+
+/*
+ * Sort v8_classes by name.  This is a merge sort on the linked list.
+ */
+static v8_class_t *
+conf_class_merge(v8_class_t *clp, size_t n)
+{
+	v8_class_t *lhs, *rhs, *head, **tailp;
+	size_t i, nl;
+
+	if (n <= 1) {
+		if (clp != NULL)
+			clp->v8c_next = NULL;
+		return (clp);
+	}
+
+	nl = n / 2;
+	for (rhs = clp, i = 0; i < nl; i++)
+		rhs = rhs->v8c_next;
+
+	lhs = conf_class_merge(clp, nl);
+	rhs = conf_class_merge(rhs, n - nl);
+
+	tailp = &head;
+	while (lhs != NULL && rhs != NULL) {
+		if (strcmp(lhs->v8c_name, rhs->v8c_name) <= 0) {
+			*tailp = lhs;
+			lhs = lhs->v8c_next;
+		} else {
+			*tailp = rhs;
+			rhs = rhs->v8c_next;
+		}
+
+		tailp = &(*tailp)->v8c_next;
+	}
+
+	*tailp = lhs != NULL ? lhs : rhs;
+	return (head);
+}
+
+static void
+conf_class_sort(void)
+{
+	v8_class_t *clp;
+	size_t n = 0;
+
+	for (clp = v8_classes; clp != NULL; clp = clp->v8c_next)
+		n++;
+
+	v8_classes = conf_class_merge(v8_classes, n);
+}
+
+/*
+ * Sort the fields of a class by offset.  Fields at the same offset are kept in
+ * the order in which they were created.
+ */
+static v8_field_t *
+conf_field_merge(v8_field_t *flp, size_t n)
+{
+	v8_field_t *lhs, *rhs, *head, **tailp;
+	size_t i, nl;
+
+	if (n <= 1) {
+		if (flp != NULL)
+			flp->v8f_next = NULL;
 		return (flp);
 	}
 
-	for (iflp = clp->v8c_fields; iflp->v8f_next != NULL;
-	    iflp = iflp->v8f_next) {
-		if (iflp->v8f_next->v8f_offset > offset)
-			break;
+	nl = n / 2;
+	for (rhs = flp, i = 0; i < nl; i++)
+		rhs = rhs->v8f_next;
+
+	lhs = conf_field_merge(flp, nl);
+	rhs = conf_field_merge(rhs, n - nl);
+
+	tailp = &head;
+	while (lhs != NULL && rhs != NULL) {
+		if (lhs->v8f_offset <= rhs->v8f_offset) {
+			*tailp = lhs;
+			lhs = lhs->v8f_next;
+		} else {
+			*tailp = rhs;
+			rhs = rhs->v8f_next;
+		}
+
+		tailp = &(*tailp)->v8f_next;
 	}
 
-	flp->v8f_next = iflp->v8f_next;
-	iflp->v8f_next = flp;
-	return (flp);
+	*tailp = lhs != NULL ? lhs : rhs;
+	return (head);
+}
+
+static void
+conf_field_sort(v8_class_t *clp)
+{
+	v8_field_t *flp;
+	size_t n = 0;
+
+	for (flp = clp->v8c_fields; flp != NULL; flp = flp->v8f_next)
+		n++;
+
+	clp->v8c_fields = conf_field_merge(clp->v8c_fields, n);
+	for (flp = clp->v8c_fields; flp != NULL; flp = flp->v8f_next)
+		clp->v8c_lastfield = flp;
 }
 
 /*
@@ -1269,8 +1590,9 @@ conf_update_parent(const char *symbol)
  * not necessarily exist already.
  */
 static int
-conf_update_field(v8_cfg_t *cfgp, const char *symbol)
+conf_update_field(v8_cfg_t *cfgp, mdb_symbol_t *symp)
 {
+	const char *symbol = symp->sym_name;
 	v8_class_t *clp;
 	v8_field_t *flp;
 	intptr_t offset;
@@ -1287,7 +1609,7 @@ conf_update_field(v8_cfg_t *cfgp, const char *symbol)
 	if (qq == NULL || (tt = conf_next_part(buf, qq)) == NULL)
 		return (-1);
 
-	if (cfgp->v8cfg_readsym(cfgp, symbol, &offset) == -1) {
+	if (cfgp->v8cfg_symvalue(cfgp, symp, &offset) == -1) {
 		mdb_warn("failed to read symbol \"%s\"", symbol);
 		return (-1);
 	}
@@ -1323,13 +1645,13 @@ conf_update_field(v8_cfg_t *cfgp, const char *symbol)
 }
 
 static int
-conf_update_enum(v8_cfg_t *cfgp, const char *symbol, const char *name,
+conf_update_enum(v8_cfg_t *cfgp, mdb_symbol_t *symp, const char *name,
     v8_enum_t *enp)
 {
 	intptr_t value;
 
-	if (cfgp->v8cfg_readsym(cfgp, symbol, &value) == -1) {
-		mdb_warn("failed to read symbol \"%s\"", symbol);
+	if (cfgp->v8cfg_symvalue(cfgp, symp, &value) == -1) {
+		mdb_warn("failed to read symbol \"%s\"", symp->sym_name);
 		return (-1);
 	}
 
@@ -1343,13 +1665,15 @@ conf_update_enum(v8_cfg_t *cfgp, const char *symbol, const char *name,
  * that this enum has multiple integer values with the same string label.
  */
 static int
-conf_update_type(v8_cfg_t *cfgp, const char *symbol)
+conf_update_type(v8_cfg_t *cfgp, mdb_symbol_t *symp)
 {
+	const char *symbol = symp->sym_name;
 	char *klass;
 	v8_enum_t *enp;
 	char buf[128];
 
-	if (v8_next_type > sizeof (v8_types) / sizeof (v8_types[0])) {
+	/* Leave an empty entry at the end to terminate the table. */
+	if (v8_next_type >= sizeof (v8_types) / sizeof (v8_types[0]) - 1) {
 		mdb_warn("too many V8 types\n");
 		return (-1);
 	}
@@ -1361,7 +1685,7 @@ conf_update_type(v8_cfg_t *cfgp, const char *symbol)
 		return (-1);
 
 	enp = &v8_types[v8_next_type++];
-	return (conf_update_enum(cfgp, symbol, klass, enp));
+	return (conf_update_enum(cfgp, symp, klass, enp));
 }
 
 /*
@@ -1369,20 +1693,21 @@ conf_update_type(v8_cfg_t *cfgp, const char *symbol)
  * v8_frametypes.
  */
 static int
-conf_update_frametype(v8_cfg_t *cfgp, const char *symbol)
+conf_update_frametype(v8_cfg_t *cfgp, mdb_symbol_t *symp)
 {
+	const char *symbol = symp->sym_name;
 	const char *frametype;
 	v8_enum_t *enp;
 
-	if (v8_next_frametype >
-	    sizeof (v8_frametypes) / sizeof (v8_frametypes[0])) {
+	if (v8_next_frametype >=
+	    sizeof (v8_frametypes) / sizeof (v8_frametypes[0]) - 1) {
 		mdb_warn("too many V8 frame types\n");
 		return (-1);
 	}
 
 	enp = &v8_frametypes[v8_next_frametype++];
 	frametype = symbol + sizeof ("v8dbg_frametype_") - 1;
-	return (conf_update_enum(cfgp, symbol, frametype, enp));
+	return (conf_update_enum(cfgp, symp, frametype, enp));
 }
 
 /*
@@ -1418,11 +1743,29 @@ conf_class_compute_offsets(v8_class_t *clp)
 		clp->v8c_end = flp->v8f_offset + sizeof (uintptr_t);
 }
 
+/*
+ * Returns the size of the fixed part of instances of class "name" (that is, the
+ * offset where fields of its subclasses would start), or 0 if that's not known.
+ */
+static size_t
+conf_class_size(const char *name)
+{
+	v8_class_t *clp;
+
+	if ((clp = conf_class_lookup(name)) == NULL ||
+	    clp->v8c_end == (size_t)-1)
+		return (0);
+
+	return (clp->v8c_end);
+}
+
 /*
  * Utility functions
  */
 
 static int jsstr_print(uintptr_t, uint_t, char **, size_t *);
+static int jsstr_print_flags(uintptr_t, mdbv8_strappend_flags_t, uint_t,
+    char **, size_t *);
 static boolean_t jsobj_is_hole(uintptr_t addr);
 static boolean_t jsobj_maybe_garbage(uintptr_t addr);
 
@@ -1518,22 +1861,33 @@ v8_warn(const char *format, ...)
 	}
 }
 
+/*
+ * Returns the field "field" of class "klass".  A class may have more than one
+ * field with the same name, in which case this returns the first one in the
+ * class's list of fields.
+ */
 static v8_field_t *
 conf_field_lookup(const char *klass, const char *field)
 {
-	v8_class_t *clp;
-	v8_field_t *flp;
+	v8_field_t *flp, *match = NULL;
+	uint_t nmatches = 0;
 
-	for (clp = v8_classes; clp != NULL; clp = clp->v8c_next) {
-		if (strcmp(klass, clp->v8c_name) == 0)
-			break;
+	flp = v8_field_hash[conf_hash(field, conf_hash(klass, 0)) %
+	    V8_FIELD_NHASH];
+	for (; flp != NULL; flp = flp->v8f_hnext) {
+		if (strcmp(flp->v8f_name, field) == 0 &&
+		    strcmp(flp->v8f_class->v8c_name, klass) == 0) {
+			match = flp;
+			nmatches++;
+		}
 	}
 
-	if (clp == NULL)
-		return (NULL);
+	if (nmatches <= 1)
+		return (match);
 
-	for (flp = clp->v8c_fields; flp != NULL; flp = flp->v8f_next) {
-		if (strcmp(field, flp->v8f_name) == 0)
+	for (flp = match->v8f_class->v8c_fields; flp != NULL;
+	    flp = flp->v8f_next) {
+		if (strcmp(flp->v8f_name, field) == 0)
 			break;
 	}
 
@@ -1636,7 +1990,7 @@ heap_offset(const char *klass, const char *field, ssize_t *offp)
 int
 read_heap_ptr(uintptr_t *valp, uintptr_t addr, ssize_t off)
 {
-	if (mdb_vread(valp, sizeof (*valp), addr + off) == -1) {
+	if (dbi_vread(valp, sizeof (*valp), addr + off) == -1) {
 		v8_warn("failed to read offset %d from %p", off, addr);
 		return (-1);
 	}
@@ -1667,7 +2021,7 @@ read_heap_smi(uintptr_t *valp, uintptr_t addr, ssize_t off)
 static int
 read_heap_double(double *valp, uintptr_t addr, ssize_t off)
 {
-	if (mdb_vread(valp, sizeof (*valp), addr + off) == -1) {
+	if (dbi_vread(valp, sizeof (*valp), addr + off) == -1) {
 		v8_warn("failed to read heap value at %p", addr + off);
 		return (-1);
 	}
@@ -1684,21 +2038,30 @@ read_heap_double(double *valp, uintptr_t addr, ssize_t off)
 int
 read_heap_array(uintptr_t addr, uintptr_t **retp, size_t *lenp, int flags)
 {
+	v8header_t hdr;
 	uint8_t type;
 	uintptr_t len;
 
 	if (!V8_IS_HEAPOBJECT(addr))
 		return (-1);
 
-	if (read_typebyte(&type, addr) != 0)
+	read_heap_header(&hdr, addr, V8_SIZE_FIXEDARRAY_HEADER);
+	if (read_header_typebyte(&type, &hdr) != 0)
 		return (-1);
 
 	if (type != V8_TYPE_FIXEDARRAY)
 		return (-1);
 
-	if (read_heap_smi(&len, addr, V8_OFF_FIXEDARRAY_LENGTH) != 0)
+	if (read_header_ptr(&len, &hdr, V8_OFF_FIXEDARRAY_LENGTH) != 0)
 		return (-1);
 
+	if (!V8_IS_SMI(len)) {
+		v8_warn("expected SMI, got %p\n", len);
+		return (-1);
+	}
+
+	len = V8_SMI_VALUE(len);
+
 	*lenp = len;
 
 	if (len == 0) {
@@ -1709,7 +2072,7 @@ read_heap_array(uintptr_t addr, uintptr_t **retp, size_t *lenp, int flags)
 	if ((*retp = mdb_zalloc(len * sizeof (uintptr_t), flags)) == NULL)
 		return (-1);
 
-	if (mdb_vread(*retp, len * sizeof (uintptr_t),
+	if (dbi_vread(*retp, len * sizeof (uintptr_t),
 	    addr + V8_OFF_FIXEDARRAY_DATA) == -1) {
 		maybefree(*retp, len * sizeof (uintptr_t), flags);
 		*retp = NULL;
@@ -1722,7 +2085,7 @@ read_heap_array(uintptr_t addr, uintptr_t **retp, size_t *lenp, int flags)
 static int
 read_heap_byte(uint8_t *valp, uintptr_t addr, ssize_t off)
 {
-	if (mdb_vread(valp, sizeof (*valp), addr + off) == -1) {
+	if (dbi_vread(valp, sizeof (*valp), addr + off) == -1) {
 		v8_warn("failed to read heap value at %p", addr + off);
 		return (-1);
 	}
@@ -1751,7 +2114,7 @@ read_heap_maybesmi(uintptr_t *valp, uintptr_t addr, ssize_t off)
 #ifdef _LP64
 	uint32_t readval;
 
-	if (mdb_vread(&readval, sizeof (readval), addr + off) == -1) {
+	if (dbi_vread(&readval, sizeof (readval), addr + off) == -1) {
 		*valp = -1;
 		v8_warn("failed to read offset %d from %p", off, addr);
 		return (-1);
@@ -1770,6 +2133,129 @@ read_heap_maybesmi(uintptr_t *valp, uintptr_t addr, ssize_t off)
 #endif
 }
 
+/*
+ * Code that needs several fields of the same heap object can read the object's
+ * fixed-size header once with read_heap_header() and then decode fields from
+ * the local copy with read_header_ptr() and friends, rather than reading each
+ * field from the target separately.  "size" is normally one of the
+ * V8_SIZE_* values computed from the class metadata when we configure.
+ *
+ * The header is best-effort: fields outside the copied part (including
+ * everything, if the header couldn't be read or its size isn't known) are read
+ * from the target just as read_heap_ptr() and friends would, with the same
+ * warnings on failure.  That way callers don't need to care whether a given
+ * field's offset came from the metadata or from a fallback value that may lie
+ * beyond the class's known fields.
+ */
+void
+read_heap_header(v8header_t *hdrp, uintptr_t addr, size_t size)
+{
+	hdrp->vh_addr = addr;
+	hdrp->vh_size = MIN(size, sizeof (hdrp->vh_words));
+	if (hdrp->vh_size > 0 && dbi_vread(hdrp->vh_words, hdrp->vh_size,
+	    addr + V8_OFF_HEAP(0)) == -1)
+		hdrp->vh_size = 0;
+}
+
+/*
+ * Returns a pointer to the copy of "len" bytes at offset "off" of the object
+ * described by "hdrp", or NULL if those bytes weren't copied.
+ */
+static const void *
+read_header_field(const v8header_t *hdrp, ssize_t off, size_t len)
+{
+	ssize_t start = off - V8_OFF_HEAP(0);
+
+	if (start < 0 || start + len > hdrp->vh_size)
+		return (NULL);
+
+	return ((const uint8_t *)hdrp->vh_words + start);
+}
+
+int
+read_header_ptr(uintptr_t *valp, const v8header_t *hdrp, ssize_t off)
+{
+	const void *p;
+
+	if ((p = read_header_field(hdrp, off, sizeof (*valp))) == NULL)
+		return (read_heap_ptr(valp, hdrp->vh_addr, off));
+
+	bcopy(p, valp, sizeof (*valp));
+	return (0);
+}
+
+/*
+ * Like read_heap_smi(), but from an object header.
+ */
+int
+read_header_smi(uintptr_t *valp, const v8header_t *hdrp, ssize_t off)
+{
+	if (read_header_ptr(valp, hdrp, off) != 0)
+		return (-1);
+
+	if (!V8_IS_SMI(*valp)) {
+		v8_warn("expected SMI, got %p\n", *valp);
+		return (-1);
+	}
+
+	*valp = V8_SMI_VALUE(*valp);
+	return (0);
+}
+
+/*
+ * Like read_heap_maybesmi(), but from an object header.
+ */
+int
+read_header_maybesmi(uintptr_t *valp, const v8header_t *hdrp, ssize_t off)
+{
+#ifdef _LP64
+	const void *p;
+	uint32_t readval;
+
+	if ((p = read_header_field(hdrp, off, sizeof (readval))) == NULL)
+		return (read_heap_maybesmi(valp, hdrp->vh_addr, off));
+
+	bcopy(p, &readval, sizeof (readval));
+	if ((hdrp->vh_addr + off) % sizeof (uintptr_t) == 0)
+		readval >>= 1;
+
+	*valp = (uintptr_t)readval;
+	return (0);
+#else
+	if (read_header_ptr(valp, hdrp, off) != 0)
+		return (-1);
+
+	if (!V8_IS_SMI(*valp)) {
+		v8_warn("expected SMI, got %p\n", *valp);
+		return (-1);
+	}
+
+	*valp = V8_SMI_VALUE(*valp);
+	return (0);
+#endif
+}
+
+/*
+ * Like read_typebyte(), but uses the Map pointer from an object header.
+ */
+int
+read_header_typebyte(uint8_t *valp, const v8header_t *hdrp)
+{
+	uintptr_t mapaddr;
+
+	if (read_header_field(hdrp, V8_OFF_HEAPOBJECT_MAP,
+	    sizeof (mapaddr)) == NULL)
+		return (read_typebyte(valp, hdrp->vh_addr));
+
+	(void) read_header_ptr(&mapaddr, hdrp, V8_OFF_HEAPOBJECT_MAP);
+	if (!V8_IS_HEAPOBJECT(mapaddr)) {
+		v8_warn("object map is not a heap object\n");
+		return (-1);
+	}
+
+	return (read_heap_byte(valp, mapaddr, V8_OFF_MAP_INSTANCE_ATTRIBUTES));
+}
+
 /*
  * Given a heap object, returns in *valp the byte describing the type of the
  * object.  This is shorthand for first retrieving the Map at the start of the
@@ -1781,7 +2267,7 @@ read_typebyte(uint8_t *valp, uintptr_t addr)
 	uintptr_t mapaddr;
 	ssize_t off = V8_OFF_HEAPOBJECT_MAP;
 
-	if (mdb_vread(&mapaddr, sizeof (mapaddr), addr + off) == -1) {
+	if (dbi_vread(&mapaddr, sizeof (mapaddr), addr + off) == -1) {
 		v8_warn("failed to read type of %p", addr);
 		return (-1);
 	}
@@ -1825,10 +2311,17 @@ read_size(size_t *valp, uintptr_t addr)
 /*
  * Assuming "addr" refers to a FixedArray that is implementing a
  * StringDictionary, iterate over its contents calling the specified function
- * with key and value.
+ * with key and value.  If "name" is non-NULL, the function is only called for
+ * the property with that name, if there is one.
+ *
+ * Dictionaries can be very large, and most of the work of iterating one is
+ * decoding the keys, so when looking for a particular property, we only decode
+ * keys having the same length as the name we're looking for.  (We can't probe
+ * the dictionary directly the way V8 does, since the hash function is seeded
+ * with a per-isolate random value that we don't know how to find.)
  */
 static int
-read_heap_dict(uintptr_t addr,
+read_heap_dict(uintptr_t addr, const char *name,
     int (*func)(const char *, v8propvalue_t *, void *), void *arg,
     jspropinfo_t *propinfo)
 {
@@ -1839,6 +2332,19 @@ read_heap_dict(uintptr_t addr,
 	int rval = -1;
 	uintptr_t *dict, ndict, i;
 	v8propvalue_t value;
+	v8string_t *strp;
+	size_t namelen = 0;
+	const char *p;
+
+	/*
+	 * The length of a String is in characters, which is only the same as
+	 * the length of "name" if "name" is entirely ASCII.
+	 */
+	if (name != NULL) {
+		for (p = name; *p != '\0' && isascii(*p); p++)
+			continue;
+		namelen = *p == '\0' ? p - name : 0;
+	}
 
 	if (read_heap_array(addr, &dict, &ndict, UM_SLEEP) != 0)
 		return (-1);
@@ -1876,6 +2382,17 @@ read_heap_dict(uintptr_t addr,
 			if (!V8_TYPE_STRING(type))
 				goto out;
 
+			if (namelen != 0) {
+				if ((strp = v8string_load(dict[i],
+				    UM_SLEEP)) == NULL)
+					goto out;
+
+				len = v8string_length(strp);
+				v8string_free(strp);
+				if (len != namelen)
+					continue;
+			}
+
 			bufp = buf;
 			len = sizeof (buf);
 
@@ -1883,12 +2400,19 @@ read_heap_dict(uintptr_t addr,
 				goto out;
 		}
 
+		if (name != NULL && strcmp(buf, name) != 0)
+			continue;
+
 		if (propinfo != NULL && jsobj_maybe_garbage(dict[i + 1]))
 			*propinfo |= JPI_BADPROPS;
 
 		jsobj_propvalue_addr(&value, dict[i + 1]);
 		if (func(buf, &value, arg) == -1)
 			goto out;
+
+		/* Keys are unique, so there's nothing more to find. */
+		if (name != NULL)
+			break;
 	}
 
 	rval = 0;
@@ -2124,10 +2648,7 @@ obj_v8internal(uintptr_t addr, uint_t idx, uintptr_t *valp)
 		return (DCMD_ERR);
 	}
 
-	for (clp = v8_classes; clp != NULL; clp = clp->v8c_next) {
-		if (strcmp(rqclass, clp->v8c_name) == 0)
-			break;
-	}
+	clp = conf_class_lookup(rqclass);
 
 	if (clp == NULL) {
 		mdb_warn("%p: didn't find expected class\n", addr);
@@ -2261,19 +2782,36 @@ obj_print_class(uintptr_t addr, v8_class_t *clp)
  */
 static int
 jsstr_print(uintptr_t addr, uint_t flags, char **bufp, size_t *lenp)
+{
+	return (jsstr_print_flags(addr, MSF_ASCIIONLY, flags, bufp, lenp));
+}
+
+/*
+ * Like jsstr_print(), but with the given output flags ("strflags").  Strings
+ * that have been printed before are usually in the cache of decoded strings
+ * (see v8string_cache_write()), in which case we needn't load them at all.
+ */
+static int
+jsstr_print_flags(uintptr_t addr, mdbv8_strappend_flags_t strflags,
+    uint_t flags, char **bufp, size_t *lenp)
 {
 	mdbv8_strbuf_t strbuf;
 	v8string_t *strp;
 	int rv;
 
 	mdbv8_strbuf_init(&strbuf, *bufp, *lenp);
+	if (v8string_cache_write(addr, &strbuf, strflags, flags)) {
+		mdbv8_strbuf_legacy_update(&strbuf, bufp, lenp);
+		return (0);
+	}
+
 	strp = v8string_load(addr, UM_SLEEP);
 	if (strp == NULL) {
 		mdbv8_strbuf_appends(&strbuf,
-		    "<string (failed to load string)>", flags);
+		    "<string (failed to load string)>", strflags);
 		rv = -1;
 	} else {
-		rv = v8string_write(strp, &strbuf, MSF_ASCIIONLY, flags);
+		rv = v8string_write(strp, &strbuf, strflags, flags);
 		v8string_free(strp);
 	}
 
@@ -2483,23 +3021,27 @@ jsobj_noop(const char *name, v8propvalue_t *propval, void *arg)
 	return (0);
 }
 
-static int
-jsobj_properties(uintptr_t addr,
+/*
+ * Like jsobj_properties(), but if "name" is non-NULL, the caller is only
+ * interested in the property with that name, and the function may (but need
+ * not) skip calling "func" for other properties.
+ */
+static int
+jsobj_properties_named(uintptr_t addr, const char *name,
     int (*func)(const char *, v8propvalue_t *, void *), void *arg,
     jspropinfo_t *propinfop)
 {
 	uintptr_t ptr, map, elements;
-	uintptr_t *props = NULL, *descs = NULL, *content = NULL, *trans, *elts;
-	size_t size, nprops, ndescs, ncontent, ntrans, len;
-	ssize_t ii, rndescs;
-	uint8_t type, ninprops;
+	uintptr_t *props = NULL, *elts;
+	size_t nprops, len;
+	ssize_t ii;
+	uint8_t type;
 	int rval = -1;
 	size_t ps = sizeof (uintptr_t);
-	ssize_t off;
 	jspropinfo_t propinfo = JPI_NONE;
-	jsobj_layout_t layout;
+	jsobj_shape_t *shape = NULL;
+	jsobj_shapeprop_t *jsp;
 	v8propvalue_t value;
-	boolean_t untagged;
 
 	/*
 	 * First, check if the JSObject's "properties" field is a FixedArray.
@@ -2523,11 +3065,15 @@ jsobj_properties(uintptr_t addr,
 
 	/*
 	 * As described above, we need the Map to figure out how to iterate the
-	 * properties for this object.
+	 * properties for this object.  Everything we need from the Map is
+	 * decoded once per Map by jsobj_shape_load().
 	 */
 	if (mdb_vread(&map, ps, addr + V8_OFF_HEAPOBJECT_MAP) == -1)
 		goto err;
 
+	if ((shape = jsobj_shape_load(map)) == NULL)
+		goto err;
+
 	/*
 	 * Check to see if our elements member is an array and non-zero; if
 	 * so, it contains numerically-named properties.  Whether or not there
@@ -2541,17 +3087,15 @@ jsobj_properties(uintptr_t addr,
 	    type != V8_TYPE_JSTYPEDARRAY &&
 	    read_heap_ptr(&elements, addr, V8_OFF_JSOBJECT_ELEMENTS) == 0 &&
 	    read_heap_array(elements, &elts, &len, UM_SLEEP) == 0 && len != 0) {
-		uint8_t bit_field2, kind;
+		uint8_t kind;
 		size_t sz = len * sizeof (uintptr_t);
 
-		if (mdb_vread(&bit_field2, sizeof (bit_field2),
-		    map + V8_OFF_MAP_BIT_FIELD2) == -1) {
+		if (!shape->js_haskind) {
 			mdb_free(elts, sz);
 			goto err;
 		}
 
-		kind = bit_field2 >> V8_ELEMENTS_KIND_SHIFT;
-		kind &= (1 << V8_ELEMENTS_KIND_BITCOUNT) - 1;
+		kind = shape->js_kind;
 		propinfo |= JPI_NUMERIC;
 
 		if (kind == V8_ELEMENTS_FAST_ELEMENTS ||
@@ -2581,7 +3125,7 @@ jsobj_properties(uintptr_t addr,
 			}
 		} else if (kind == V8_ELEMENTS_DICTIONARY_ELEMENTS) {
 			propinfo |= JPI_DICT;
-			if (read_heap_dict(elements, func, arg,
+			if (read_heap_dict(elements, name, func, arg,
 			    &propinfo) != 0) {
 				mdb_free(elts, sz);
 				goto err;
@@ -2591,78 +3135,204 @@ jsobj_properties(uintptr_t addr,
 		mdb_free(elts, sz);
 	}
 
-	if (V8_DICT_SHIFT != -1) {
-		v8_field_t *flp;
-		uintptr_t bit_field3;
+	if (shape->js_dict) {
+		jsobj_shape_release(shape);
+		propinfo |= JPI_DICT;
+		if (propinfop != NULL)
+			*propinfop = propinfo;
+		return (read_heap_dict(ptr, name, func, arg, propinfop));
+	}
+
+	if (read_heap_array(ptr, &props, &nprops, UM_SLEEP) != 0)
+		goto err;
+
+	/*
+	 * At this point, we've got everything we need to process the list of
+	 * fields described by the Map.  Flags found while decoding the Map
+	 * (e.g., skipped descriptors) apply to every object that uses it.
+	 */
+	propinfo |= shape->js_propinfo;
+	for (ii = 0; ii < shape->js_nprops; ii++) {
+		jsp = &shape->js_props[ii];
 
 		/*
-		 * If dictionary properties are supported (the V8_DICT_SHIFT
-		 * offset is not -1), then bitfield 3 tells us if the properties
-		 * for this object are stored in "properties" field of the
-		 * object using a Dictionary representation.
-		 *
-		 * Versions of V8 prior to Node 0.12 treated bit_field3 as an
-		 * SMI, so it was pointer-sized, and it has to be converted from
-		 * an SMI before using it.  In 0.12, it's treated as a raw
-		 * uint32_t, meaning it's always int-sized and it should not be
-		 * converted.  We can tell which case we're in because the debug
-		 * constant (v8dbg_class_map__bit_field3__TYPE) tells us whether
-		 * the TYPE is "SMI" or "int".
+		 * Read the value into "ptr" from wherever the Map says it's
+		 * stored.
 		 */
+		if (jsp->jsp_inobject) {
+			/* This is an in-object property. */
+			if (mdb_vread(&ptr, sizeof (ptr),
+			    addr + jsp->jsp_offset) == -1) {
+				propinfo |= JPI_SKIPPED;
+				v8_warn("object %p: failed to read in-object "
+				    "property at %p", addr,
+				    addr + jsp->jsp_offset);
+				continue;
+			}
 
-		flp = conf_field_lookup("Map", "bit_field3");
-		if (flp == NULL || flp->v8f_isbyte) {
+			propinfo |= JPI_INOBJECT;
+		} else if (jsp->jsp_arrayidx >= 0 &&
+		    jsp->jsp_arrayidx < nprops) {
+			/* Valid "properties" array property found. */
+			ptr = props[jsp->jsp_arrayidx];
+			propinfo |= JPI_PROPS;
+		} else {
 			/*
-			 * v8f_isbyte indicates the type is "int", so we're in
-			 * the int-sized not-a-SMI world.
+			 * Invalid "properties" array property found.  This can
+			 * happen when properties are deleted.  If this value
+			 * isn't obviously corrupt, we'll just silently ignore
+			 * it.
 			 */
-			unsigned int bf3_value;
-			if (mdb_vread(&bf3_value, sizeof (bf3_value),
-			    map + V8_OFF_MAP_BIT_FIELD3) == -1)
-				goto err;
-			bit_field3 = (uintptr_t)bf3_value;
-		} else {
-			/* The metadata indicates this is an SMI. */
-			if (mdb_vread(&bit_field3, sizeof (bit_field3),
-			    map + V8_OFF_MAP_BIT_FIELD3) == -1)
-					goto err;
-			bit_field3 = V8_SMI_VALUE(bit_field3);
+			if (jsp->jsp_propidx < shape->js_ndescs)
+				continue;
+
+			propinfo |= JPI_SKIPPED;
+			v8_warn("object %p: property \"%s\": "
+			    "value index value out of bounds (%d)\n",
+			    addr, jsp->jsp_name, nprops);
+			continue;
 		}
 
-		if (bit_field3 & (1 << V8_DICT_SHIFT)) {
-			propinfo |= JPI_DICT;
-			if (propinfop != NULL)
-				*propinfop = propinfo;
-			return (read_heap_dict(ptr, func, arg, propinfop));
+		/*
+		 * If the property value doesn't look like a valid JavaScript
+		 * object, mark this object as dubious.
+		 */
+		if (!jsp->jsp_untagged && jsobj_maybe_garbage(ptr))
+			propinfo |= JPI_BADPROPS;
+		if (jsp->jsp_untagged) {
+			jsobj_propvalue_double(&value, makedouble(ptr));
+		} else {
+			jsobj_propvalue_addr(&value, ptr);
 		}
-	} else if (V8_OFF_MAP_INSTANCE_DESCRIPTORS != -1) {
-		uintptr_t bit_field3;
 
-		if (mdb_vread(&bit_field3, sizeof (bit_field3),
-		    map + V8_OFF_MAP_INSTANCE_DESCRIPTORS) == -1)
+		if (func(jsp->jsp_name, &value, arg) != 0)
 			goto err;
+	}
 
-		if (V8_SMI_VALUE(bit_field3) == (1 << V8_ISSHARED_SHIFT)) {
-			/*
-			 * On versions of V8 prior to that used in 0.10,
-			 * the instance descriptors were overloaded to also
-			 * be bit_field3 -- and there was no way from that
-			 * field to infer a dictionary type.  Because we
-			 * can't determine if the map is actually the
-			 * hash_table_map, we assume that if it's an object
-			 * that has kIsShared set, that it is in fact a
-			 * dictionary -- an assumption that is assuredly in
-			 * error in some cases.
-			 */
-			propinfo |= JPI_DICT;
-			if (propinfop != NULL)
-				*propinfop = propinfo;
-			return (read_heap_dict(ptr, func, arg, propinfop));
-		}
+	rval = 0;
+	if (propinfop != NULL)
+		*propinfop = propinfo;
+
+err:
+	if (shape != NULL)
+		jsobj_shape_release(shape);
+
+	if (props != NULL)
+		mdb_free(props, nprops * sizeof (uintptr_t));
+
+	return (rval);
+}
+
+static int
+jsobj_properties(uintptr_t addr,
+    int (*func)(const char *, v8propvalue_t *, void *), void *arg,
+    jspropinfo_t *propinfop)
+{
+	return (jsobj_properties_named(addr, NULL, func, arg, propinfop));
+}
+
+/*
+ * Map shapes
+ *
+ * Everything jsobj_properties() needs to know about an object's Map is
+ * determined by the Map alone: the elements kind, whether the object uses
+ * dictionary-mode properties, and, for each property stored as a field, its
+ * name, where its value is stored, and whether that value is tagged.  Decoding
+ * that involves reading the Map's bitfields, its instance descriptors, each
+ * property's name, and its layout descriptor, which is far more work than
+ * reading the property values themselves.  Since objects of the same "class"
+ * share a Map, we decode each Map once into a jsobj_shape_t and keep it in a
+ * direct-mapped cache (jsobj_shapes) keyed by the Map's address.
+ *
+ * The cache is only used when v8_cache_enabled().  Otherwise, each call
+ * decodes the Map anew.  Callers may recursively load other shapes while a
+ * shape is in use (e.g., when printing nested objects), so shapes are
+ * reference-counted and one that's evicted while in use is freed when it's
+ * released.
+ */
+static void
+jsobj_shape_free(jsobj_shape_t *shape)
+{
+	size_t i;
+
+	for (i = 0; i < shape->js_nprops; i++) {
+		mdb_free(shape->js_props[i].jsp_name,
+		    strlen(shape->js_props[i].jsp_name) + 1);
 	}
 
-	if (read_heap_array(ptr, &props, &nprops, UM_SLEEP) != 0)
-		goto err;
+	if (shape->js_props != NULL) {
+		mdb_free(shape->js_props,
+		    shape->js_ndescs * sizeof (jsobj_shapeprop_t));
+	}
+
+	mdb_free(shape, sizeof (*shape));
+}
+
+static void
+jsobj_shape_release(jsobj_shape_t *shape)
+{
+	assert(shape->js_refcnt > 0);
+	if (--shape->js_refcnt == 0 && !shape->js_cached)
+		jsobj_shape_free(shape);
+}
+
+static void
+jsobj_shape_clear(void)
+{
+	jsobj_shape_t *shape;
+	size_t i;
+
+	for (i = 0; i < JSOBJ_NSHAPES; i++) {
+		if ((shape = jsobj_shapes[i]) == NULL)
+			continue;
+
+		jsobj_shapes[i] = NULL;
+		shape->js_cached = B_FALSE;
+		if (shape->js_refcnt == 0)
+			jsobj_shape_free(shape);
+	}
+}
+
+/*
+ * Reads the Map's bit_field3, which is an SMI in versions of V8 prior to that
+ * in Node 0.12 and a raw uint32_t after that.  See autoconfigure().
+ */
+static int
+jsobj_shape_bitfield3(uintptr_t map, uintptr_t *valp)
+{
+	unsigned int bf3_value;
+
+	if (!V8_MAP_BIT_FIELD3_ISSMI) {
+		if (mdb_vread(&bf3_value, sizeof (bf3_value),
+		    map + V8_OFF_MAP_BIT_FIELD3) == -1)
+			return (-1);
+		*valp = (uintptr_t)bf3_value;
+		return (0);
+	}
+
+	/* The metadata indicates this is an SMI. */
+	if (mdb_vread(valp, sizeof (*valp), map + V8_OFF_MAP_BIT_FIELD3) == -1)
+		return (-1);
+
+	*valp = V8_SMI_VALUE(*valp);
+	return (0);
+}
+
+/*
+ * Decodes the instance descriptors of "map" into "shape".  See the comment
+ * above jsobj_properties() for how these are laid out.
+ */
+static int
+jsobj_shape_decode(jsobj_shape_t *shape, uintptr_t map)
+{
+	uintptr_t ptr, *descs = NULL, *content = NULL, *trans;
+	size_t size, ndescs, ncontent, ntrans;
+	ssize_t ii, rndescs;
+	uint8_t ninprops, sizewords;
+	int rval = -1;
+	size_t ps = sizeof (uintptr_t);
+	jsobj_layout_t layout;
+	jsobj_shapeprop_t *jsp;
 
 	/*
 	 * Check if we're looking at an older version of V8, where the instance
@@ -2676,23 +3346,22 @@ jsobj_properties(uintptr_t addr,
 			mdb_warn("missing instance_descriptors, but did "
 			    "not find expected transitions array metadata; "
 			    "cannot read properties\n");
-			goto err;
+			return (-1);
 		}
 
-		propinfo |= JPI_HASTRANSITIONS;
-		off = V8_OFF_MAP_TRANSITIONS;
-		if (mdb_vread(&ptr, ps, map + off) == -1)
-			goto err;
+		shape->js_propinfo |= JPI_HASTRANSITIONS;
+		if (mdb_vread(&ptr, ps, map + V8_OFF_MAP_TRANSITIONS) == -1)
+			return (-1);
 
 		if (read_heap_array(ptr, &trans, &ntrans, UM_SLEEP) != 0)
-			goto err;
+			return (-1);
 
 		ptr = trans[V8_TRANSITIONS_IDX_DESC];
 		mdb_free(trans, ntrans * sizeof (uintptr_t));
 	} else {
-		off = V8_OFF_MAP_INSTANCE_DESCRIPTORS;
-		if (mdb_vread(&ptr, ps, map + off) == -1)
-			goto err;
+		if (mdb_vread(&ptr, ps,
+		    map + V8_OFF_MAP_INSTANCE_DESCRIPTORS) == -1)
+			return (-1);
 	}
 
 	/*
@@ -2700,16 +3369,18 @@ jsobj_properties(uintptr_t addr,
 	 * array.
 	 */
 	if (read_heap_array(ptr, &descs, &ndescs, UM_SLEEP) != 0)
-		goto err;
+		return (-1);
 
 	/*
 	 * For cases where property values are stored directly inside the object
 	 * ("fast properties"), we need to know the whole size of the object and
 	 * the number of properties in the object in order to calculate the
-	 * correct offset for each property.
+	 * correct offset for each property.  Both of these come from the Map.
 	 */
-	if (read_size(&size, addr) != 0)
+	if (read_heap_byte(&sizewords, map, V8_OFF_MAP_INSTANCE_SIZE) != 0)
 		size = 0;
+	else
+		size = sizewords << V8_PointerSizeLog2;
 	if (mdb_vread(&ninprops, sizeof (ninprops),
 	    map + V8_OFF_MAP_INOBJECT_PROPERTIES) == -1)
 		goto err;
@@ -2737,7 +3408,7 @@ jsobj_properties(uintptr_t addr,
 			goto err;
 
 		rndescs = ndescs - V8_PROP_IDX_FIRST;
-		propinfo |= JPI_HASCONTENT;
+		shape->js_propinfo |= JPI_HASCONTENT;
 	}
 
 	/*
@@ -2747,13 +3418,19 @@ jsobj_properties(uintptr_t addr,
 	if (jsobj_layout_load(&layout, map) == -1)
 		goto err;
 
+	if (rndescs > 0) {
+		shape->js_ndescs = rndescs;
+		shape->js_props = mdb_zalloc(
+		    rndescs * sizeof (jsobj_shapeprop_t), UM_SLEEP);
+	}
+
 	/*
 	 * At this point, we've read all the pieces we need to process the list
 	 * of instance descriptors.
 	 */
 	for (ii = 0; ii < rndescs; ii++) {
-		intptr_t keyidx, validx, detidx, baseidx, propaddr;
-		intptr_t propidx, proparrayidx = -1;
+		intptr_t keyidx, validx, detidx, baseidx;
+		intptr_t propidx;
 		char buf[1024];
 		intptr_t val;
 		size_t len = sizeof (buf);
@@ -2780,7 +3457,7 @@ jsobj_properties(uintptr_t addr,
 		 * what's here.
 		 */
 		if (detidx >= ncontent) {
-			propinfo |= JPI_SKIPPED;
+			shape->js_propinfo |= JPI_SKIPPED;
 			v8_warn("property descriptor %d: detidx (%d) "
 			    "out of bounds for content array (length %d)\n",
 			    ii, detidx, ncontent);
@@ -2797,7 +3474,7 @@ jsobj_properties(uintptr_t addr,
 		}
 
 		if (keyidx >= ndescs) {
-			propinfo |= JPI_SKIPPED;
+			shape->js_propinfo |= JPI_SKIPPED;
 			v8_warn("property descriptor %d: keyidx (%d) "
 			    "out of bounds for descriptor array (length %d)\n",
 			    ii, keyidx, ndescs);
@@ -2814,9 +3491,9 @@ jsobj_properties(uintptr_t addr,
 				 * them in case a developer wants to find them
 				 * later.
 				 */
-				propinfo |= JPI_UNDEFPROPNAME;
+				shape->js_propinfo |= JPI_UNDEFPROPNAME;
 			} else {
-				propinfo |= JPI_SKIPPED;
+				shape->js_propinfo |= JPI_SKIPPED;
 				v8_warn("property descriptor %d: could not "
 				    "print %p as a string\n", ii,
 				    descs[keyidx]);
@@ -2833,8 +3510,8 @@ jsobj_properties(uintptr_t addr,
 		 * to tell which kind of property is used, but also how to
 		 * compute the in-object address from the information available.
 		 */
-		propaddr = 0;
-		ptr = 0;
+		jsp = &shape->js_props[shape->js_nprops];
+		jsp->jsp_arrayidx = -1;
 		if (v8_major > 3 || (v8_major == 3 && v8_minor >= 26)) {
 			/*
 			 * In Node v0.12, the property's 0-based index is stored
@@ -2848,16 +3525,16 @@ jsobj_properties(uintptr_t addr,
 			propidx = V8_PROP_FIELDINDEX(content[detidx]);
 			if (propidx < ninprops) {
 				/* The property is stored inside the object. */
-				propaddr = addr + V8_OFF_HEAP(
+				jsp->jsp_inobject = B_TRUE;
+				jsp->jsp_offset = V8_OFF_HEAP(
 				    size - (ninprops - propidx) * ps);
 			} else {
 				/*
 				 * The property is stored in the "properties"
-				 * array.  This will be handled below.  The
-				 * index needs to be offset by the number of
-				 * in-object properties.
+				 * array.  The index needs to be offset by the
+				 * number of in-object properties.
 				 */
-				proparrayidx = propidx - ninprops;
+				jsp->jsp_arrayidx = propidx - ninprops;
 			}
 		} else {
 			/*
@@ -2869,9 +3546,9 @@ jsobj_properties(uintptr_t addr,
 			 */
 			val = (intptr_t)content[validx];
 			if (!V8_IS_SMI(val)) {
-				propinfo |= JPI_SKIPPED;
-				v8_warn("object %p: property descriptor %d: "
-				    "value index is not an SMI: %p\n", addr,
+				shape->js_propinfo |= JPI_SKIPPED;
+				v8_warn("map %p: property descriptor %d: "
+				    "value index is not an SMI: %p\n", map,
 				    ii, val);
 				continue;
 			}
@@ -2886,80 +3563,122 @@ jsobj_properties(uintptr_t addr,
 				 * -1 refers to the last word in the object; -2
 				 * refers to the second-last word, and so on.
 				 */
-				propaddr = addr +
+				jsp->jsp_inobject = B_TRUE;
+				jsp->jsp_offset =
 				    V8_OFF_HEAP(size + propidx * ps);
 			} else {
-				proparrayidx = propidx;
+				jsp->jsp_arrayidx = propidx;
 			}
 		}
 
-		/*
-		 * Now that we've figured out what kind of property it is and
-		 * where it's located, read the value into "ptr".
-		 */
-		if (propaddr != 0) {
-			/* This is an in-object property. */
-			if (mdb_vread(&ptr, sizeof (ptr), propaddr) == -1) {
-				propinfo |= JPI_SKIPPED;
-				v8_warn("object %p: failed to read in-object "
-				    "property at %p", addr, propaddr);
-				continue;
-			}
+		jsp->jsp_propidx = propidx;
+		jsp->jsp_untagged = jsobj_layout_untagged(&layout, propidx);
+		jsp->jsp_name = mdb_alloc(strlen(buf) + 1, UM_SLEEP);
+		(void) strcpy(jsp->jsp_name, buf);
+		shape->js_nprops++;
+	}
 
-			propinfo |= JPI_INOBJECT;
-		} else if (proparrayidx >= 0 && proparrayidx < nprops) {
-			/* Valid "properties" array property found. */
-			ptr = props[proparrayidx];
-			propinfo |= JPI_PROPS;
-		} else {
-			/*
-			 * Invalid "properties" array property found.  This can
-			 * happen when properties are deleted.  If this value
-			 * isn't obviously corrupt, we'll just silently ignore
-			 * it.
-			 */
-			if (propidx < rndescs)
-				continue;
+	rval = 0;
 
-			propinfo |= JPI_SKIPPED;
-			v8_warn("object %p: property descriptor %d: "
-			    "value index value out of bounds (%d)\n",
-			    addr, ii, nprops);
-			goto err;
-		}
+err:
+	if (descs != NULL)
+		mdb_free(descs, ndescs * sizeof (uintptr_t));
+
+	if (content != NULL && V8_PROP_IDX_CONTENT != -1)
+		mdb_free(content, ncontent * sizeof (uintptr_t));
+
+	return (rval);
+}
+
+/*
+ * Returns the decoded shape for objects whose Map is "map", reading it from
+ * the target if it's not already cached.  Returns NULL if the Map could not
+ * be decoded.  The caller must release the shape with jsobj_shape_release().
+ */
+static jsobj_shape_t *
+jsobj_shape_load(uintptr_t map)
+{
+	jsobj_shape_t *shape, **slotp;
+	uintptr_t bit_field3;
+	uint8_t bit_field2;
 
+	slotp = &jsobj_shapes[(map >> V8_PointerSizeLog2) % JSOBJ_NSHAPES];
+	if ((shape = *slotp) != NULL && shape->js_map == map) {
+		jsobj_shape_stats.v8cs_hits++;
+		shape->js_refcnt++;
+		return (shape);
+	}
+
+	shape = mdb_zalloc(sizeof (*shape), UM_SLEEP);
+	shape->js_map = map;
+	shape->js_refcnt = 1;
+
+	if (V8_ELEMENTS_KIND_SHIFT != -1 &&
+	    mdb_vread(&bit_field2, sizeof (bit_field2),
+	    map + V8_OFF_MAP_BIT_FIELD2) != -1) {
+		shape->js_haskind = B_TRUE;
+		shape->js_kind = bit_field2 >> V8_ELEMENTS_KIND_SHIFT;
+		shape->js_kind &= (1 << V8_ELEMENTS_KIND_BITCOUNT) - 1;
+	}
+
+	if (V8_DICT_SHIFT != -1) {
 		/*
-		 * If the property value doesn't look like a valid JavaScript
-		 * object, mark this object as dubious.
+		 * If dictionary properties are supported (the V8_DICT_SHIFT
+		 * offset is not -1), then bitfield 3 tells us if the properties
+		 * for this object are stored in "properties" field of the
+		 * object using a Dictionary representation.
 		 */
-		untagged = jsobj_layout_untagged(&layout, propidx);
-		if (!untagged && jsobj_maybe_garbage(ptr))
-			propinfo |= JPI_BADPROPS;
-		if (untagged) {
-			jsobj_propvalue_double(&value, makedouble(ptr));
-		} else {
-			jsobj_propvalue_addr(&value, ptr);
-		}
+		if (jsobj_shape_bitfield3(map, &bit_field3) != 0)
+			goto err;
 
-		if (func(buf, &value, arg) != 0)
+		shape->js_dict = (bit_field3 & (1 << V8_DICT_SHIFT)) != 0;
+	} else if (V8_OFF_MAP_INSTANCE_DESCRIPTORS != -1) {
+		if (mdb_vread(&bit_field3, sizeof (bit_field3),
+		    map + V8_OFF_MAP_INSTANCE_DESCRIPTORS) == -1)
 			goto err;
+
+		/*
+		 * On versions of V8 prior to that used in 0.10, the instance
+		 * descriptors were overloaded to also be bit_field3 -- and
+		 * there was no way from that field to infer a dictionary type.
+		 * Because we can't determine if the map is actually the
+		 * hash_table_map, we assume that if it's an object that has
+		 * kIsShared set, that it is in fact a dictionary -- an
+		 * assumption that is assuredly in error in some cases.
+		 */
+		shape->js_dict =
+		    V8_SMI_VALUE(bit_field3) == (1 << V8_ISSHARED_SHIFT);
 	}
 
-	rval = 0;
-	if (propinfop != NULL)
-		*propinfop = propinfo;
+	/*
+	 * If the instance descriptors can't be decoded, none of the named
+	 * properties can be found, but the elements may still be readable, so
+	 * keep the shape and flag the properties as skipped.
+	 */
+	if (!shape->js_dict && jsobj_shape_decode(shape, map) != 0) {
+		shape->js_propinfo |= JPI_SKIPPED;
+		v8_warn("map %p: failed to decode instance descriptors\n",
+		    map);
+	}
 
-err:
-	if (props != NULL)
-		mdb_free(props, nprops * sizeof (uintptr_t));
+	jsobj_shape_stats.v8cs_misses++;
+	if (!v8_cache_enabled())
+		return (shape);
 
-	if (descs != NULL)
-		mdb_free(descs, ndescs * sizeof (uintptr_t));
+	if (*slotp != NULL) {
+		jsobj_shape_stats.v8cs_evictions++;
+		(*slotp)->js_cached = B_FALSE;
+		if ((*slotp)->js_refcnt == 0)
+			jsobj_shape_free(*slotp);
+	}
 
-	if (content != NULL && V8_PROP_IDX_CONTENT != -1)
-		mdb_free(content, ncontent * sizeof (uintptr_t));
+	shape->js_cached = B_TRUE;
+	*slotp = shape;
+	return (shape);
 
-	return (rval);
+err:
+	jsobj_shape_free(shape);
+	return (NULL);
 }
 
 /*
@@ -3070,10 +3789,6 @@ err:
 static int
 jsobj_layout_load(jsobj_layout_t *layoutp, uintptr_t map)
 {
-#ifdef _LP64
-	ssize_t off;
-#endif
-
 	bzero(layoutp, sizeof (*layoutp));
 
 #ifdef _LP64
@@ -3103,25 +3818,14 @@ jsobj_layout_load(jsobj_layout_t *layoutp, uintptr_t map)
 	 * we don't have a lot of sample cases with which to test a more
 	 * complete implementation.  If this becomes more widely used in V8, we
 	 * should first-class this data structure so that we have crisper
-	 * interfaces for working with it.
+	 * interfaces for working with it.  The offset of the data is computed
+	 * when we configure.
 	 */
-	if (heap_offset("FixedTypedArrayBase", "base_pointer", &off) == -1) {
+	if (V8_OFF_FIXEDTYPEDARRAY_DATA == -1) {
 		v8_warn("large-style layout descriptor: failed to configure\n");
 		return (-1);
 	}
 
-	/*
-	 * On V8 prior to 4.6.85.23, the data for a FixedTypedArray starts at
-	 * the first double-aligned address after the base pointer.  With that
-	 * V8 version (and possibly earlier), there's an extra pointer-sized
-	 * value that we need to skip.
-	 */
-	off += sizeof (uintptr_t);
-	if (!v8_version_current_older(4, 6, 85, 23))
-		off += sizeof (uintptr_t);
-	off += (sizeof (double) - 1);
-	off &= ~(sizeof (double) - 1);
-
 	if (read_heap_smi(&layoutp->jl_length, layoutp->jl_descriptor,
 	    V8_OFF_FIXEDARRAY_LENGTH) != 0) {
 		v8_warn("large-style layout descriptor: "
@@ -3137,7 +3841,8 @@ jsobj_layout_load(jsobj_layout_t *layoutp, uintptr_t map)
 
 	if (mdb_vread(layoutp->jl_bitvecs,
 	    layoutp->jl_length * sizeof (uint32_t),
-	    V8_OFF_HEAP(layoutp->jl_descriptor + off)) == -1) {
+	    V8_OFF_HEAP(layoutp->jl_descriptor +
+	    V8_OFF_FIXEDTYPEDARRAY_DATA)) == -1) {
 		v8_warn("large-style layout descriptor: failed to read array");
 		return (-1);
 	}
@@ -3202,8 +3907,7 @@ static int
 jsfunc_lineno(uintptr_t lendsp, uintptr_t tokpos,
     char *buf, size_t buflen, int *lineno)
 {
-	uintptr_t size, bufsz, lower, upper, ii = 0;
-	uintptr_t *data;
+	int line;
 
 	if (lineno != NULL)
 		*lineno = -1;
@@ -3228,62 +3932,19 @@ jsfunc_lineno(uintptr_t lendsp, uintptr_t tokpos,
 		return (0);
 	}
 
-	if (read_heap_smi(&size, lendsp, V8_OFF_FIXEDARRAY_LENGTH) != 0)
-		return (-1);
-
-	bufsz = size * sizeof (data[0]);
-
-	if ((data = mdb_alloc(bufsz, UM_NOSLEEP)) == NULL) {
-		v8_warn("failed to alloc %d bytes for FixedArray data", bufsz);
-		return (-1);
-	}
-
-	if (mdb_vread(data, bufsz, lendsp + V8_OFF_FIXEDARRAY_DATA) != bufsz) {
-		v8_warn("failed to read FixedArray data");
-		mdb_free(data, bufsz);
+	if (v8lineends_lineno(lendsp, tokpos, &line) != 0)
 		return (-1);
-	}
-
-	lower = 0;
-	upper = size - 1;
 
-	if (tokpos > data[upper]) {
+	if (line == 0)
 		(void) strlcpy(buf, "position out of range", buflen);
-		mdb_free(data, bufsz);
-
-		if (lineno != NULL)
-			*lineno = 0;
-
-		return (0);
-	}
+	else
+		(void) mdb_snprintf(buf, buflen, "line %d", line);
 
-	if (tokpos <= data[0]) {
-		(void) strlcpy(buf, "line 1", buflen);
-		mdb_free(data, bufsz);
+	if (lineno != NULL)
+		*lineno = line;
 
-		if (lineno != NULL)
-			*lineno = 1;
-
-		return (0);
-	}
-
-	while (upper >= 1) {
-		ii = (lower + upper) >> 1;
-		if (tokpos > data[ii])
-			lower = ii + 1;
-		else if (tokpos <= data[ii - 1])
-			upper = ii - 1;
-		else
-			break;
-	}
-
-	if (lineno != NULL)
-		*lineno = ii + 1;
-
-	(void) mdb_snprintf(buf, buflen, "line %d", ii + 1);
-	mdb_free(data, bufsz);
-	return (0);
-}
+	return (0);
+}
 
 /*
  * Given a Script object, prints nlines on either side of lineno, with each
@@ -3483,8 +4144,23 @@ jsobj_print_value(v8propvalue_t *valp, jsobj_print_t *jsop)
 
 	if (V8_TYPE_STRING(type)) {
 		size_t omax, maxstrlen;
+		uintptr_t slen;
 		int rv;
 
+		/*
+		 * When streaming, make sure there's room for the whole string,
+		 * which may be longer than the buffer itself.  Only the length
+		 * is needed for this, so we read just that field rather than
+		 * loading the string, which jsstr_print_flags() does below.
+		 */
+		if (jsop->jsop_sink != NULL && jsop->jsop_maxstrlen != 0) {
+			jsobj_sink_reserve(jsop, jsop->jsop_maxstrlen);
+		} else if (jsop->jsop_sink != NULL && read_heap_smi(&slen,
+		    addr, V8_OFF_STRING_LENGTH) == 0) {
+			jsobj_sink_reserve(jsop, (jsop->jsop_utf8 ? 3 : 1) *
+			    slen + sizeof ("\"\""));
+		}
+
 		/*
 		 * The undocumented -N option to ::jsprint puts an artificial
 		 * limit on the length of strings printed out.  We implement
@@ -3503,7 +4179,9 @@ jsobj_print_value(v8propvalue_t *valp, jsobj_print_t *jsop)
 		}
 
 		omax = maxstrlen;
-		rv = jsstr_print(addr, JSSTR_QUOTED, bufp, &maxstrlen);
+		rv = jsstr_print_flags(addr, jsop->jsop_utf8 ?
+		    MSF_ASCIIONLY | MSF_UTF8 : MSF_ASCIIONLY, JSSTR_QUOTED,
+		    bufp, &maxstrlen);
 		assert(maxstrlen <= omax);
 		*lenp -= omax - maxstrlen;
 		return (rv);
@@ -3530,6 +4208,173 @@ jsobj_print_value(v8propvalue_t *valp, jsobj_print_t *jsop)
 	return (-1);
 }
 
+/*
+ * The output of ::jsprint can be arbitrarily large, since it may describe a
+ * whole graph of objects.  Rather than rendering it all into one buffer (and
+ * starting over with a larger one if it doesn't fit), ::jsprint renders into a
+ * jsobj_sink_t, whose buffer is written out as the printers make progress.
+ * Before each object property and array element, the printers ask for enough
+ * space to print it with jsobj_sink_reserve(), which flushes the buffer if it's
+ * more than half full.  Strings are the only values whose size isn't bounded
+ * by the time we get to the next property or element, so the string printer
+ * reserves room for the whole string, growing the buffer if it must.  This way
+ * each object is visited once, and the memory used is bounded by the size of
+ * the buffer or the longest string printed, whichever is larger.
+ *
+ * Other consumers of jsobj_print() (which render small values into buffers of
+ * their own) don't use a sink, in which case this does nothing.
+ */
+static void
+jsobj_sink_init(jsobj_sink_t *sink, jsobj_print_t *jsop, char *buf,
+    size_t bufsz)
+{
+	sink->jss_fp = NULL;
+	sink->jss_buf = buf;
+	sink->jss_bufsz = bufsz;
+	sink->jss_nflushed = 0;
+	sink->jss_lastc = '\0';
+	sink->jss_bufp = buf;
+	sink->jss_len = bufsz;
+	buf[0] = '\0';
+
+	jsop->jsop_sink = sink;
+	jsop->jsop_bufp = &sink->jss_bufp;
+	jsop->jsop_lenp = &sink->jss_len;
+}
+
+static void
+jsobj_sink_rewind(jsobj_sink_t *sink)
+{
+	sink->jss_bufp = sink->jss_buf;
+	sink->jss_len = sink->jss_bufsz;
+	sink->jss_buf[0] = '\0';
+}
+
+static void
+jsobj_sink_flush(jsobj_sink_t *sink)
+{
+	size_t nbytes = strlen(sink->jss_buf);
+
+	if (nbytes > 0) {
+		if (sink->jss_fp != NULL)
+			(void) fputs(sink->jss_buf, sink->jss_fp);
+		else
+			mdb_printf("%s", sink->jss_buf);
+		sink->jss_nflushed += nbytes;
+		sink->jss_lastc = sink->jss_buf[nbytes - 1];
+	}
+
+	jsobj_sink_rewind(sink);
+}
+
+static void
+jsobj_sink_reserve(jsobj_print_t *jsop, size_t nbytes)
+{
+	jsobj_sink_t *sink = jsop->jsop_sink;
+	size_t bufsz;
+
+	if (sink == NULL)
+		return;
+
+	if (sink->jss_len > MAX(nbytes, sink->jss_bufsz / 2))
+		return;
+
+	jsobj_sink_flush(sink);
+	if (sink->jss_bufsz > nbytes)
+		return;
+
+	for (bufsz = sink->jss_bufsz; bufsz <= nbytes; bufsz <<= 1)
+		continue;
+
+	mdb_free(sink->jss_buf, sink->jss_bufsz);
+	sink->jss_buf = mdb_alloc(bufsz, UM_SLEEP);
+	sink->jss_bufsz = bufsz;
+	jsobj_sink_rewind(sink);
+}
+
+/*
+ * With a large depth, ::jsprint could reach the same object many times: once
+ * for each path to it, and over and over again if it's part of a cycle.
+ * Rather than print it each time, ::jsprint records each object it prints in
+ * a tree (jsop_visited) and prints a reference to the object's address for
+ * any object it has already printed: "[Circular <addr>]" if the object is one
+ * that we're still in the middle of printing, and "[Shared <addr>]" if it's
+ * been printed elsewhere.  (The addresses correspond to those printed with
+ * "::jsprint -a".)  This bounds the output, and the work done to produce it,
+ * by the number of distinct objects reachable within the requested depth.
+ *
+ * jsobj_print_visit() is called before printing the contents of an object or
+ * array.  If the object has been visited already, it prints the reference and
+ * returns B_TRUE.  Otherwise, it records the object, stores a pointer to the
+ * record in "*jsvp" (which the caller passes to jsobj_print_leave() when it's
+ * done printing the object), and returns B_FALSE.  Consumers of jsobj_print()
+ * other than ::jsprint don't keep a tree of visited objects.
+ */
+static int
+jsobj_visited_cmp(const void *l, const void *r)
+{
+	const jsobj_visited_t *lhs = l, *rhs = r;
+
+	if (lhs->jsv_addr < rhs->jsv_addr)
+		return (-1);
+
+	if (lhs->jsv_addr > rhs->jsv_addr)
+		return (1);
+
+	return (0);
+}
+
+static boolean_t
+jsobj_print_visit(uintptr_t addr, jsobj_print_t *jsop, jsobj_visited_t **jsvp)
+{
+	jsobj_visited_t search, *jsv;
+	avl_index_t where;
+
+	*jsvp = NULL;
+	if (jsop->jsop_visited == NULL)
+		return (B_FALSE);
+
+	search.jsv_addr = addr;
+	if ((jsv = avl_find(jsop->jsop_visited, &search, &where)) != NULL) {
+		(void) bsnprintf(jsop->jsop_bufp, jsop->jsop_lenp, "[%s %p]",
+		    jsv->jsv_onpath ? "Circular" : "Shared", addr);
+		return (B_TRUE);
+	}
+
+	jsv = mdb_alloc(sizeof (*jsv), UM_SLEEP);
+	jsv->jsv_addr = addr;
+	jsv->jsv_onpath = B_TRUE;
+	avl_insert(jsop->jsop_visited, jsv, where);
+	*jsvp = jsv;
+	return (B_FALSE);
+}
+
+static void
+jsobj_print_leave(jsobj_visited_t *jsv)
+{
+	if (jsv != NULL)
+		jsv->jsv_onpath = B_FALSE;
+}
+
+static void
+jsobj_visited_init(avl_tree_t *tree)
+{
+	avl_create(tree, jsobj_visited_cmp, sizeof (jsobj_visited_t),
+	    offsetof(jsobj_visited_t, jsv_node));
+}
+
+static void
+jsobj_visited_fini(avl_tree_t *tree)
+{
+	jsobj_visited_t *jsv;
+	void *cookie = NULL;
+
+	while ((jsv = avl_destroy_nodes(tree, &cookie)) != NULL)
+		mdb_free(jsv, sizeof (*jsv));
+
+	avl_destroy(tree);
+}
+
 static int
 jsobj_print(uintptr_t addr, jsobj_print_t *jsop)
 {
@@ -3572,6 +4417,7 @@ jsobj_print_prop(const char *desc, v8propvalue_t *val, void *arg)
 	char **bufp = jsop->jsop_bufp;
 	size_t *lenp = jsop->jsop_lenp;
 
+	jsobj_sink_reserve(jsop, strlen(desc) + jsop->jsop_indent + 16);
 	(void) bsnprintf(bufp, lenp, "%s\n%*s\"%s\": ", jsop->jsop_nprops == 0 ?
 	    "{" : "", jsop->jsop_indent + 4, "", desc);
 
@@ -3631,20 +4477,42 @@ jsobj_print_jsobject(uintptr_t addr, jsobj_print_t *jsop)
 {
 	char **bufp = jsop->jsop_bufp;
 	size_t *lenp = jsop->jsop_lenp;
+	const char *member = jsop->jsop_member;
+	char name[512];
+	size_t namelen;
+	jsobj_visited_t *jsv;
+	int rv;
 
-	if (jsop->jsop_member != NULL)
-		return (jsobj_properties(addr, jsobj_print_prop_member,
-		    jsop, &jsop->jsop_propinfo));
+	if (member != NULL) {
+		/*
+		 * We only need the property named by the first component of
+		 * the member path.  (If that's an array index, we let
+		 * jsobj_print_prop_member() report the error.)
+		 */
+		namelen = strcspn(member, ".[");
+		if (namelen == 0 || namelen >= sizeof (name))
+			return (jsobj_properties(addr, jsobj_print_prop_member,
+			    jsop, &jsop->jsop_propinfo));
+
+		(void) strlcpy(name, member, namelen + 1);
+		return (jsobj_properties_named(addr, name,
+		    jsobj_print_prop_member, jsop, &jsop->jsop_propinfo));
+	}
 
 	if (jsop->jsop_depth == 0) {
 		(void) bsnprintf(bufp, lenp, "[...]");
 		return (0);
 	}
 
+	if (jsobj_print_visit(addr, jsop, &jsv))
+		return (0);
+
 	jsop->jsop_nprops = 0;
 
-	if (jsobj_properties(addr, jsobj_print_prop, jsop,
-	    &jsop->jsop_propinfo) != 0)
+	rv = jsobj_properties(addr, jsobj_print_prop, jsop,
+	    &jsop->jsop_propinfo);
+	jsobj_print_leave(jsv);
+	if (rv != 0)
 		return (-1);
 
 	if (jsop->jsop_nprops > 0) {
@@ -3754,6 +4622,7 @@ jsobj_print_jsarray_one(v8array_t *ap, unsigned int index,
 	char **bufp = jsop->jsop_bufp;
 	size_t *lenp = jsop->jsop_lenp;
 
+	jsobj_sink_reserve(jsop, jsop->jsop_indent + 16);
 	if (v8array_length(ap) == 1) {
 		(void) jsobj_print(value, jsop);
 	} else {
@@ -3776,6 +4645,7 @@ jsobj_print_jsarray(uintptr_t addr, jsobj_print_t *jsop)
 	size_t *lenp = jsop->jsop_lenp;
 	int indent = jsop->jsop_indent;
 	jsobj_print_t descend;
+	jsobj_visited_t *jsv;
 	size_t len;
 	v8array_t *ap;
 
@@ -3799,6 +4669,11 @@ jsobj_print_jsarray(uintptr_t addr, jsobj_print_t *jsop)
 		return (0);
 	}
 
+	if (jsobj_print_visit(addr, jsop, &jsv)) {
+		v8array_free(ap);
+		return (0);
+	}
+
 	descend = *jsop;
 	descend.jsop_depth--;
 	descend.jsop_indent += 4;
@@ -3808,14 +4683,15 @@ jsobj_print_jsarray(uintptr_t addr, jsobj_print_t *jsop)
 		(void) v8array_iter_elements(ap, jsobj_print_jsarray_one,
 		    &descend);
 		(void) bsnprintf(bufp, lenp, " ]");
-		v8array_free(ap);
-		return (0);
+	} else {
+		(void) bsnprintf(bufp, lenp, "[\n");
+		(void) v8array_iter_elements(ap, jsobj_print_jsarray_one,
+		    &descend);
+		(void) bsnprintf(bufp, lenp, "%*s", indent, "");
+		(void) bsnprintf(bufp, lenp, "]");
 	}
 
-	(void) bsnprintf(bufp, lenp, "[\n");
-	(void) v8array_iter_elements(ap, jsobj_print_jsarray_one, &descend);
-	(void) bsnprintf(bufp, lenp, "%*s", indent, "");
-	(void) bsnprintf(bufp, lenp, "]");
+	jsobj_print_leave(jsv);
 	v8array_free(ap);
 	return (0);
 }
@@ -4172,10 +5048,7 @@ dcmd_v8print(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 		rqclass = argv[0].a_un.a_str;
 	}
 
-	for (clp = v8_classes; clp != NULL; clp = clp->v8c_next) {
-		if (strcmp(rqclass, clp->v8c_name) == 0)
-			break;
-	}
+	clp = conf_class_lookup(rqclass);
 
 	if (clp == NULL) {
 		v8_warn("unknown class '%s'\n", rqclass);
@@ -4358,6 +5231,130 @@ load_current_context(uintptr_t *fpp, uintptr_t *raddrp)
 	return (0);
 }
 
+/*
+ * Describes the function for a JavaScript stack frame.  See jsframe_sym_load().
+ */
+typedef struct jsframe_sym {
+	uintptr_t	jfs_funcinfo;		/* SharedFunctionInfo address */
+	boolean_t	jfs_locloaded;		/* location fields are valid */
+	boolean_t	jfs_havefile;		/* jfs_file is valid */
+	boolean_t	jfs_haveposn;		/* jfs_posn is valid */
+	uintptr_t	jfs_tokpos;		/* token position (SMI) */
+	uintptr_t	jfs_script;		/* Script address */
+	int		jfs_lineno;		/* line number, or 0 */
+	char		jfs_funcname[256];	/* function name */
+	char		jfs_file[256];		/* script name */
+	char		jfs_posn[64];		/* description of location */
+} jsframe_sym_t;
+
+#define	JSFRAME_NSYMS	1024
+
+static jsframe_sym_t *jsframe_syms[JSFRAME_NSYMS];
+static v8cache_stats_t jsframe_sym_stats;
+
+/*
+ * Printing a stack frame involves reading the frame's JSFunction, its
+ * SharedFunctionInfo, the function's name, its Script, the script's name, and
+ * the function's position within the script, and then mapping that position to
+ * a line number.  Deep stacks commonly contain the same functions many times
+ * (e.g., recursion, or the same middleware for each request), so when
+ * v8_cache_enabled(), we keep what we find in a direct-mapped cache
+ * (jsframe_syms) keyed by the SharedFunctionInfo's address.  Otherwise, the
+ * caller's "scratch" entry is filled in instead.
+ *
+ * The location fields are only needed for verbose output and for folded
+ * stacks, so they're filled in separately by jsframe_sym_location().
+ */
+static jsframe_sym_t *
+jsframe_sym_load(uintptr_t funcinfop, jsframe_sym_t *scratch)
+{
+	jsframe_sym_t *symp, **slotp;
+	char *bufp;
+	size_t len;
+
+	slotp = NULL;
+	if (v8_cache_enabled()) {
+		slotp = &jsframe_syms[(funcinfop >> 3) % JSFRAME_NSYMS];
+		if (*slotp != NULL && (*slotp)->jfs_funcinfo == funcinfop) {
+			jsframe_sym_stats.v8cs_hits++;
+			return (*slotp);
+		}
+	}
+
+	bzero(scratch, sizeof (*scratch));
+	scratch->jfs_funcinfo = funcinfop;
+	bufp = scratch->jfs_funcname;
+	len = sizeof (scratch->jfs_funcname);
+	if (jsfunc_name(funcinfop, &bufp, &len) != 0)
+		return (NULL);
+
+	if (slotp == NULL)
+		return (scratch);
+
+	jsframe_sym_stats.v8cs_misses++;
+	if ((symp = *slotp) == NULL) {
+		symp = mdb_alloc(sizeof (*symp), UM_SLEEP);
+		*slotp = symp;
+	} else {
+		jsframe_sym_stats.v8cs_evictions++;
+	}
+
+	bcopy(scratch, symp, sizeof (*symp));
+	return (symp);
+}
+
+static void
+jsframe_sym_location(jsframe_sym_t *symp)
+{
+	uintptr_t ptrp, lendsp;
+	char *bufp;
+	size_t len;
+
+	if (symp->jfs_locloaded)
+		return;
+
+	symp->jfs_locloaded = B_TRUE;
+
+	/*
+	 * Although the token position is technically an SMI, we're going to
+	 * byte-compare it to other SMI values so we don't want decode it here.
+	 */
+	if (read_heap_maybesmi(&symp->jfs_tokpos, symp->jfs_funcinfo,
+	    V8_OFF_SHAREDFUNCTIONINFO_FUNCTION_TOKEN_POSITION) != 0 ||
+	    read_heap_ptr(&symp->jfs_script, symp->jfs_funcinfo,
+	    V8_OFF_SHAREDFUNCTIONINFO_SCRIPT) != 0 ||
+	    read_heap_ptr(&ptrp, symp->jfs_script, V8_OFF_SCRIPT_NAME) != 0)
+		return;
+
+	symp->jfs_tokpos = V8_VALUE_SMI(symp->jfs_tokpos);
+	symp->jfs_havefile = B_TRUE;
+	bufp = symp->jfs_file;
+	len = sizeof (symp->jfs_file);
+	(void) jsstr_print(ptrp, JSSTR_NUDE, &bufp, &len);
+
+	if (read_heap_ptr(&lendsp, symp->jfs_script,
+	    V8_OFF_SCRIPT_LINE_ENDS) != 0)
+		return;
+
+	symp->jfs_haveposn = B_TRUE;
+	(void) jsfunc_lineno(lendsp, symp->jfs_tokpos, symp->jfs_posn,
+	    sizeof (symp->jfs_posn), &symp->jfs_lineno);
+}
+
+static void
+jsframe_sym_clear(void)
+{
+	size_t i;
+
+	for (i = 0; i < JSFRAME_NSYMS; i++) {
+		if (jsframe_syms[i] == NULL)
+			continue;
+
+		mdb_free(jsframe_syms[i], sizeof (jsframe_sym_t));
+		jsframe_syms[i] = NULL;
+	}
+}
+
 typedef struct jsframe {
 	boolean_t	jsf_showall;	/* show hidden frames and pointers */
 	boolean_t	jsf_verbose;	/* show arguments and JS code */
@@ -4365,6 +5362,11 @@ typedef struct jsframe {
 	char		*jsf_prop;	/* filter arguments */
 	uintptr_t	jsf_nlines;	/* lines of context (for verbose) */
 	uint_t		jsf_nskipped;	/* skipped frames */
+	boolean_t	jsf_folded;	/* collect frames for folded output */
+	char		**jsf_frames;	/* collected frames, innermost first */
+	size_t		jsf_nframes;	/* number of collected frames */
+	size_t		jsf_maxframes;	/* allocated size of jsf_frames */
+	mdbv8_jsonl_t	*jsf_jsonl;	/* writer for JSON output */
 } jsframe_t;
 
 static void
@@ -4384,6 +5386,95 @@ jsframe_print_skipped(jsframe_t *jsf)
 	jsf->jsf_nskipped = 0;
 }
 
+/*
+ * In folded mode (see ::jsstack -F), frames are collected rather than printed
+ * so that the whole stack can be emitted on one line, outermost frame first,
+ * with frames separated by semicolons.  This is the format consumed by flame
+ * graph tools, so semicolons within frame names are replaced.
+ */
+static void
+jsframe_fold(jsframe_t *jsf, const char *frame)
+{
+	char **frames, *p;
+	size_t len;
+
+	if (jsf->jsf_nframes == jsf->jsf_maxframes) {
+		len = jsf->jsf_maxframes == 0 ? 32 : jsf->jsf_maxframes * 2;
+		frames = mdb_alloc(len * sizeof (char *), UM_SLEEP | UM_GC);
+		if (jsf->jsf_nframes != 0) {
+			bcopy(jsf->jsf_frames, frames,
+			    jsf->jsf_nframes * sizeof (char *));
+		}
+		jsf->jsf_frames = frames;
+		jsf->jsf_maxframes = len;
+	}
+
+	len = strlen(frame) + 1;
+	p = mdb_alloc(len, UM_SLEEP | UM_GC);
+	bcopy(frame, p, len);
+	jsf->jsf_frames[jsf->jsf_nframes++] = p;
+
+	while ((p = strchr(p, ';')) != NULL)
+		*p = ':';
+}
+
+static void
+jsframe_fold_native(jsframe_t *jsf, uintptr_t raddr)
+{
+	char buf[256], *p;
+
+	/*
+	 * Identical stacks should fold together even if they're stopped at
+	 * different instructions, so we leave off the offset.
+	 */
+	(void) mdb_snprintf(buf, sizeof (buf), "%a", raddr);
+	if ((p = strrchr(buf, '+')) != NULL && strncmp(p, "+0x", 3) == 0)
+		*p = '\0';
+
+	jsframe_fold(jsf, buf);
+}
+
+static void
+jsframe_fold_function(jsframe_t *jsf, jsframe_sym_t *symp)
+{
+	char frame[sizeof (symp->jfs_funcname) + sizeof (symp->jfs_file) + 32];
+
+	jsframe_sym_location(symp);
+	if (symp->jfs_haveposn && symp->jfs_lineno > 0) {
+		(void) mdb_snprintf(frame, sizeof (frame), "%s (%s:%d)",
+		    symp->jfs_funcname, symp->jfs_file, symp->jfs_lineno);
+	} else if (symp->jfs_havefile && symp->jfs_file[0] != '\0') {
+		(void) mdb_snprintf(frame, sizeof (frame), "%s (%s)",
+		    symp->jfs_funcname, symp->jfs_file);
+	} else {
+		(void) mdb_snprintf(frame, sizeof (frame), "%s",
+		    symp->jfs_funcname);
+	}
+
+	jsframe_fold(jsf, frame);
+}
+
+/*
+ * Emit the collected stack as a single line with a count of 1, so that output
+ * from many threads or targets can be aggregated by summing the counts of
+ * identical lines.
+ */
+static void
+jsframe_fold_print(jsframe_t *jsf)
+{
+	size_t i;
+
+	if (jsf->jsf_nframes == 0)
+		return;
+
+	for (i = jsf->jsf_nframes; i > 0; i--) {
+		mdb_printf("%s%s", jsf->jsf_frames[i - 1],
+		    i > 1 ? ";" : " 1\n");
+	}
+
+	jsf->jsf_nframes = 0;
+}
+
 static int
 do_jsframe_special(uintptr_t fptr, uintptr_t raddr, jsframe_t *jsf)
 {
@@ -4404,6 +5495,24 @@ do_jsframe_special(uintptr_t fptr, uintptr_t raddr, jsframe_t *jsf)
 		if (prop != NULL)
 			return (0);
 
+		if (jsf->jsf_folded) {
+			jsframe_fold_native(jsf, raddr);
+			return (0);
+		}
+
+		if (jsf->jsf_jsonl != NULL) {
+			char buf[256];
+
+			(void) mdb_snprintf(buf, sizeof (buf), "%a", raddr);
+			mdbv8_jsonl_begin(jsf->jsf_jsonl);
+			mdbv8_jsonl_string(jsf->jsf_jsonl, "kind", "native");
+			mdbv8_jsonl_addr(jsf->jsf_jsonl, "frame", fptr);
+			mdbv8_jsonl_addr(jsf->jsf_jsonl, "pc", raddr);
+			mdbv8_jsonl_string(jsf->jsf_jsonl, "symbol", buf);
+			mdbv8_jsonl_end(jsf->jsf_jsonl);
+			return (0);
+		}
+
 		jsframe_print_skipped(jsf);
 		if (jsf->jsf_showall) {
 			mdb_printf("%p %a\n", fptr, raddr);
@@ -4480,14 +5589,14 @@ do_jsframe(uintptr_t fptr, uintptr_t raddr, jsframe_t *jsf)
 	const char *prop = jsf->jsf_prop;
 	uintptr_t nlines = jsf->jsf_nlines;
 
-	uintptr_t funcp, funcinfop, tokpos, endpos, scriptp, lendsp, ptrp;
+	uintptr_t funcp, funcinfop, endpos;
 	uintptr_t ii, nargs;
 	const char *typename;
 	char *bufp;
 	size_t len;
 	uint8_t type;
 	char buf[256];
-	int lineno;
+	jsframe_sym_t sym, *symp;
 
 	/*
 	 * Check for non-JavaScript frames first.
@@ -4555,13 +5664,34 @@ do_jsframe(uintptr_t fptr, uintptr_t raddr, jsframe_t *jsf)
 	if (read_heap_ptr(&funcinfop, funcp, V8_OFF_JSFUNCTION_SHARED) != 0)
 		return (DCMD_ERR);
 
-	bufp = buf;
-	len = sizeof (buf);
-	if (jsfunc_name(funcinfop, &bufp, &len) != 0)
+	if ((symp = jsframe_sym_load(funcinfop, &sym)) == NULL)
 		return (DCMD_ERR);
 
-	if (func != NULL && strcmp(buf, func) != 0)
+	if (func != NULL && strcmp(symp->jfs_funcname, func) != 0)
+		return (DCMD_OK);
+
+	if (jsf->jsf_folded) {
+		jsframe_fold_function(jsf, symp);
+		return (DCMD_OK);
+	}
+
+	if (jsf->jsf_jsonl != NULL) {
+		mdbv8_jsonl_t *jsl = jsf->jsf_jsonl;
+
+		jsframe_sym_location(symp);
+		mdbv8_jsonl_begin(jsl);
+		mdbv8_jsonl_string(jsl, "kind", "js");
+		mdbv8_jsonl_addr(jsl, "frame", fptr);
+		mdbv8_jsonl_addr(jsl, "pc", raddr);
+		mdbv8_jsonl_addr(jsl, "jsfunction", funcp);
+		mdbv8_jsonl_string(jsl, "function", symp->jfs_funcname);
+		if (symp->jfs_havefile)
+			mdbv8_jsonl_string(jsl, "script", symp->jfs_file);
+		if (symp->jfs_haveposn && symp->jfs_lineno > 0)
+			mdbv8_jsonl_uint(jsl, "line", symp->jfs_lineno);
+		mdbv8_jsonl_end(jsl);
 		return (DCMD_OK);
+	}
 
 	if (prop == NULL) {
 		jsframe_print_skipped(jsf);
@@ -4569,7 +5699,7 @@ do_jsframe(uintptr_t fptr, uintptr_t raddr, jsframe_t *jsf)
 			mdb_printf("%p %a ", fptr, raddr);
 		else
 			mdb_printf("js:     ");
-		mdb_printf("%s", buf);
+		mdb_printf("%s", symp->jfs_funcname);
 		if (showall)
 			mdb_printf(" (JSFunction: %p)\n", funcp);
 		else
@@ -4582,53 +5712,35 @@ do_jsframe(uintptr_t fptr, uintptr_t raddr, jsframe_t *jsf)
 	if (verbose)
 		jsframe_print_skipped(jsf);
 
-	/*
-	 * Although the token position is technically an SMI, we're going to
-	 * byte-compare it to other SMI values so we don't want decode it here.
-	 */
-	if (read_heap_maybesmi(&tokpos, funcinfop,
-	    V8_OFF_SHAREDFUNCTIONINFO_FUNCTION_TOKEN_POSITION) != 0)
-		return (DCMD_ERR);
-	tokpos = V8_VALUE_SMI(tokpos);
-
-	if (read_heap_ptr(&scriptp, funcinfop,
-	    V8_OFF_SHAREDFUNCTIONINFO_SCRIPT) != 0)
+	jsframe_sym_location(symp);
+	if (!symp->jfs_havefile)
 		return (DCMD_ERR);
 
-	if (read_heap_ptr(&ptrp, scriptp, V8_OFF_SCRIPT_NAME) != 0)
-		return (DCMD_ERR);
-
-	bufp = buf;
-	len = sizeof (buf);
-	(void) jsstr_print(ptrp, JSSTR_NUDE, &bufp, &len);
-
 	if (prop != NULL && strcmp(prop, "file") == 0) {
-		mdb_printf("%s\n", buf);
+		mdb_printf("%s\n", symp->jfs_file);
 		return (DCMD_OK);
 	}
 
 	if (prop == NULL) {
 		(void) mdb_inc_indent(10);
-		mdb_printf("file: %s\n", buf);
+		mdb_printf("file: %s\n", symp->jfs_file);
 	}
 
-	if (read_heap_ptr(&lendsp, scriptp, V8_OFF_SCRIPT_LINE_ENDS) != 0)
+	if (!symp->jfs_haveposn)
 		return (DCMD_ERR);
 
-	(void) jsfunc_lineno(lendsp, tokpos, buf, sizeof (buf), &lineno);
-
 	if (prop != NULL && strcmp(prop, "posn") == 0) {
-		mdb_printf("%s\n", buf);
+		mdb_printf("%s\n", symp->jfs_posn);
 		return (DCMD_OK);
 	}
 
 	if (prop == NULL)
-		mdb_printf("posn: %s\n", buf);
+		mdb_printf("posn: %s\n", symp->jfs_posn);
 
 	if (read_heap_maybesmi(&nargs, funcinfop,
 	    V8_OFF_SHAREDFUNCTIONINFO_LENGTH) == 0) {
 		uintptr_t argptr;
-		char arg[10];
+		char arg[24];	/* "arg" plus up to 20 digits */
 
 		if (mdb_vread(&argptr, sizeof (argptr),
 		    fptr + V8_OFF_FP_ARGS + nargs * sizeof (uintptr_t)) != -1 &&
@@ -4681,8 +5793,8 @@ do_jsframe(uintptr_t fptr, uintptr_t raddr, jsframe_t *jsf)
 
 	if (nlines != 0 && read_heap_maybesmi(&endpos, funcinfop,
 	    V8_OFF_SHAREDFUNCTIONINFO_END_POSITION) == 0) {
-		jsfunc_lines(scriptp,
-		    V8_SMI_VALUE(tokpos), endpos, nlines, "%5d ");
+		jsfunc_lines(symp->jfs_script,
+		    V8_SMI_VALUE(symp->jfs_tokpos), endpos, nlines, "%5d ");
 		mdb_printf("\n");
 	}
 
@@ -4720,11 +5832,27 @@ typedef struct findjsobjects_func {
 	avl_node_t fjsf_node;
 	struct findjsobjects_func *fjsf_next;
 	uintptr_t fjsf_shared;
+	uintptr_t fjsf_instr_start;
+	uintptr_t fjsf_instr_end;
+	int fjsf_lineno;
 	char fjsf_funcname[40];
 	char fjsf_scriptname[80];
 	char fjsf_location[20];
 } findjsobjects_func_t;
 
+/*
+ * Entry in the table of functions' instruction ranges, which is sorted by
+ * starting address.  "fjsc_maxend" is the greatest ending address of this entry
+ * and all of the ones before it, which lets findjsobjects_func_lookup() stop
+ * searching backwards as soon as no earlier range could contain the address.
+ */
+typedef struct findjsobjects_coderange {
+	uintptr_t fjsc_start;
+	uintptr_t fjsc_end;
+	uintptr_t fjsc_maxend;
+	findjsobjects_func_t *fjsc_func;
+} findjsobjects_coderange_t;
+
 typedef struct findjsobjects_stats {
 	int fjss_heapobjs;
 	int fjss_cached;
@@ -4764,6 +5892,9 @@ typedef struct findjsobjects_state {
 	boolean_t fjs_marking;
 	boolean_t fjs_referred;
 	boolean_t fjs_finished;
+	boolean_t fjs_indexing;
+	boolean_t fjs_indexonly;
+	boolean_t fjs_coderanges_loaded;
 	avl_tree_t fjs_tree;
 	avl_tree_t fjs_referents;
 	avl_tree_t fjs_funcinfo;
@@ -4772,6 +5903,8 @@ typedef struct findjsobjects_state {
 	findjsobjects_obj_t *fjs_current;
 	findjsobjects_obj_t *fjs_objects;
 	findjsobjects_func_t *fjs_funcs;
+	findjsobjects_coderange_t *fjs_coderanges;
+	size_t fjs_ncoderanges;
 	findjsobjects_stats_t fjs_stats;
 } findjsobjects_state_t;
 
@@ -5025,11 +6158,27 @@ findjsobjects_range(findjsobjects_state_t *fjs, uintptr_t addr, uintptr_t size)
 	int jsobject = V8_TYPE_JSOBJECT, jsarray = V8_TYPE_JSARRAY;
 	int jstypedarray = V8_TYPE_JSTYPEDARRAY;
 	int jsfunction = V8_TYPE_JSFUNCTION;
-	caddr_t range = mdb_alloc(size, UM_SLEEP);
+	caddr_t range;
 	uintptr_t base = addr, mapaddr;
+	boolean_t mapped;
 
-	if (mdb_vread(range, size, addr) == -1)
-		return (0);
+	/*
+	 * If we've mapped the core file, we can scan the range in place.
+	 * Otherwise, read in a copy.
+	 */
+	if ((range = (caddr_t)dbi_vptr(addr, size)) != NULL) {
+		mapped = B_TRUE;
+	} else {
+		mapped = B_FALSE;
+		range = mdb_alloc(size, UM_SLEEP);
+		if (mdb_vread(range, size, addr) == -1) {
+			mdb_free(range, size);
+			return (0);
+		}
+	}
+
+	if (fjs->fjs_indexing)
+		v8whatis_index_range(base, size);
 
 	for (limit = addr + size; addr < limit; addr++) {
 		findjsobjects_instance_t *inst;
@@ -5050,6 +6199,13 @@ findjsobjects_range(findjsobjects_state_t *fjs, uintptr_t addr, uintptr_t size)
 		if (!V8_IS_HEAPOBJECT(mapaddr))
 			continue;
 
+		if (fjs->fjs_indexing) {
+			v8whatis_index_add(addr, mapaddr);
+
+			if (fjs->fjs_indexonly)
+				continue;
+		}
+
 		mapaddr += V8_OFF_MAP_INSTANCE_ATTRIBUTES;
 		stats->fjss_typereads++;
 
@@ -5143,24 +6299,26 @@ findjsobjects_range(findjsobjects_state_t *fjs, uintptr_t addr, uintptr_t size)
 		obj->fjso_ninstances++;
 	}
 
-	mdb_free(range, size);
+	if (!mapped)
+		mdb_free(range, size);
 
 	return (0);
 }
 
 static int
-findjsobjects_mapping(findjsobjects_state_t *fjs, const prmap_t *pmp,
-    const char *name)
+findjsobjects_mapping(const dbi_mapping_t *dmp, void *arg)
 {
-	if (name != NULL && !(fjs->fjs_brk && (pmp->pr_mflags & MA_BREAK)))
+	findjsobjects_state_t *fjs = arg;
+
+	if (dmp->dm_name != NULL && !(fjs->fjs_brk && dmp->dm_brk))
 		return (0);
 
 	if (fjs->fjs_addr != (uintptr_t)NULL &&
-	    (fjs->fjs_addr < pmp->pr_vaddr ||
-	    fjs->fjs_addr >= pmp->pr_vaddr + pmp->pr_size))
+	    (fjs->fjs_addr < dmp->dm_vaddr ||
+	    fjs->fjs_addr >= dmp->dm_vaddr + dmp->dm_size))
 		return (0);
 
-	return (findjsobjects_range(fjs, pmp->pr_vaddr, pmp->pr_size));
+	return (findjsobjects_range(fjs, dmp->dm_vaddr, dmp->dm_size));
 }
 
 static void
@@ -5498,6 +6656,23 @@ findjsobjects_print(findjsobjects_obj_t *obj)
 	mdb_printf("\n", col);
 }
 
+static void
+findjsobjects_print_json(mdbv8_jsonl_t *jsl, findjsobjects_obj_t *obj)
+{
+	findjsobjects_prop_t *prop;
+
+	mdbv8_jsonl_begin(jsl);
+	mdbv8_jsonl_addr(jsl, "addr", obj->fjso_instances.fjsi_addr);
+	mdbv8_jsonl_uint(jsl, "count", obj->fjso_ninstances);
+	mdbv8_jsonl_uint(jsl, "nprops", obj->fjso_nprops);
+	mdbv8_jsonl_string(jsl, "constructor", obj->fjso_constructor);
+	mdbv8_jsonl_array_begin(jsl, "props");
+	for (prop = obj->fjso_props; prop != NULL; prop = prop->fjsp_next)
+		mdbv8_jsonl_string(jsl, NULL, prop->fjsp_desc);
+	mdbv8_jsonl_array_end(jsl);
+	mdbv8_jsonl_end(jsl);
+}
+
 static void
 dcmd_findjsobjects_help(void)
 {
@@ -5510,7 +6685,11 @@ dcmd_findjsobjects_help(void)
 "run, subsequent calls to ::findjsobjects use cached data.  If provided an\n"
 "address (and in the absence of -r, described below), ::findjsobjects treats\n"
 "the address as that of a representative object, and lists all instances of\n"
-"that object (that is, all objects that have a matching property signature).");
+"that object (that is, all objects that have a matching property signature).\n"
+"\n"
+"With -i, the heap scan also builds an index of the start addresses of all\n"
+"heap objects.  ::v8whatis uses this index (when present) instead of\n"
+"searching backwards through memory.");
 
 	mdb_dec_indent(2);
 	mdb_printf("%<b>OPTIONS%</b>\n");
@@ -5520,6 +6699,8 @@ dcmd_findjsobjects_help(void)
 "  -b       Include the heap denoted by the brk(2) (normally excluded)\n"
 "  -c cons  Display representative objects with the specified constructor\n"
 "  -p prop  Display representative objects that have the specified property\n"
+"  -i       Also index all heap objects to speed up ::v8whatis\n"
+"  -j       List representative objects as JSON, one object per line\n"
 "  -l       List all objects that match the representative object\n"
 "  -m       Mark specified object for later reference determination via -r\n"
 "  -r       Find references to the specified and/or marked object(s)\n"
@@ -5528,12 +6709,39 @@ dcmd_findjsobjects_help(void)
 
 static findjsobjects_state_t findjsobjects_state;
 
+/*
+ * Build the object-start index used by ::v8whatis.  This is normally done as
+ * part of the initial heap scan, but if that scan has already been completed
+ * without building the index, we make a separate pass over the heap that only
+ * builds the index.
+ */
 static int
-findjsobjects_run(findjsobjects_state_t *fjs)
+findjsobjects_index(findjsobjects_state_t *fjs)
 {
-	struct ps_prochandle *Pr;
-	findjsobjects_obj_t *obj;
+	int rv;
+
+	v8whatis_index_begin();
+	fjs->fjs_indexing = B_TRUE;
+	fjs->fjs_indexonly = B_TRUE;
+	v8_silent++;
+	rv = dbi_mapping_iter(findjsobjects_mapping, fjs);
+	v8_silent--;
+	fjs->fjs_indexing = B_FALSE;
+	fjs->fjs_indexonly = B_FALSE;
+
+	if (rv != 0)
+		return (-1);
+
+	v8whatis_index_finish();
+	return (0);
+}
+
+static int
+findjsobjects_run(findjsobjects_state_t *fjs)
+{
+	findjsobjects_obj_t *obj;
 	findjsobjects_stats_t *stats = &fjs->fjs_stats;
+	boolean_t indexing = fjs->fjs_indexing;
 
 	if (!fjs->fjs_initialized) {
 		avl_create(&fjs->fjs_tree,
@@ -5561,19 +6769,22 @@ findjsobjects_run(findjsobjects_state_t *fjs)
 		int nobjs, i;
 		hrtime_t start = gethrtime();
 
-		if (mdb_get_xdata("pshandle", &Pr, sizeof (Pr)) == -1) {
-			mdb_warn("couldn't read pshandle xdata");
-			return (-1);
-		}
-
 		v8_silent++;
 
-		if (Pmapping_iter(Pr,
-		    (proc_map_f *)findjsobjects_mapping, fjs) != 0) {
+		if (indexing)
+			v8whatis_index_begin();
+
+		if (dbi_mapping_iter(findjsobjects_mapping, fjs) != 0) {
+			fjs->fjs_indexing = B_FALSE;
 			v8_silent--;
 			return (-1);
 		}
 
+		if (indexing) {
+			v8whatis_index_finish();
+			fjs->fjs_indexing = B_FALSE;
+		}
+
 		if ((nobjs = avl_numnodes(&fjs->fjs_tree)) != 0) {
 			/*
 			 * We have the objects -- now sort them.
@@ -5618,6 +6829,21 @@ findjsobjects_run(findjsobjects_state_t *fjs)
 			    stats->fjss_funcs_unique);
 			mdb_printf(f, "functions skipped",
 			    stats->fjss_funcs_skipped);
+			mdb_printf(f, "indexed heap objects",
+			    (int)v8whatis_index_count());
+		}
+	}
+
+	if (indexing && !v8whatis_index_ready()) {
+		fjs->fjs_indexing = B_FALSE;
+
+		if (findjsobjects_index(fjs) != 0)
+			return (-1);
+
+		if (fjs->fjs_verbose) {
+			mdb_printf("findjsobjects: %30s => %d\n",
+			    "indexed heap objects",
+			    (int)v8whatis_index_count());
 		}
 	}
 
@@ -5630,7 +6856,8 @@ dcmd_findjsobjects(uintptr_t addr,
 {
 	findjsobjects_state_t *fjs = &findjsobjects_state;
 	findjsobjects_obj_t *obj;
-	boolean_t references = B_FALSE, listlike = B_FALSE;
+	boolean_t references = B_FALSE, listlike = B_FALSE, json = B_FALSE;
+	mdbv8_jsonl_t *jsl;
 	const char *propname = NULL;
 	const char *constructor = NULL;
 	const char *propkind = NULL;
@@ -5639,11 +6866,14 @@ dcmd_findjsobjects(uintptr_t addr,
 	fjs->fjs_brk = B_FALSE;
 	fjs->fjs_marking = B_FALSE;
 	fjs->fjs_allobjs = B_FALSE;
+	fjs->fjs_indexing = B_FALSE;
 
 	if (mdb_getopts(argc, argv,
 	    'a', MDB_OPT_SETBITS, B_TRUE, &fjs->fjs_allobjs,
 	    'b', MDB_OPT_SETBITS, B_TRUE, &fjs->fjs_brk,
 	    'c', MDB_OPT_STR, &constructor,
+	    'i', MDB_OPT_SETBITS, B_TRUE, &fjs->fjs_indexing,
+	    'j', MDB_OPT_SETBITS, B_TRUE, &json,
 	    'k', MDB_OPT_STR, &propkind,
 	    'l', MDB_OPT_SETBITS, B_TRUE, &listlike,
 	    'm', MDB_OPT_SETBITS, B_TRUE, &fjs->fjs_marking,
@@ -5653,6 +6883,14 @@ dcmd_findjsobjects(uintptr_t addr,
 	    NULL) != argc)
 		return (DCMD_USAGE);
 
+	if (json && ((flags & DCMD_ADDRSPEC) || listlike || references ||
+	    fjs->fjs_marking || propname != NULL || constructor != NULL ||
+	    propkind != NULL)) {
+		mdb_warn("-j can only be used to list representative "
+		    "objects\n");
+		return (DCMD_ERR);
+	}
+
 	if (findjsobjects_run(fjs) != 0)
 		return (DCMD_ERR);
 
@@ -5759,6 +6997,20 @@ dcmd_findjsobjects(uintptr_t addr,
 	if (references || fjs->fjs_marking)
 		return (DCMD_OK);
 
+	if (json) {
+		jsl = mdbv8_jsonl_alloc();
+		for (obj = fjs->fjs_objects; obj != NULL;
+		    obj = obj->fjso_next) {
+			if (obj->fjso_malformed && !fjs->fjs_allobjs)
+				continue;
+
+			findjsobjects_print_json(jsl, obj);
+		}
+
+		mdbv8_jsonl_flush(jsl);
+		return (DCMD_OK);
+	}
+
 	mdb_printf("%?s %8s %8s %s\n", "OBJECT",
 	    "#OBJECTS", "#PROPS", "CONSTRUCTOR: PROPS");
 
@@ -6309,11 +7561,37 @@ jsfindrefs_reference(uintptr_t refaddr, void *arg)
 	return (0);
 }
 
+/*
+ * Given the address "addr" where a frame pointer is stored, examine the frame
+ * that it points to.
+ */
+static int
+do_jsframe_caller(uintptr_t addr, jsframe_t *jsf)
+{
+	uintptr_t fptr, raddr;
+
+	if (mdb_vread(&raddr, sizeof (raddr),
+	    addr + sizeof (uintptr_t)) == -1) {
+		mdb_warn("failed to read return address from %p",
+		    addr + sizeof (uintptr_t));
+		return (DCMD_ERR);
+	}
+
+	if (mdb_vread(&fptr, sizeof (fptr), addr) == -1) {
+		mdb_warn("failed to read frame pointer from %p", addr);
+		return (DCMD_ERR);
+	}
+
+	if (fptr == (uintptr_t)NULL)
+		return (DCMD_OK);
+
+	return (do_jsframe(fptr, raddr, jsf));
+}
+
 /* ARGSUSED */
 static int
 dcmd_jsframe(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 {
-	uintptr_t fptr, raddr;
 	boolean_t opt_i = B_FALSE;
 	jsframe_t jsf;
 	int rv;
@@ -6337,29 +7615,11 @@ dcmd_jsframe(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	 * actually stored with the next frame.  For debugging, this can be
 	 * overridden with the "-i" option (for "immediate").
 	 */
-	if (opt_i) {
+	if (opt_i)
 		rv = do_jsframe(addr, 0, &jsf);
-		if (rv == 0)
-			jsframe_print_skipped(&jsf);
-		return (rv);
-	}
-
-	if (mdb_vread(&raddr, sizeof (raddr),
-	    addr + sizeof (uintptr_t)) == -1) {
-		mdb_warn("failed to read return address from %p",
-		    addr + sizeof (uintptr_t));
-		return (DCMD_ERR);
-	}
-
-	if (mdb_vread(&fptr, sizeof (fptr), addr) == -1) {
-		mdb_warn("failed to read frame pointer from %p", addr);
-		return (DCMD_ERR);
-	}
-
-	if (fptr == (uintptr_t)NULL)
-		return (DCMD_OK);
+	else
+		rv = do_jsframe_caller(addr, &jsf);
 
-	rv = do_jsframe(fptr, raddr, &jsf);
 	if (rv == 0)
 		jsframe_print_skipped(&jsf);
 	return (rv);
@@ -6407,8 +7667,9 @@ jsobj_print_propinfo(jspropinfo_t propinfo)
 static int
 dcmd_jsprint(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 {
-	char *buf, *bufp;
-	size_t bufsz = 262144, len = bufsz;
+	char *buf;
+	jsobj_sink_t sink;
+	avl_tree_t visited;
 	jsobj_print_t jsop;
 	boolean_t opt_b = B_FALSE;
 	boolean_t opt_v = B_FALSE;
@@ -6424,6 +7685,7 @@ dcmd_jsprint(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	    'b', MDB_OPT_SETBITS, B_TRUE, &opt_b,
 	    'd', MDB_OPT_UINT64, &jsop.jsop_depth,
 	    'N', MDB_OPT_UINT64, &strlen_override,
+	    'u', MDB_OPT_SETBITS, B_TRUE, &jsop.jsop_utf8,
 	    'v', MDB_OPT_SETBITS, B_TRUE, &opt_v, NULL);
 
 	jsop.jsop_maxstrlen = (int)strlen_override;
@@ -6431,57 +7693,57 @@ dcmd_jsprint(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	if (opt_b)
 		jsop.jsop_baseaddr = addr;
 
+	if ((buf = mdb_alloc(JSOBJ_SINK_BUFSZ, UM_NOSLEEP)) == NULL)
+		return (DCMD_ERR);
+
+	jsobj_sink_init(&sink, &jsop, buf, JSOBJ_SINK_BUFSZ);
+
 	do {
 		if (i != argc) {
 			const mdb_arg_t *member = &argv[i++];
 
-			if (member->a_type != MDB_TYPE_STRING)
+			if (member->a_type != MDB_TYPE_STRING) {
+				mdb_free(sink.jss_buf, sink.jss_bufsz);
 				return (DCMD_USAGE);
+			}
 
 			jsop.jsop_member = member->a_un.a_str;
 		}
 
-		for (;;) {
-			if ((buf = bufp =
-			    mdb_zalloc(bufsz, UM_NOSLEEP)) == NULL)
-				return (DCMD_ERR);
-
-			jsop.jsop_bufp = &bufp;
-			jsop.jsop_lenp = &len;
-
-			rv = jsobj_print(addr, &jsop);
-
-			if (len > 0)
-				break;
-
-			mdb_free(buf, bufsz);
-			bufsz <<= 1;
-			len = bufsz;
-		}
+		jsobj_visited_init(&visited);
+		jsop.jsop_visited = &visited;
+		rv = jsobj_print(addr, &jsop);
+		jsop.jsop_visited = NULL;
+		jsobj_visited_fini(&visited);
 
 		if (jsop.jsop_member == NULL && rv != 0) {
 			if (!jsop.jsop_descended)
-				mdb_warn("%s\n", buf);
+				mdb_warn("%s\n", sink.jss_buf);
+			else if (sink.jss_nflushed > 0)
+				mdb_printf("\n");
 
+			mdb_free(sink.jss_buf, sink.jss_bufsz);
 			return (DCMD_ERR);
 		}
 
 		if (jsop.jsop_member && !jsop.jsop_found) {
+			jsobj_sink_rewind(&sink);
 			if (jsop.jsop_baseaddr)
 				(void) mdb_printf("%p: ", jsop.jsop_baseaddr);
 
 			(void) mdb_printf("undefined%s",
 			    i < argc ? " " : "");
 		} else {
-			(void) mdb_printf("%s%s", buf, i < argc &&
-			    !isspace(buf[strlen(buf) - 1]) ? " " : "");
+			jsobj_sink_flush(&sink);
+			(void) mdb_printf("%s", i < argc &&
+			    !isspace(sink.jss_lastc) ? " " : "");
 		}
 
-		mdb_free(buf, bufsz);
 		jsop.jsop_found = B_FALSE;
 		jsop.jsop_baseaddr = (uintptr_t)NULL;
 	} while (i < argc);
 
+	mdb_free(sink.jss_buf, sink.jss_bufsz);
 	mdb_printf("\n");
 
 	if (opt_v)
@@ -6490,6 +7752,148 @@ dcmd_jsprint(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	return (DCMD_OK);
 }
 
+/*
+ * qsort(3C) comparator for arrays of addresses.
+ */
+static int
+uintptr_cmp(const void *l, const void *r)
+{
+	uintptr_t lhs = *((const uintptr_t *)l);
+	uintptr_t rhs = *((const uintptr_t *)r);
+
+	return (lhs < rhs ? -1 : lhs > rhs ? 1 : 0);
+}
+
+/*
+ * Print every object found by ::findjsobjects, sorted by address, as
+ * "::jsprint -a" would.  These are the objects listed by "::findjsobjects -l |
+ * ::findjsobjects", so objects of malformed kinds are skipped.  Rather than
+ * invoking ::jsprint once per object (with a fresh buffer each time), this
+ * walks the ::findjsobjects results directly and streams all objects through
+ * one jsobj_sink_t, either to the debugger's output or (with -o) to a file.
+ * Decoded Maps and strings are shared across objects via the usual caches.
+ */
+/* ARGSUSED */
+static int
+dcmd_jsdumpall(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+{
+	findjsobjects_state_t *fjs = &findjsobjects_state;
+	findjsobjects_obj_t *obj;
+	findjsobjects_instance_t *inst;
+	const char *outfile = NULL;
+	uint64_t strlen_override = 0;
+	uintptr_t *addrs;
+	size_t naddrs, nalloc, i;
+	jsobj_sink_t sink;
+	avl_tree_t visited;
+	jsobj_print_t jsop;
+	char *buf;
+	int werr, rv = DCMD_OK;
+
+	bzero(&jsop, sizeof (jsop));
+	jsop.jsop_depth = 2;
+	jsop.jsop_printaddr = B_TRUE;
+
+	if (mdb_getopts(argc, argv,
+	    'd', MDB_OPT_UINT64, &jsop.jsop_depth,
+	    'N', MDB_OPT_UINT64, &strlen_override,
+	    'o', MDB_OPT_STR, &outfile,
+	    'u', MDB_OPT_SETBITS, B_TRUE, &jsop.jsop_utf8, NULL) != argc)
+		return (DCMD_USAGE);
+
+	jsop.jsop_maxstrlen = (size_t)strlen_override;
+
+	if (findjsobjects_run(fjs) != 0)
+		return (DCMD_ERR);
+
+	if (!fjs->fjs_finished) {
+		mdb_warn("error: previous findjsobjects "
+		    "heap scan did not complete.\n");
+		return (DCMD_ERR);
+	}
+
+	naddrs = 0;
+	for (obj = fjs->fjs_objects; obj != NULL; obj = obj->fjso_next) {
+		if (!obj->fjso_malformed)
+			naddrs += obj->fjso_ninstances;
+	}
+
+	nalloc = MAX(naddrs, 1);
+	addrs = mdb_alloc(nalloc * sizeof (uintptr_t), UM_SLEEP);
+	i = 0;
+	for (obj = fjs->fjs_objects; obj != NULL; obj = obj->fjso_next) {
+		if (obj->fjso_malformed)
+			continue;
+
+		for (inst = &obj->fjso_instances; inst != NULL && i < naddrs;
+		    inst = inst->fjsi_next)
+			addrs[i++] = inst->fjsi_addr;
+	}
+
+	naddrs = i;
+	qsort(addrs, naddrs, sizeof (uintptr_t), uintptr_cmp);
+
+	buf = mdb_alloc(JSOBJ_SINK_BUFSZ, UM_SLEEP);
+	jsobj_sink_init(&sink, &jsop, buf, JSOBJ_SINK_BUFSZ);
+	if (outfile != NULL && (sink.jss_fp = fopen(outfile, "w")) == NULL) {
+		mdb_warn("failed to open \"%s\"", outfile);
+		rv = DCMD_ERR;
+		goto out;
+	}
+
+	for (i = 0; i < naddrs; i++) {
+		jsobj_visited_init(&visited);
+		jsop.jsop_visited = &visited;
+		(void) jsobj_print(addrs[i], &jsop);
+		jsop.jsop_visited = NULL;
+		jsobj_visited_fini(&visited);
+
+		(void) bsnprintf(jsop.jsop_bufp, jsop.jsop_lenp, "\n");
+		jsobj_sink_reserve(&jsop, 0);
+	}
+
+	jsobj_sink_flush(&sink);
+
+	if (sink.jss_fp != NULL) {
+		werr = ferror(sink.jss_fp);
+		if (fclose(sink.jss_fp) != 0 || werr != 0) {
+			mdb_warn("failed to write \"%s\"", outfile);
+			rv = DCMD_ERR;
+		} else {
+			mdb_printf("wrote %lu objects to %s\n",
+			    (ulong_t)naddrs, outfile);
+		}
+	}
+
+out:
+	mdb_free(sink.jss_buf, sink.jss_bufsz);
+	mdb_free(addrs, nalloc * sizeof (uintptr_t));
+	return (rv);
+}
+
+static void
+dcmd_jsdumpall_help(void)
+{
+	mdb_printf("%s\n\n",
+"Prints every JavaScript object found by ::findjsobjects (running the heap\n"
+"scan first, if necessary), sorted by address, with the address of each\n"
+"object and sub-object inline, as with \"::jsprint -a\".  This prints the\n"
+"objects listed by \"::findjsobjects -l | ::findjsobjects\" (so objects of\n"
+"malformed kinds are skipped), but in address order rather than grouped by\n"
+"kind, and much faster than piping them to ::jsprint.  Objects that can't be\n"
+"printed are reported inline rather than as errors.");
+
+	mdb_dec_indent(2);
+	mdb_printf("%<b>OPTIONS%</b>\n");
+	mdb_inc_indent(2);
+
+	mdb_printf("%s\n",
+"  -d depth  Descend at most \"depth\" levels into each object (default: 2)\n"
+"  -N len    Truncate strings to \"len\" bytes\n"
+"  -o file   Write the objects to \"file\" rather than the debugger's output\n"
+"  -u        Print non-ASCII characters as UTF-8\n");
+}
+
 /* ARGSUSED */
 static int
 dcmd_jssource(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
@@ -6542,35 +7946,482 @@ dcmd_jssource(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	return (DCMD_OK);
 }
 
+static int
+findjsobjects_cmp_coderange(const void *l, const void *r)
+{
+	const findjsobjects_coderange_t *lhs = l;
+	const findjsobjects_coderange_t *rhs = r;
+
+	if (lhs->fjsc_start < rhs->fjsc_start)
+		return (-1);
+
+	if (lhs->fjsc_start > rhs->fjsc_start)
+		return (1);
+
+	return (0);
+}
+
+/*
+ * Reads the location of each function's compiled instructions and builds the
+ * table used to map instruction addresses back to functions.  This is done
+ * once, the first time it's needed after the heap scan.
+ */
+static void
+findjsobjects_coderanges_load(findjsobjects_state_t *fjs)
+{
+	findjsobjects_func_t *func;
+	findjsobjects_coderange_t *ranges;
+	uintptr_t code, ilen, maxend;
+	size_t n, i;
+
+	if (fjs->fjs_coderanges_loaded)
+		return;
+
+	n = 0;
+	v8_silent++;
+	for (func = fjs->fjs_funcs; func != NULL; func = func->fjsf_next) {
+		if (read_heap_ptr(&code, func->fjsf_shared,
+		    V8_OFF_SHAREDFUNCTIONINFO_CODE) != 0 ||
+		    read_heap_ptr(&ilen, code,
+		    V8_OFF_CODE_INSTRUCTION_SIZE) != 0 || ilen == 0) {
+			func->fjsf_instr_start = 0;
+			func->fjsf_instr_end = 0;
+			continue;
+		}
+
+		func->fjsf_instr_start = code + V8_OFF_CODE_INSTRUCTION_START;
+		func->fjsf_instr_end = func->fjsf_instr_start + ilen;
+		n++;
+	}
+	v8_silent--;
+
+	ranges = n == 0 ? NULL :
+	    mdb_alloc(n * sizeof (findjsobjects_coderange_t), UM_SLEEP);
+
+	i = 0;
+	for (func = fjs->fjs_funcs; func != NULL; func = func->fjsf_next) {
+		if (func->fjsf_instr_end == 0)
+			continue;
+
+		ranges[i].fjsc_start = func->fjsf_instr_start;
+		ranges[i].fjsc_end = func->fjsf_instr_end;
+		ranges[i].fjsc_func = func;
+		i++;
+	}
+
+	if (n != 0) {
+		qsort(ranges, n, sizeof (findjsobjects_coderange_t),
+		    findjsobjects_cmp_coderange);
+	}
+
+	for (i = 0, maxend = 0; i < n; i++) {
+		if (ranges[i].fjsc_end > maxend)
+			maxend = ranges[i].fjsc_end;
+		ranges[i].fjsc_maxend = maxend;
+	}
+
+	fjs->fjs_coderanges = ranges;
+	fjs->fjs_ncoderanges = n;
+	fjs->fjs_coderanges_loaded = B_TRUE;
+}
+
+/*
+ * Invokes "func" for each function whose compiled instructions include the
+ * address "pc".  Functions often share instructions (e.g., those that have not
+ * yet been compiled all use the same builtin), so there may be more than one.
+ * They're visited in order of their starting addresses.  Returns the number of
+ * functions found.
+ */
+static size_t
+findjsobjects_func_lookup(findjsobjects_state_t *fjs, uintptr_t pc,
+    void (*func)(findjsobjects_func_t *, void *), void *arg)
+{
+	findjsobjects_coderange_t *ranges;
+	size_t lower, upper, mid, last, nfound;
+
+	findjsobjects_coderanges_load(fjs);
+	ranges = fjs->fjs_coderanges;
+
+	/*
+	 * Find the number of ranges that start at or before "pc".  Only those
+	 * can contain it.
+	 */
+	lower = 0;
+	upper = fjs->fjs_ncoderanges;
+	while (lower < upper) {
+		mid = (lower + upper) / 2;
+		if (ranges[mid].fjsc_start <= pc)
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+
+	/*
+	 * Walk backwards to the first range that could contain "pc", then
+	 * report the ones that do in ascending order.
+	 */
+	last = lower;
+	while (lower > 0 && ranges[lower - 1].fjsc_maxend > pc)
+		lower--;
+
+	nfound = 0;
+	for (; lower < last; lower++) {
+		if (ranges[lower].fjsc_end > pc) {
+			func(ranges[lower].fjsc_func, arg);
+			nfound++;
+		}
+	}
+
+	return (nfound);
+}
+
+typedef struct jsfunctions_state {
+	boolean_t	jsfs_showrange;
+	boolean_t	jsfs_listlike;
+	const char	*jsfs_name;
+	const char	*jsfs_filename;
+	mdbv8_jsonl_t	*jsfs_jsonl;
+} jsfunctions_state_t;
+
+static void
+jsfunctions_print(findjsobjects_func_t *func, void *arg)
+{
+	jsfunctions_state_t *jsfs = arg;
+	uintptr_t funcinfo = func->fjsf_shared;
+
+	if (jsfs->jsfs_name != NULL &&
+	    strstr(func->fjsf_funcname, jsfs->jsfs_name) == NULL)
+		return;
+
+	if (jsfs->jsfs_filename != NULL &&
+	    strstr(func->fjsf_scriptname, jsfs->jsfs_filename) == NULL)
+		return;
+
+	if (jsfs->jsfs_listlike) {
+		mdb_printf("%?p\n", func->fjsf_instances.fjsi_addr);
+		return;
+	}
+
+	if (func->fjsf_location[0] == '\0') {
+		uintptr_t tokpos, script, lends;
+		ptrdiff_t tokposoff =
+		    V8_OFF_SHAREDFUNCTIONINFO_FUNCTION_TOKEN_POSITION;
+
+		/*
+		 * We don't want to actually decode the token position as an
+		 * SMI here, so we re-encode it when we pass it to
+		 * jsfunc_lineno() below.
+		 */
+		if (read_heap_maybesmi(&tokpos, funcinfo, tokposoff) != 0 ||
+		    read_heap_ptr(&script, funcinfo,
+		    V8_OFF_SHAREDFUNCTIONINFO_SCRIPT) != 0 ||
+		    read_heap_ptr(&lends, script,
+		    V8_OFF_SCRIPT_LINE_ENDS) != 0 ||
+		    jsfunc_lineno(lends, V8_VALUE_SMI(tokpos),
+		    func->fjsf_location, sizeof (func->fjsf_location),
+		    &func->fjsf_lineno) != 0) {
+			func->fjsf_location[0] = '\0';
+		}
+	}
+
+	if (jsfs->jsfs_jsonl != NULL) {
+		mdbv8_jsonl_t *jsl = jsfs->jsfs_jsonl;
+
+		mdbv8_jsonl_begin(jsl);
+		mdbv8_jsonl_addr(jsl, "addr", func->fjsf_instances.fjsi_addr);
+		mdbv8_jsonl_uint(jsl, "count", func->fjsf_ninstances);
+		mdbv8_jsonl_string(jsl, "name", func->fjsf_funcname);
+		mdbv8_jsonl_string(jsl, "script", func->fjsf_scriptname);
+		if (func->fjsf_lineno > 0)
+			mdbv8_jsonl_uint(jsl, "line", func->fjsf_lineno);
+		if (func->fjsf_instr_end != 0) {
+			mdbv8_jsonl_addr(jsl, "start", func->fjsf_instr_start);
+			mdbv8_jsonl_addr(jsl, "end", func->fjsf_instr_end);
+		}
+		mdbv8_jsonl_end(jsl);
+	} else if (!jsfs->jsfs_showrange) {
+		mdb_printf("%?p %8d %-40s %s %s\n",
+		    func->fjsf_instances.fjsi_addr,
+		    func->fjsf_ninstances, func->fjsf_funcname,
+		    func->fjsf_scriptname, func->fjsf_location);
+	} else if (func->fjsf_instr_end == 0) {
+		mdb_printf("%?p %8d %?s %?s %-40s %s %s\n",
+		    func->fjsf_instances.fjsi_addr,
+		    func->fjsf_ninstances, "?", "?",
+		    func->fjsf_funcname, func->fjsf_scriptname,
+		    func->fjsf_location);
+	} else {
+		mdb_printf("%?p %8d %?p %?p %-40s %s %s\n",
+		    func->fjsf_instances.fjsi_addr,
+		    func->fjsf_ninstances,
+		    func->fjsf_instr_start, func->fjsf_instr_end,
+		    func->fjsf_funcname, func->fjsf_scriptname,
+		    func->fjsf_location);
+	}
+}
+
 /* ARGSUSED */
 static int
 dcmd_jsfunctions(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 {
 	findjsobjects_state_t *fjs = &findjsobjects_state;
 	findjsobjects_func_t *func;
-	uintptr_t funcinfo;
-	boolean_t showrange = B_FALSE;
-	boolean_t listlike = B_FALSE;
-	const char *name = NULL, *filename = NULL;
+	jsfunctions_state_t jsfs;
 	uintptr_t instr = 0;
+	boolean_t json = B_FALSE;
 
+	bzero(&jsfs, sizeof (jsfs));
 	if (mdb_getopts(argc, argv,
-	    'l', MDB_OPT_SETBITS, B_TRUE, &listlike,
+	    'j', MDB_OPT_SETBITS, B_TRUE, &json,
+	    'l', MDB_OPT_SETBITS, B_TRUE, &jsfs.jsfs_listlike,
 	    'x', MDB_OPT_UINTPTR, &instr,
-	    'X', MDB_OPT_SETBITS, B_TRUE, &showrange,
-	    'n', MDB_OPT_STR, &name,
-	    's', MDB_OPT_STR, &filename,
+	    'X', MDB_OPT_SETBITS, B_TRUE, &jsfs.jsfs_showrange,
+	    'n', MDB_OPT_STR, &jsfs.jsfs_name,
+	    's', MDB_OPT_STR, &jsfs.jsfs_filename,
 	    NULL) != argc)
 		return (DCMD_USAGE);
 
 	if (findjsobjects_run(fjs) != 0)
 		return (DCMD_ERR);
 
-	if (listlike && !(flags & DCMD_ADDRSPEC) &&
-	    (name != NULL || filename != NULL || instr != 0)) {
+	if (jsfs.jsfs_listlike && !(flags & DCMD_ADDRSPEC) &&
+	    (jsfs.jsfs_name != NULL || jsfs.jsfs_filename != NULL ||
+	    instr != 0)) {
 		mdb_warn("cannot specify -l with -n, -f, or -x\n");
 		return (DCMD_ERR);
-	}
+	}
+
+	if (json && (jsfs.jsfs_listlike || (flags & DCMD_ADDRSPEC))) {
+		mdb_warn("cannot specify -j with -l or an address\n");
+		return (DCMD_ERR);
+	}
+
+	if (!fjs->fjs_finished) {
+		mdb_warn("error: previous findjsobjects "
+		    "heap scan did not complete.\n");
+		return (DCMD_ERR);
+	}
+
+	if (flags & DCMD_ADDRSPEC) {
+		findjsobjects_instance_t *inst;
+
+		for (func = fjs->fjs_funcs; func != NULL;
+		    func = func->fjsf_next) {
+			if (addr != func->fjsf_instances.fjsi_addr)
+				continue;
+
+			for (inst = &func->fjsf_instances;
+			    inst != NULL; inst = inst->fjsi_next) {
+				mdb_printf("%?p\n", inst->fjsi_addr);
+			}
+		}
+
+		return (DCMD_OK);
+	}
+
+	if (json) {
+		jsfs.jsfs_jsonl = mdbv8_jsonl_alloc();
+	} else if (!jsfs.jsfs_showrange && !jsfs.jsfs_listlike) {
+		mdb_printf("%?s %8s %-40s %s\n", "FUNC", "#FUNCS", "NAME",
+		    "FROM");
+	} else if (!jsfs.jsfs_listlike) {
+		mdb_printf("%?s %8s %?s %?s %-40s %s\n", "FUNC", "#FUNCS",
+		    "START", "END", "NAME", "FROM");
+	}
+
+	if (jsfs.jsfs_showrange || json)
+		findjsobjects_coderanges_load(fjs);
+
+	if (instr != 0) {
+		(void) findjsobjects_func_lookup(fjs, instr,
+		    jsfunctions_print, &jsfs);
+	} else {
+		for (func = fjs->fjs_funcs; func != NULL;
+		    func = func->fjsf_next)
+			jsfunctions_print(func, &jsfs);
+	}
+
+	if (jsfs.jsfs_jsonl != NULL)
+		mdbv8_jsonl_flush(jsfs.jsfs_jsonl);
+
+	return (DCMD_OK);
+}
+
+static void
+dcmd_jsfunctions_help(void)
+{
+	mdb_printf("%s\n\n",
+"Lists JavaScript functions, optionally filtered by a substring of the\n"
+"function name or script filename or by the instruction address.  This uses\n"
+"the cache created by ::findjsobjects.  If ::findjsobjects has not already\n"
+"been run, this command runs it automatically without printing the output.\n"
+"This can take anywhere from a second to several minutes, depending on the\n"
+"size of the core dump.\n"
+"\n"
+"It's important to keep in mind that each time you create a function in\n"
+"JavaScript (even from a function definition that has already been used),\n"
+"the VM must create a new object to represent it.  For example, if your\n"
+"program has a function A that returns a closure B, the VM will create new\n"
+"instances of the closure function (B) each time the surrounding function (A)\n"
+"is called.  To show this, the output of this command consists of one line \n"
+"per function definition that appears in the JavaScript source, and the\n"
+"\"#FUNCS\" column shows how many different functions were created by VM from\n"
+"this definition.");
+
+	mdb_dec_indent(2);
+	mdb_printf("%<b>OPTIONS%</b>\n");
+	mdb_inc_indent(2);
+
+	mdb_printf("%s\n",
+"  -j       List functions as JSON, one function per line, including the\n"
+"           location of each function's instructions\n"
+"  -l       List only closures (without other columns).  With ADDR, list\n"
+"           closures for the representative function ADDR.\n"
+"  -n func  List functions whose name contains this substring\n"
+"  -s file  List functions that were defined in a file whose name contains\n"
+"           this substring.\n"
+"  -x instr List functions whose compiled instructions include this address\n"
+"  -X       Show where the function's instructions are stored in memory\n");
+}
+
+typedef struct jsscripts_script {
+	uintptr_t	jssc_addr;		/* Script address */
+	size_t		jssc_nfuncs;		/* functions defined in it */
+	boolean_t	jssc_dup;		/* file name is not unique */
+	char		jssc_name[256];		/* script name */
+	char		jssc_file[256];		/* output file name */
+} jsscripts_script_t;
+
+static int
+jsscripts_cmp(const void *l, const void *r)
+{
+	const jsscripts_script_t *lhs = l;
+	const jsscripts_script_t *rhs = r;
+	int rv;
+
+	if ((rv = strcmp(lhs->jssc_file, rhs->jssc_file)) != 0)
+		return (rv);
+
+	return (lhs->jssc_addr < rhs->jssc_addr ? -1 :
+	    lhs->jssc_addr > rhs->jssc_addr ? 1 : 0);
+}
+
+/*
+ * Derive the name of the file in which to store a script's source from the
+ * script's name by replacing anything other than letters, digits, ".", "-",
+ * and "_".  (In particular, that flattens paths.)
+ */
+static void
+jsscripts_filename(jsscripts_script_t *scp)
+{
+	const char *p = scp->jssc_name;
+	char *q = scp->jssc_file;
+	char *end = scp->jssc_file + sizeof (scp->jssc_file) - 1;
+
+	while (*p == '/')
+		p++;
+
+	if (*p == '\0')
+		p = "script";
+
+	for (; *p != '\0' && q < end; p++, q++) {
+		if (isalnum((unsigned char)*p) || *p == '.' || *p == '-' ||
+		    *p == '_')
+			*q = *p;
+		else
+			*q = '_';
+	}
+
+	*q = '\0';
+	if (scp->jssc_file[0] == '.')
+		scp->jssc_file[0] = '_';
+}
+
+/*
+ * Writes the source of script "scp" to "path".  The source is written with a
+ * single call to v8string_write() into a buffer large enough for any encoding
+ * of it, which is grown (and kept for the next script) as needed.  The buffer
+ * is garbage-collected, so callers need not free it.
+ */
+static int
+jsscripts_write(jsscripts_script_t *scp, const char *path,
+    char **bufp, size_t *bufszp)
+{
+	uintptr_t src;
+	v8string_t *strp;
+	mdbv8_strbuf_t strb;
+	size_t need, nbytes;
+	FILE *fp;
+	int werr;
+
+	if (read_heap_ptr(&src, scp->jssc_addr, V8_OFF_SCRIPT_SOURCE) != 0 ||
+	    (strp = v8string_load(src, UM_SLEEP)) == NULL) {
+		mdb_warn("%p: failed to read source of script \"%s\"\n",
+		    scp->jssc_addr, scp->jssc_name);
+		return (-1);
+	}
+
+	/*
+	 * Each UTF-16 code unit takes at most three bytes in UTF-8 (and a
+	 * surrogate pair takes four bytes for two units).
+	 */
+	need = 3 * v8string_length(strp) + 1;
+	if (need > *bufszp) {
+		need = MAX(need, 2 * *bufszp);
+		*bufp = mdb_alloc(need, UM_SLEEP | UM_GC);
+		*bufszp = need;
+	}
+
+	mdbv8_strbuf_init(&strb, *bufp, *bufszp);
+	if (v8string_write(strp, &strb, MSF_UTF8, JSSTR_NUDE) != 0) {
+		mdb_warn("%p: failed to read source of script \"%s\"\n",
+		    scp->jssc_addr, scp->jssc_name);
+		v8string_free(strp);
+		return (-1);
+	}
+
+	v8string_free(strp);
+	nbytes = mdbv8_strbuf_bufsz(&strb) - mdbv8_strbuf_bytesleft(&strb) - 1;
+
+	if ((fp = fopen(path, "w")) == NULL) {
+		mdb_warn("failed to open \"%s\"", path);
+		return (-1);
+	}
+
+	(void) fwrite(*bufp, 1, nbytes, fp);
+	werr = ferror(fp);
+	if (fclose(fp) != 0 || werr != 0) {
+		mdb_warn("failed to write \"%s\"", path);
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Enumerate the scripts that define the functions found by ::findjsobjects,
+ * and either list them or (with -o) save each one's source to a file.
+ */
+/* ARGSUSED */
+static int
+dcmd_jsscripts(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+{
+	findjsobjects_state_t *fjs = &findjsobjects_state;
+	findjsobjects_func_t *func;
+	jsscripts_script_t *scripts, *scp;
+	const char *outdir = NULL;
+	uintptr_t *addrs, nameptr;
+	size_t nfuncs, nscripts, nwritten, i, bufsz = 0;
+	char path[MAXPATHLEN], *buf = NULL, *bufp;
+	size_t len;
+	int rv = DCMD_OK;
+
+	if (mdb_getopts(argc, argv,
+	    'o', MDB_OPT_STR, &outdir, NULL) != argc)
+		return (DCMD_USAGE);
+
+	if (findjsobjects_run(fjs) != 0)
+		return (DCMD_ERR);
 
 	if (!fjs->fjs_finished) {
 		mdb_warn("error: previous findjsobjects "
@@ -6578,153 +8429,136 @@ dcmd_jsfunctions(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 		return (DCMD_ERR);
 	}
 
-	if (flags & DCMD_ADDRSPEC) {
-		listlike = B_TRUE;
+	if (outdir != NULL && mkdir(outdir, 0777) != 0 && errno != EEXIST) {
+		mdb_warn("failed to create \"%s\"", outdir);
+		return (DCMD_ERR);
 	}
 
-	if (!showrange && !listlike) {
-		mdb_printf("%?s %8s %-40s %s\n", "FUNC", "#FUNCS", "NAME",
-		    "FROM");
-	} else if (!listlike) {
-		mdb_printf("%?s %8s %?s %?s %-40s %s\n", "FUNC", "#FUNCS",
-		    "START", "END", "NAME", "FROM");
-	}
+	/*
+	 * Functions are unique by SharedFunctionInfo, each of which refers to
+	 * the Script that defines it.  Sort those references so that we can
+	 * count each Script once.
+	 */
+	nfuncs = 0;
+	for (func = fjs->fjs_funcs; func != NULL; func = func->fjsf_next)
+		nfuncs++;
 
+	addrs = mdb_alloc(MAX(nfuncs, 1) * sizeof (uintptr_t),
+	    UM_SLEEP | UM_GC);
+	i = 0;
+	v8_silent++;
 	for (func = fjs->fjs_funcs; func != NULL; func = func->fjsf_next) {
-		uintptr_t code, ilen;
-
-		if (listlike && (flags & DCMD_ADDRSPEC) != 0) {
-			findjsobjects_instance_t *inst;
-
-			if (addr != func->fjsf_instances.fjsi_addr) {
-				continue;
-			}
+		if (read_heap_ptr(&addrs[i], func->fjsf_shared,
+		    V8_OFF_SHAREDFUNCTIONINFO_SCRIPT) == 0)
+			i++;
+	}
+	v8_silent--;
 
-			for (inst = &func->fjsf_instances;
-			    inst != NULL; inst = inst->fjsi_next) {
-				mdb_printf("%?p\n", inst->fjsi_addr);
-			}
+	nfuncs = i;
+	qsort(addrs, nfuncs, sizeof (uintptr_t), uintptr_cmp);
 
+	scripts = mdb_zalloc(MAX(nfuncs, 1) * sizeof (jsscripts_script_t),
+	    UM_SLEEP | UM_GC);
+	nscripts = 0;
+	for (i = 0; i < nfuncs; i++) {
+		if (nscripts > 0 &&
+		    scripts[nscripts - 1].jssc_addr == addrs[i]) {
+			scripts[nscripts - 1].jssc_nfuncs++;
 			continue;
 		}
 
-		funcinfo = func->fjsf_shared;
+		scp = &scripts[nscripts++];
+		scp->jssc_addr = addrs[i];
+		scp->jssc_nfuncs = 1;
 
-		if (func->fjsf_location[0] == '\0') {
-			uintptr_t tokpos, script, lends;
-			ptrdiff_t tokposoff =
-			    V8_OFF_SHAREDFUNCTIONINFO_FUNCTION_TOKEN_POSITION;
-
-			/*
-			 * We don't want to actually decode the token position
-			 * as an SMI here, so we re-encode it when we pass it to
-			 * jsfunc_lineno() below.
-			 */
-			if (read_heap_maybesmi(&tokpos, funcinfo,
-			    tokposoff) != 0 ||
-			    read_heap_ptr(&script, funcinfo,
-			    V8_OFF_SHAREDFUNCTIONINFO_SCRIPT) != 0 ||
-			    read_heap_ptr(&lends, script,
-			    V8_OFF_SCRIPT_LINE_ENDS) != 0 ||
-			    jsfunc_lineno(lends, V8_VALUE_SMI(tokpos),
-			    func->fjsf_location,
-			    sizeof (func->fjsf_location), NULL) != 0) {
-				func->fjsf_location[0] = '\0';
-			}
-		}
+		bufp = scp->jssc_name;
+		len = sizeof (scp->jssc_name);
+		if (read_heap_ptr(&nameptr, scp->jssc_addr,
+		    V8_OFF_SCRIPT_NAME) != 0 ||
+		    jsstr_print(nameptr, JSSTR_NUDE, &bufp, &len) != 0)
+			scp->jssc_name[0] = '\0';
 
-		if (name != NULL && strstr(func->fjsf_funcname, name) == NULL)
-			continue;
+		jsscripts_filename(scp);
+	}
 
-		if (filename != NULL &&
-		    strstr(func->fjsf_scriptname, filename) == NULL)
-			continue;
+	qsort(scripts, nscripts, sizeof (jsscripts_script_t), jsscripts_cmp);
 
-		code = 0;
-		ilen = 0;
-		if ((showrange || instr != 0) &&
-		    (read_heap_ptr(&code, funcinfo,
-		    V8_OFF_SHAREDFUNCTIONINFO_CODE) != 0 ||
-		    read_heap_ptr(&ilen, code,
-		    V8_OFF_CODE_INSTRUCTION_SIZE) != 0)) {
-			code = 0;
-			ilen = 0;
+	/*
+	 * Scripts whose names yield the same file name (including all unnamed
+	 * scripts) are told apart by address.
+	 */
+	for (i = 1; i < nscripts; i++) {
+		if (strcmp(scripts[i - 1].jssc_file,
+		    scripts[i].jssc_file) == 0) {
+			scripts[i - 1].jssc_dup = B_TRUE;
+			scripts[i].jssc_dup = B_TRUE;
 		}
+	}
 
-		if ((instr != 0 && ilen != 0) &&
-		    (instr < code + V8_OFF_CODE_INSTRUCTION_START ||
-		    instr >= code + V8_OFF_CODE_INSTRUCTION_START + ilen))
+	for (i = 0; i < nscripts; i++) {
+		scp = &scripts[i];
+		if (!scp->jssc_dup)
 			continue;
 
-		if (listlike) {
-			mdb_printf("%?p\n", func->fjsf_instances.fjsi_addr);
-		} else if (!showrange) {
-			mdb_printf("%?p %8d %-40s %s %s\n",
-			    func->fjsf_instances.fjsi_addr,
-			    func->fjsf_ninstances, func->fjsf_funcname,
-			    func->fjsf_scriptname, func->fjsf_location);
-		} else {
-			uintptr_t code, ilen;
-
-			if (read_heap_ptr(&code, funcinfo,
-			    V8_OFF_SHAREDFUNCTIONINFO_CODE) != 0 ||
-			    read_heap_ptr(&ilen, code,
-			    V8_OFF_CODE_INSTRUCTION_SIZE) != 0) {
-				mdb_printf("%?p %8d %?s %?s %-40s %s %s\n",
-				    func->fjsf_instances.fjsi_addr,
-				    func->fjsf_ninstances, "?", "?",
-				    func->fjsf_funcname, func->fjsf_scriptname,
-				    func->fjsf_location);
-			} else {
-				mdb_printf("%?p %8d %?p %?p %-40s %s %s\n",
-				    func->fjsf_instances.fjsi_addr,
-				    func->fjsf_ninstances,
-				    code + V8_OFF_CODE_INSTRUCTION_START,
-				    code + V8_OFF_CODE_INSTRUCTION_START + ilen,
-				    func->fjsf_funcname, func->fjsf_scriptname,
-				    func->fjsf_location);
-			}
+		/*
+		 * Truncate the name if necessary to leave room for the
+		 * suffix: a "." and the script's address in hex.
+		 */
+		len = MIN(strlen(scp->jssc_file), sizeof (scp->jssc_file) -
+		    (2 * sizeof (uintptr_t) + 2));
+		(void) mdb_snprintf(scp->jssc_file + len,
+		    sizeof (scp->jssc_file) - len, ".%p", scp->jssc_addr);
+	}
+
+	if (outdir == NULL) {
+		mdb_printf("%?s %6s %s\n", "SCRIPT", "#FUNCS", "NAME");
+		for (i = 0; i < nscripts; i++) {
+			scp = &scripts[i];
+			mdb_printf("%?p %6lu %s\n", scp->jssc_addr,
+			    (ulong_t)scp->jssc_nfuncs, scp->jssc_name);
 		}
+
+		return (DCMD_OK);
 	}
 
-	return (DCMD_OK);
+	nwritten = 0;
+	for (i = 0; i < nscripts; i++) {
+		scp = &scripts[i];
+		(void) mdb_snprintf(path, sizeof (path), "%s/%s", outdir,
+		    scp->jssc_file);
+		if (jsscripts_write(scp, path, &buf, &bufsz) != 0)
+			rv = DCMD_ERR;
+		else
+			nwritten++;
+	}
+
+	mdb_printf("wrote %lu of %lu scripts to %s\n", (ulong_t)nwritten,
+	    (ulong_t)nscripts, outdir);
+	return (rv);
 }
 
 static void
-dcmd_jsfunctions_help(void)
+dcmd_jsscripts_help(void)
 {
 	mdb_printf("%s\n\n",
-"Lists JavaScript functions, optionally filtered by a substring of the\n"
-"function name or script filename or by the instruction address.  This uses\n"
-"the cache created by ::findjsobjects.  If ::findjsobjects has not already\n"
-"been run, this command runs it automatically without printing the output.\n"
-"This can take anywhere from a second to several minutes, depending on the\n"
-"size of the core dump.\n"
-"\n"
-"It's important to keep in mind that each time you create a function in\n"
-"JavaScript (even from a function definition that has already been used),\n"
-"the VM must create a new object to represent it.  For example, if your\n"
-"program has a function A that returns a closure B, the VM will create new\n"
-"instances of the closure function (B) each time the surrounding function (A)\n"
-"is called.  To show this, the output of this command consists of one line \n"
-"per function definition that appears in the JavaScript source, and the\n"
-"\"#FUNCS\" column shows how many different functions were created by VM from\n"
-"this definition.");
+"Lists the scripts that define the JavaScript functions found by\n"
+"::findjsobjects (running the heap scan first, if necessary), with the\n"
+"number of function definitions in each.  With -o, writes the source of\n"
+"each script instead to a file in the given directory, named after the\n"
+"script with directory separators and other unusual characters replaced by\n"
+"\"_\".  Scripts with the same name (including scripts with no name) are\n"
+"distinguished by appending the Script's address.");
 
 	mdb_dec_indent(2);
 	mdb_printf("%<b>OPTIONS%</b>\n");
 	mdb_inc_indent(2);
 
 	mdb_printf("%s\n",
-"  -l       List only closures (without other columns).  With ADDR, list\n"
-"           closures for the representative function ADDR.\n"
-"  -n func  List functions whose name contains this substring\n"
-"  -s file  List functions that were defined in a file whose name contains\n"
-"           this substring.\n"
-"  -x instr List functions whose compiled instructions include this address\n"
-"  -X       Show where the function's instructions are stored in memory\n");
+"  -o dir  Write each script's source to a file in directory \"dir\",\n"
+"          which is created if it does not exist\n");
 }
 
+
 /* ARGSUSED */
 static int
 dcmd_v8field(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
@@ -6755,18 +8589,12 @@ dcmd_v8field(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 		offset = mdb_strtoull(argv[2].a_un.a_str);
 	}
 
-	for (clp = v8_classes; clp != NULL; clp = clp->v8c_next)
-		if (strcmp(clp->v8c_name, klass) == 0)
-			break;
-
-	if (clp == NULL) {
+	if ((clp = conf_class_lookup(klass)) == NULL) {
 		(void) mdb_printf("error: no such class: \"%s\"", klass);
 		return (DCMD_ERR);
 	}
 
-	for (flp = clp->v8c_fields; flp != NULL; flp = flp->v8f_next)
-		if (strcmp(field, flp->v8f_name) == 0)
-			break;
+	flp = conf_field_lookup(klass, field);
 
 	if (flp == NULL) {
 		if (argc == 2) {
@@ -6780,8 +8608,11 @@ dcmd_v8field(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 			mdb_warn("failed to create field");
 			return (DCMD_ERR);
 		}
+
+		conf_field_sort(clp);
 	} else if (argc == 3) {
 		flp->v8f_offset = offset;
+		conf_field_sort(clp);
 	}
 
 	mdb_printf("%s::%s at offset 0x%x\n", klass, field, flp->v8f_offset);
@@ -6843,18 +8674,30 @@ dcmd_v8array(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	return (rv == 0 ? DCMD_OK : DCMD_ERR);
 }
 
+/* ARGSUSED */
+static int
+jsstack_walk_frame(uintptr_t addr, const void *ignored, void *arg)
+{
+	(void) do_jsframe_caller(addr, arg);
+	return (WALK_NEXT);
+}
+
 /* ARGSUSED */
 static int
 dcmd_jsstack(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 {
 	uintptr_t raddr;
 	jsframe_t jsf;
+	boolean_t json = B_FALSE;
+	int rv = DCMD_OK;
 
 	bzero(&jsf, sizeof (jsf));
 	jsf.jsf_nlines = 5;
 
 	if (mdb_getopts(argc, argv,
 	    'a', MDB_OPT_SETBITS, B_TRUE, &jsf.jsf_showall,
+	    'F', MDB_OPT_SETBITS, B_TRUE, &jsf.jsf_folded,
+	    'j', MDB_OPT_SETBITS, B_TRUE, &json,
 	    'v', MDB_OPT_SETBITS, B_TRUE, &jsf.jsf_verbose,
 	    'f', MDB_OPT_STR, &jsf.jsf_func,
 	    'n', MDB_OPT_UINTPTR, &jsf.jsf_nlines,
@@ -6862,6 +8705,46 @@ dcmd_jsstack(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	    NULL) != argc)
 		return (DCMD_USAGE);
 
+	if (jsf.jsf_folded || json) {
+		if (jsf.jsf_folded && json) {
+			mdb_warn("cannot specify both -F and -j\n");
+			return (DCMD_ERR);
+		}
+
+		if (jsf.jsf_showall || jsf.jsf_verbose ||
+		    jsf.jsf_func != NULL || jsf.jsf_prop != NULL) {
+			mdb_warn("cannot specify -%c with -a, -f, -p, or -v\n",
+			    json ? 'j' : 'F');
+			return (DCMD_ERR);
+		}
+
+		if (json)
+			jsf.jsf_jsonl = mdbv8_jsonl_alloc();
+
+		if (!(flags & DCMD_ADDRSPEC)) {
+			if (load_current_context(&addr, &raddr) == 0)
+				(void) do_jsframe(addr, raddr, &jsf);
+			else
+				rv = DCMD_ERR;
+		}
+
+		/*
+		 * A frame we can't read shouldn't cost us the rest of the
+		 * stack, so the callback ignores errors from individual
+		 * frames.
+		 */
+		if (rv == DCMD_OK &&
+		    mdb_pwalk("jsframe", jsstack_walk_frame, &jsf, addr) == -1)
+			rv = DCMD_ERR;
+
+		if (json)
+			mdbv8_jsonl_flush(jsf.jsf_jsonl);
+		else if (rv == DCMD_OK)
+			jsframe_fold_print(&jsf);
+
+		return (rv);
+	}
+
 	/*
 	 * The "::jsframe" walker iterates the valid frame pointers, but the
 	 * "::jsframe" dcmd looks at the frame after the one it was given, so we
@@ -6886,11 +8769,13 @@ dcmd_v8str(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 {
 	boolean_t opt_v = B_FALSE;
 	boolean_t opt_r = B_FALSE;
+	boolean_t opt_u = B_FALSE;
 	int64_t bufsz = -1;
 	v8string_t *strp;
 	mdbv8_strbuf_t *strb;
 
 	if (mdb_getopts(argc, argv,
+	    'u', MDB_OPT_SETBITS, B_TRUE, &opt_u,
 	    'v', MDB_OPT_SETBITS, B_TRUE, &opt_v,
 	    'N', MDB_OPT_UINT64, &bufsz,
 	    'r', MDB_OPT_SETBITS, B_TRUE, &opt_r, NULL) != argc) {
@@ -6905,9 +8790,11 @@ dcmd_v8str(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 		/*
 		 * The buffer size should accommodate the length of the string,
 		 * plus the surrounding quotes, plus the terminator.  (If we're
-		 * wrong here, the visible string will just be truncated.)
+		 * wrong here, the visible string will just be truncated.)  Each
+		 * character can take up to three bytes as UTF-8.
 		 */
-		bufsz = v8string_length(strp) + sizeof ("\"\"");
+		bufsz = v8string_length(strp) * (opt_u ? 3 : 1) +
+		    sizeof ("\"\"");
 	}
 
 	if ((strb = mdbv8_strbuf_alloc(bufsz, UM_GC)) == NULL) {
@@ -6915,7 +8802,7 @@ dcmd_v8str(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	}
 
 	if (v8string_write(strp, strb,
-	    opt_r ? MSF_ASCIIONLY : MSF_JSON,
+	    (opt_r ? MSF_ASCIIONLY : MSF_JSON) | (opt_u ? MSF_UTF8 : 0),
 	    (opt_v ? JSSTR_VERBOSE : JSSTR_NONE) |
 	    (opt_r ? JSSTR_NONE : JSSTR_QUOTED)) != 0)
 		return (DCMD_ERR);
@@ -6983,52 +8870,167 @@ dcmd_v8load(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	return (DCMD_OK);
 }
 
-/* ARGSUSED */
+/*
+ * Map a core file directly into our address space so that we can read target
+ * memory without copying it through the debugger.
+ */
 static int
-dcmd_v8warnings(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+dcmd_v8core(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 {
-	v8_warnings ^= 1;
-	mdb_printf("v8 warnings are now %s\n", v8_warnings ? "on" : "off");
+	boolean_t unmap = B_FALSE;
+	int i;
+
+	if ((i = mdb_getopts(argc, argv,
+	    'u', MDB_OPT_SETBITS, B_TRUE, &unmap, NULL)) != argc - 1 &&
+	    i != argc) {
+		return (DCMD_USAGE);
+	}
+
+	if (unmap) {
+		if (i != argc)
+			return (DCMD_USAGE);
+
+		dbi_core_close();
+		return (DCMD_OK);
+	}
+
+	if (i == argc) {
+		if (dbi_core_path() == NULL) {
+			mdb_printf("no core file mapped\n");
+		} else {
+			mdb_printf("mapped core file: %s\n", dbi_core_path());
+		}
+
+		return (DCMD_OK);
+	}
+
+	if (argv[i].a_type != MDB_TYPE_STRING)
+		return (DCMD_USAGE);
 
+	if (dbi_core_open(argv[i].a_un.a_str) != 0)
+		return (DCMD_ERR);
+
+	mdb_printf("mapped core file: %s\n", dbi_core_path());
 	return (DCMD_OK);
 }
 
+static void
+dcmd_v8core_help(void)
+{
+	mdb_printf("%s\n\n",
+"Maps the given core file (which must be the core file being debugged)\n"
+"directly into the debugger's address space.  While it's mapped, mdb_v8\n"
+"reads target memory directly from the mapping, and can scan large objects\n"
+"and heap regions in place rather than copying them.  With no arguments,\n"
+"reports which core file (if any) is mapped.");
+
+	mdb_dec_indent(2);
+	mdb_printf("%<b>OPTIONS%</b>\n");
+	mdb_inc_indent(2);
+
+	mdb_printf("%s\n",
+"  -u       Unmap the currently mapped core file\n");
+}
+
+#define	V8CACHE_STATFMT	"%-24s %16llu\n"
+
 /*
- * "v8whatis" scours the memory just prior to the given address looking for
- * structure that indicates a V8 heap object.  This is a heuristic way to find
- * the V8 heap object containing a specific address.
+ * Prints the statistics for one of the caches of decoded heap objects (see
+ * v8_cache_enabled()).  "bytes" indicates whether the cache tracks the number
+ * of bytes it holds.
  */
-static int
-dcmd_v8whatis(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+static void
+v8cache_stats_print(const char *name, const v8cache_stats_t *statsp,
+    boolean_t bytes)
 {
-	size_t maxoffset = 4096;
-	boolean_t verbose = B_FALSE;
-	v8whatis_t whatis;
-	v8whatis_error_t err;
-
-	if (!(flags & DCMD_ADDRSPEC)) {
-		mdb_warn("must specify address for ::v8whatis\n");
-		return (DCMD_ERR);
+	mdb_printf("\n%<u>%-24s %16s%</u>\n", name, "VALUE");
+	mdb_printf(V8CACHE_STATFMT, "hits", (u_longlong_t)statsp->v8cs_hits);
+	mdb_printf(V8CACHE_STATFMT, "misses",
+	    (u_longlong_t)statsp->v8cs_misses);
+	mdb_printf(V8CACHE_STATFMT, "evictions",
+	    (u_longlong_t)statsp->v8cs_evictions);
+	if (bytes) {
+		mdb_printf(V8CACHE_STATFMT, "bytes cached",
+		    (u_longlong_t)statsp->v8cs_nbytes);
 	}
+}
+
+/*
+ * Report statistics about (and optionally discard the contents of) the caches
+ * used to reduce the number of reads from the target.
+ */
+/* ARGSUSED */
+static int
+dcmd_v8cache(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+{
+	boolean_t clear = B_FALSE;
+	dbi_cache_stats_t stats;
+	v8cache_stats_t sstats, lstats;
+	const char *f = V8CACHE_STATFMT;
 
 	if (mdb_getopts(argc, argv,
-	    'v', MDB_OPT_SETBITS, B_TRUE, &verbose,
-	    'd', MDB_OPT_UINTPTR, &maxoffset, NULL) != argc) {
+	    'c', MDB_OPT_SETBITS, B_TRUE, &clear, NULL) != argc)
 		return (DCMD_USAGE);
-	}
 
-	if (maxoffset > INT16_MAX) {
-		mdb_warn("warn: very large value supplied for \"-d\": %u\n",
-		    maxoffset);
+	if (clear) {
+		dbi_vread_invalidate();
+		jsobj_shape_clear();
+		v8string_cache_clear();
+		v8lineends_clear();
+		jsframe_sym_clear();
+		return (DCMD_OK);
 	}
 
-	err = v8whatis(addr, maxoffset, &whatis);
-	if (verbose && whatis.v8w_origaddr != whatis.v8w_addr) {
+	dbi_vread_stats(&stats);
+	mdb_printf("%<u>%-24s %16s%</u>\n", "PAGE CACHE", "VALUE");
+	mdb_printf(f, "mapped core reads", (u_longlong_t)stats.dcs_mapped);
+	mdb_printf(f, "page size", (u_longlong_t)stats.dcs_pagesize);
+	mdb_printf(f, "pages allocated", (u_longlong_t)stats.dcs_npages);
+	mdb_printf(f, "hits", (u_longlong_t)stats.dcs_hits);
+	mdb_printf(f, "misses", (u_longlong_t)stats.dcs_misses);
+	mdb_printf(f, "uncached reads", (u_longlong_t)stats.dcs_bypass);
+	mdb_printf(f, "unreadable page reads",
+	    (u_longlong_t)stats.dcs_unreadable);
+	mdb_printf(f, "evictions", (u_longlong_t)stats.dcs_evictions);
+	mdb_printf(f, "invalidations", (u_longlong_t)stats.dcs_invalidations);
+
+	v8cache_stats_print("MAP SHAPE CACHE", &jsobj_shape_stats, B_FALSE);
+
+	v8string_cache_stats(&sstats);
+	v8cache_stats_print("STRING CACHE", &sstats, B_TRUE);
+
+	v8lineends_stats(&lstats);
+	v8cache_stats_print("LINE ENDS CACHE", &lstats, B_TRUE);
+
+	v8cache_stats_print("FRAME CACHE", &jsframe_sym_stats, B_FALSE);
+	return (DCMD_OK);
+}
+
+/* ARGSUSED */
+static int
+dcmd_v8warnings(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+{
+	v8_warnings ^= 1;
+	mdb_printf("v8 warnings are now %s\n", v8_warnings ? "on" : "off");
+
+	return (DCMD_OK);
+}
+
+/*
+ * Print the result of v8whatis() for address "addr".
+ */
+static int
+v8whatis_print(uintptr_t addr, v8whatis_t *whatisp, v8whatis_error_t err,
+    size_t maxoffset, boolean_t verbose)
+{
+	if (verbose && whatisp->v8w_origaddr != whatisp->v8w_addr) {
 		mdb_warn("assuming heap object at %p\n", addr);
 	}
 
 	if (err == V8W_ERR_NOTFOUND) {
-		if (verbose) {
+		if (verbose && whatisp->v8w_indexed) {
+			mdb_warn("%p: no heap object found in index\n", addr);
+		} else if (verbose) {
 			mdb_warn("%p: no heap object found in previous "
 			    "%u bytes\n", addr, maxoffset);
 		}
@@ -7040,11 +9042,11 @@ dcmd_v8whatis(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 		if (verbose) {
 			mdb_warn("%p: heap object found at %p "
 			    "(%p-0x%x, type %s) does not appear to contain "
-			    "%p\n", whatis.v8w_origaddr,
-			    whatis.v8w_baseaddr,
-			    whatis.v8w_origaddr,
-			    whatis.v8w_origaddr - whatis.v8w_baseaddr,
-			    enum_lookup_str(v8_types, whatis.v8w_basetype,
+			    "%p\n", whatisp->v8w_origaddr,
+			    whatisp->v8w_baseaddr,
+			    whatisp->v8w_origaddr,
+			    whatisp->v8w_origaddr - whatisp->v8w_baseaddr,
+			    enum_lookup_str(v8_types, whatisp->v8w_basetype,
 			    "(unknown)"), addr);
 		}
 
@@ -7056,14 +9058,78 @@ dcmd_v8whatis(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
 	}
 
 	if (!verbose) {
-		mdb_printf("%p\n", whatis.v8w_baseaddr);
+		mdb_printf("%p\n", whatisp->v8w_baseaddr);
+		return (DCMD_OK);
+	}
+
+	mdb_printf("%p (found Map at %p (%p-0x%x) for type %s%s)\n",
+	    whatisp->v8w_baseaddr, whatisp->v8w_baseaddr,
+	    whatisp->v8w_origaddr,
+	    whatisp->v8w_origaddr - whatisp->v8w_baseaddr,
+	    enum_lookup_str(v8_types, whatisp->v8w_basetype, "(unknown)"),
+	    whatisp->v8w_indexed ? ", from index" : "");
+	return (DCMD_OK);
+}
+
+/*
+ * "v8whatis" scours the memory just prior to the given address looking for
+ * structure that indicates a V8 heap object.  This is a heuristic way to find
+ * the V8 heap object containing a specific address.  When invoked on the
+ * output of a pipeline, we consume the whole pipeline at once and resolve the
+ * addresses together with v8whatis_batch(), but still report the results in
+ * the order of the input.
+ */
+static int
+dcmd_v8whatis(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+{
+	size_t maxoffset = 4096;
+	boolean_t verbose = B_FALSE;
+	v8whatis_t whatis, *whatisp;
+	v8whatis_error_t err, *errs;
+	mdb_pipe_t pipein;
+	size_t i;
+	int rv;
+
+	if (!(flags & DCMD_ADDRSPEC)) {
+		mdb_warn("must specify address for ::v8whatis\n");
+		return (DCMD_ERR);
+	}
+
+	if (mdb_getopts(argc, argv,
+	    'v', MDB_OPT_SETBITS, B_TRUE, &verbose,
+	    'd', MDB_OPT_UINTPTR, &maxoffset, NULL) != argc) {
+		return (DCMD_USAGE);
+	}
+
+	if (maxoffset > INT16_MAX) {
+		mdb_warn("warn: very large value supplied for \"-d\": %u\n",
+		    maxoffset);
+	}
+
+	if (!(flags & DCMD_PIPE)) {
+		err = v8whatis(addr, maxoffset, &whatis);
+		return (v8whatis_print(addr, &whatis, err, maxoffset, verbose));
+	}
+
+	mdb_get_pipe(&pipein);
+	if (pipein.pipe_len == 0) {
 		return (DCMD_OK);
 	}
 
-	mdb_printf("%p (found Map at %p (%p-0x%x) for type %s)\n",
-	    whatis.v8w_baseaddr, whatis.v8w_baseaddr, whatis.v8w_origaddr,
-	    whatis.v8w_origaddr - whatis.v8w_baseaddr,
-	    enum_lookup_str(v8_types, whatis.v8w_basetype, "(unknown)"));
+	whatisp = mdb_alloc(pipein.pipe_len * sizeof (whatisp[0]),
+	    UM_SLEEP | UM_GC);
+	errs = mdb_alloc(pipein.pipe_len * sizeof (errs[0]), UM_SLEEP | UM_GC);
+	v8whatis_batch(pipein.pipe_data, pipein.pipe_len, maxoffset,
+	    whatisp, errs);
+
+	for (i = 0; i < pipein.pipe_len; i++) {
+		rv = v8whatis_print(pipein.pipe_data[i], &whatisp[i], errs[i],
+		    maxoffset, verbose);
+		if (rv != DCMD_OK) {
+			return (rv);
+		}
+	}
+
 	return (DCMD_OK);
 }
 
@@ -7077,9 +9143,16 @@ dcmd_v8whatis_help(void)
 "structure.  This is believed to be reasonably reliable, but it's ultimately\n"
 "heuristic and may produce the wrong output.\n"
 "\n"
+"If an object index has been built with \"::findjsobjects -i\", and the\n"
+"address falls within memory covered by the index, then the index is used to\n"
+"find the containing object directly and -d is ignored.\n"
+"\n"
 "Note that unlike other dcmds, this command accepts untagged heap addresses\n"
 "(which would normally be considered non-heap, small integer values) and \n"
-"implicitly adds the tag, allowing it to be more easily used with ::ugrep.\n");
+"implicitly adds the tag, allowing it to be more easily used with ::ugrep.\n"
+"When given many addresses in a pipeline, this command resolves them all\n"
+"together in a single pass over memory, which is much faster than resolving\n"
+"them one at a time.  Results are still printed in the order given.\n");
 
 	mdb_dec_indent(2);
 	mdb_printf("%<b>OPTIONS%</b>\n");
@@ -7197,7 +9270,13 @@ walk_jsframes_step(mdb_walk_state_t *wsp)
 	if (mdb_vread(&next, sizeof (next), addr) == -1)
 		return (WALK_ERR);
 
-	if (next == (uintptr_t)NULL)
+	/*
+	 * Callers' frames are always at higher addresses.  Code built without
+	 * frame pointers (as is common on GNU/Linux) can leave anything in the
+	 * frame pointer register, so stop if the chain doesn't make progress
+	 * rather than walking in circles.
+	 */
+	if (next == (uintptr_t)NULL || next <= addr)
 		return (WALK_DONE);
 
 	wsp->walk_addr = next;
@@ -7302,109 +9381,224 @@ walk_jsprop_step(mdb_walk_state_t *wsp)
  * MDB linkage
  */
 
+/*
+ * MDB loads this module automatically for Node programs, so fully configuring
+ * it in _mdb_init() would make every session pay for resolving the V8 metadata,
+ * even sessions that only use native commands like ::stack.  Instead,
+ * _mdb_init() only does the cheap part: it reads the V8 version, picks the
+ * configuration to use, and reports what it picked.  Resolving that
+ * configuration against the target's symbols happens the first time one of
+ * the dcmds or walkers below is used, and these wrappers make sure of that
+ * before calling the real implementation.  Since that can happen in the middle
+ * of a pipeline, it reports only failures, and only via mdb_warn().  Commands
+ * that only manage mdb_v8's own state (::v8cache, ::v8core, and ::v8warnings)
+ * don't need the metadata and don't trigger configuration; in particular,
+ * ::v8core can be used first so that configuration itself reads from the
+ * mapped core file.
+ */
+static boolean_t v8_configured;
+static v8_cfg_t *v8_config_cfgp;	/* configuration picked at load */
+static v8_cfg_t *v8_config_cachecfgp;	/* same, if loaded from the cache */
+static const char *v8_config_cachedir;	/* cache directory, if caching */
+static char v8_config_cachekey[192];	/* this build's cache key */
+
+static void
+v8_configure(void)
+{
+	if (v8_configured)
+		return;
+
+	v8_configured = B_TRUE;
+	if (v8_config_cfgp == NULL)
+		return;
+
+	if (autoconfigure(v8_config_cfgp) != 0) {
+		mdb_warn("failed to autoconfigure from target; "
+		    "commands may have incorrect results!\n");
+	} else if (v8_config_cachecfgp == NULL &&
+	    v8_config_cfgp == &v8_cfg_target && v8_config_cachedir != NULL) {
+		(void) v8cfg_cache_save(v8_config_cachedir,
+		    v8_config_cachekey);
+	}
+
+	if (v8_config_cachecfgp != NULL) {
+		v8cfg_cache_free(v8_config_cachecfgp);
+		v8_config_cachecfgp = NULL;
+	}
+}
+
+#define	V8_LAZY_DCMD(func)						\
+static int								\
+func##_lazy(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv) \
+{									\
+	v8_configure();							\
+	return (func(addr, flags, argc, argv));				\
+}
+
+#define	V8_LAZY_WALKER(func)						\
+static int								\
+func##_lazy(mdb_walk_state_t *wsp)					\
+{									\
+	v8_configure();							\
+	return (func(wsp));						\
+}
+
+V8_LAZY_DCMD(dcmd_findjsobjects)
+V8_LAZY_DCMD(dcmd_jsarray)
+V8_LAZY_DCMD(dcmd_jsclosure)
+V8_LAZY_DCMD(dcmd_jsconstructor)
+V8_LAZY_DCMD(dcmd_jsdumpall)
+V8_LAZY_DCMD(dcmd_jsfindrefs)
+V8_LAZY_DCMD(dcmd_jsframe)
+V8_LAZY_DCMD(dcmd_jsfunction)
+V8_LAZY_DCMD(dcmd_jsfunctions)
+V8_LAZY_DCMD(dcmd_jsprint)
+V8_LAZY_DCMD(dcmd_jsscripts)
+V8_LAZY_DCMD(dcmd_jssource)
+V8_LAZY_DCMD(dcmd_jsstack)
+V8_LAZY_DCMD(dcmd_nodebuffer)
+V8_LAZY_DCMD(dcmd_v8array)
+V8_LAZY_DCMD(dcmd_v8classes)
+V8_LAZY_DCMD(dcmd_v8code)
+V8_LAZY_DCMD(dcmd_v8context)
+V8_LAZY_DCMD(dcmd_v8field)
+V8_LAZY_DCMD(dcmd_v8frametypes)
+V8_LAZY_DCMD(dcmd_v8function)
+V8_LAZY_DCMD(dcmd_v8internal)
+V8_LAZY_DCMD(dcmd_v8load)
+V8_LAZY_DCMD(dcmd_v8print)
+V8_LAZY_DCMD(dcmd_v8scopeinfo)
+V8_LAZY_DCMD(dcmd_v8str)
+V8_LAZY_DCMD(dcmd_v8type)
+V8_LAZY_DCMD(dcmd_v8types)
+V8_LAZY_DCMD(dcmd_v8whatis)
+
+V8_LAZY_WALKER(walk_jselement_init)
+V8_LAZY_WALKER(walk_jsframes_init)
+V8_LAZY_WALKER(walk_jsprop_init)
+
 static const mdb_dcmd_t v8_mdb_dcmds[] = {
 	/*
 	 * Commands to inspect Node-level state
 	 */
 	{ "nodebuffer", ":[-a]",
-		"print details about the given Node Buffer", dcmd_nodebuffer },
+		"print details about the given Node Buffer",
+		dcmd_nodebuffer_lazy },
 
 	/*
 	 * Commands to inspect JavaScript-level state
 	 */
 	{ "jsarray", ":[-i]", "print elements of a JavaScript array",
-		dcmd_jsarray },
+		dcmd_jsarray_lazy },
 	{ "jsclosure", ":", "print variables referenced by a closure",
-		dcmd_jsclosure },
+		dcmd_jsclosure_lazy },
 	{ "jsconstructor", ":[-v]",
 		"print the constructor for a JavaScript object",
-		dcmd_jsconstructor },
+		dcmd_jsconstructor_lazy },
+	{ "jsdumpall", "[-u] [-d depth] [-N len] [-o file]",
+		"print all JavaScript objects", dcmd_jsdumpall_lazy,
+		dcmd_jsdumpall_help },
 	{ "jsfindrefs", ":[-dv] [-l maxdepth]",
 		"find JavaScript values referencing a value",
-		dcmd_jsfindrefs, dcmd_jsfindrefs_help },
+		dcmd_jsfindrefs_lazy, dcmd_jsfindrefs_help },
 	{ "jsframe", ":[-aiv] [-f function] [-p property] [-n numlines]",
-		"summarize a JavaScript stack frame", dcmd_jsframe },
+		"summarize a JavaScript stack frame", dcmd_jsframe_lazy },
 	{ "jsfunction", ":", "print information about a JavaScript function",
-		dcmd_jsfunction },
-	{ "jsprint", ":[-ab] [-d depth] [member]", "print a JavaScript object",
-		dcmd_jsprint },
+		dcmd_jsfunction_lazy },
+	{ "jsprint", ":[-abu] [-d depth] [member]", "print a JavaScript object",
+		dcmd_jsprint_lazy },
+	{ "jsscripts", "[-o dir]", "list or save JavaScript scripts",
+		dcmd_jsscripts_lazy, dcmd_jsscripts_help },
 	{ "jssource", ":[-n numlines]",
 		"print the source code for a JavaScript function",
-		dcmd_jssource },
-	{ "jsstack", "[-av] [-f function] [-p property] [-n numlines]",
-		"print a JavaScript stacktrace", dcmd_jsstack },
-	{ "findjsobjects", "?[-vb] [-r | -c cons | -p prop]", "find JavaScript "
-		"objects", dcmd_findjsobjects, dcmd_findjsobjects_help },
-	{ "jsfunctions", "?[-X] [-s file_filter] [-n name_filter] "
+		dcmd_jssource_lazy },
+	{ "jsstack", "[-aFjv] [-f function] [-p property] [-n numlines]",
+		"print a JavaScript stacktrace", dcmd_jsstack_lazy },
+	{ "findjsobjects", "?[-vbij] [-r | -c cons | -p prop]",
+		"find JavaScript objects", dcmd_findjsobjects_lazy,
+		dcmd_findjsobjects_help },
+	{ "jsfunctions", "?[-jX] [-s file_filter] [-n name_filter] "
 	    "[-x instr_filter]", "list JavaScript functions",
-	    dcmd_jsfunctions, dcmd_jsfunctions_help },
+	    dcmd_jsfunctions_lazy, dcmd_jsfunctions_help },
 
 	/*
 	 * Commands to inspect V8-level state
 	 */
 	{ "v8array", ":[-i]", "print elements of a V8 FixedArray",
-		dcmd_v8array },
+		dcmd_v8array_lazy },
+	{ "v8cache", "[-c]", "report (or with -c, clear) mdb_v8 read caches",
+		dcmd_v8cache },
+	{ "v8core", "[-u] [corefile]", "map core file for faster reads",
+		dcmd_v8core, dcmd_v8core_help },
 	{ "v8classes", NULL, "list known V8 heap object C++ classes",
-		dcmd_v8classes },
+		dcmd_v8classes_lazy },
 	{ "v8code", ":[-d]", "print information about a V8 Code object",
-		dcmd_v8code },
+		dcmd_v8code_lazy },
 	{ "v8context", ":[-d]", "print information about a V8 Context object",
-		dcmd_v8context },
+		dcmd_v8context_lazy },
 	{ "v8field", "classname fieldname offset",
-		"manually add a field to a given class", dcmd_v8field },
+		"manually add a field to a given class", dcmd_v8field_lazy },
 	{ "v8function", ":[-d]", "print JSFunction object details",
-		dcmd_v8function },
+		dcmd_v8function_lazy },
 	{ "v8internal", ":[fieldidx]", "print v8 object internal fields",
-		dcmd_v8internal },
+		dcmd_v8internal_lazy },
 	{ "v8load", "version", "load canned config for a specific V8 version",
-		dcmd_v8load, dcmd_v8load_help },
+		dcmd_v8load_lazy, dcmd_v8load_help },
 	{ "v8frametypes", NULL, "list known V8 frame types",
-		dcmd_v8frametypes },
+		dcmd_v8frametypes_lazy },
 	{ "v8print", ":[class]", "print a V8 heap object",
-		dcmd_v8print, dcmd_v8print_help },
-	{ "v8str", ":[-v]", "print the contents of a V8 string",
-		dcmd_v8str },
+		dcmd_v8print_lazy, dcmd_v8print_help },
+	{ "v8str", ":[-uv]", "print the contents of a V8 string",
+		dcmd_v8str_lazy },
 	{ "v8scopeinfo", ":", "print information about a V8 ScopeInfo object",
-		dcmd_v8scopeinfo },
+		dcmd_v8scopeinfo_lazy },
 	{ "v8type", ":", "print the type of a V8 heap object",
-		dcmd_v8type },
+		dcmd_v8type_lazy },
 	{ "v8types", NULL, "list known V8 heap object types",
-		dcmd_v8types },
+		dcmd_v8types_lazy },
 	{ "v8warnings", NULL, "toggle V8 warnings",
 		dcmd_v8warnings },
 	{ "v8whatis", NULL, "attempt to identify containing V8 heap object",
-		dcmd_v8whatis, dcmd_v8whatis_help },
+		dcmd_v8whatis_lazy, dcmd_v8whatis_help },
 
 	{ NULL }
 };
 
 static const mdb_walker_t v8_mdb_walkers[] = {
 	{ "jselement", "walk elements of a JavaScript array",
-		walk_jselement_init, walk_jselement_step, walk_jselement_fini },
+		walk_jselement_init_lazy, walk_jselement_step,
+		walk_jselement_fini },
 	{ "jsframe", "walk V8 JavaScript stack frames",
-		walk_jsframes_init, walk_jsframes_step },
+		walk_jsframes_init_lazy, walk_jsframes_step },
 	{ "jsprop", "walk property values for an object",
-		walk_jsprop_init, walk_jsprop_step },
+		walk_jsprop_init_lazy, walk_jsprop_step },
 	{ NULL }
 };
 
 static mdb_modinfo_t v8_mdb = { MDB_API_VERSION, v8_mdb_dcmds, v8_mdb_walkers };
 
+/*
+ * Picks the configuration to use for the target and reports it.  The
+ * configuration is resolved against the target later, by v8_configure().
+ */
 static void
 configure(void)
 {
 	char *success;
 	v8_cfg_t *cfgp = NULL;
-	GElf_Sym sym;
+	v8_cfg_t *cachecfgp = NULL;
+	const char *cachedir = NULL;
+	char fingerprint[128];
+	uintptr_t symaddr;
 	int major, minor, build, patch;
 
-	if (mdb_readsym(&major, sizeof (major),
+	if (dbi_readsym(&major, sizeof (major),
 	    "_ZN2v88internal7Version6major_E") == -1 ||
-	    mdb_readsym(&minor, sizeof (minor),
+	    dbi_readsym(&minor, sizeof (minor),
 	    "_ZN2v88internal7Version6minor_E") == -1 ||
-	    mdb_readsym(&build, sizeof (build),
+	    dbi_readsym(&build, sizeof (build),
 	    "_ZN2v88internal7Version6build_E") == -1 ||
-	    mdb_readsym(&patch, sizeof (patch),
+	    dbi_readsym(&patch, sizeof (patch),
 	    "_ZN2v88internal7Version6patch_E") == -1) {
 		mdb_warn("failed to determine V8 version");
 		return;
@@ -7421,9 +9615,34 @@ configure(void)
 	 * First look for debug metadata embedded within the binary, which may
 	 * be present in recent V8 versions built with postmortem metadata.
 	 */
-	if (mdb_lookup_by_name("v8dbg_SmiTag", &sym) == 0) {
+	if (dbi_lookup_by_name("v8dbg_SmiTag", &symaddr) == 0) {
 		cfgp = &v8_cfg_target;
 		success = "Autoconfigured V8 support from target";
+
+		/*
+		 * If the user has asked us to cache metadata, look for a saved
+		 * copy of this build's metadata before walking the symbol
+		 * table.  See "Configuration cache" in mdb_v8_cfg.c.
+		 */
+		cachedir = getenv("MDB_V8_CONFIG_CACHE");
+		if (cachedir != NULL && *cachedir != '\0' &&
+		    dbi_lookup_by_name("_ZN2v88internal7Version6major_E",
+		    &symaddr) == 0 && dbi_object_fingerprint(symaddr,
+		    fingerprint, sizeof (fingerprint)) == 0) {
+			(void) mdb_snprintf(v8_config_cachekey,
+			    sizeof (v8_config_cachekey), "%d.%d.%d.%d-%s",
+			    v8_major, v8_minor, v8_build, v8_patch,
+			    fingerprint);
+			cachecfgp = v8cfg_cache_load(cachedir,
+			    v8_config_cachekey);
+			if (cachecfgp != NULL) {
+				cfgp = cachecfgp;
+				success = "Configured V8 support from cached "
+				    "target metadata";
+			}
+		} else {
+			cachedir = NULL;
+		}
 	} else if (v8_major == 3 && v8_minor == 1 && v8_build == 8) {
 		cfgp = &v8_cfg_04;
 		success = "Configured V8 support based on node v0.4";
@@ -7436,12 +9655,9 @@ configure(void)
 		return;
 	}
 
-	if (autoconfigure(cfgp) != 0) {
-		mdb_warn("failed to autoconfigure from target; "
-		    "commands may have incorrect results!\n");
-		return;
-	}
-
+	v8_config_cfgp = cfgp;
+	v8_config_cachecfgp = cachecfgp;
+	v8_config_cachedir = cachedir;
 	mdb_printf("%s\n", success);
 }
 
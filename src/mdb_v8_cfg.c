@@ -16,15 +16,22 @@
  */
 
 #include "v8cfg.h"
+#include "mdb_v8_dbi.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/stat.h>
 
 /*ARGSUSED*/
 static int
 v8cfg_target_iter(v8_cfg_t *cfgp, int (*func)(mdb_symbol_t *, void *),
     void *arg)
 {
-	return (mdb_symbol_iter(MDB_OBJ_EVERY, MDB_DYNSYM,
-	    MDB_BIND_GLOBAL | MDB_TYPE_OBJECT | MDB_TYPE_FUNC,
-	    func, arg));
+	return (dbi_symbol_iter(func, arg));
 }
 
 /*ARGSUSED*/
@@ -33,14 +40,32 @@ v8cfg_target_readsym(v8_cfg_t *cfgp, const char *name, intptr_t *valp)
 {
 	int val, rval;
 
-	if ((rval = mdb_readsym(&val, sizeof (val), name)) != -1)
+	if ((rval = dbi_readsym(&val, sizeof (val), name)) != -1)
 		*valp = (intptr_t)val;
 
 	return (rval);
 }
 
 /*
- * Analog of mdb_symbol_iter() for a canned configuration.
+ * Like v8cfg_target_readsym(), but for a symbol passed to the callback of
+ * v8cfg_target_iter().  This avoids looking up the symbol by name again.
+ */
+/*ARGSUSED*/
+static int
+v8cfg_target_symvalue(v8_cfg_t *cfgp, mdb_symbol_t *symp, intptr_t *valp)
+{
+	int val;
+
+	if (dbi_vread(&val, sizeof (val), symp->sym_sym->st_value) == -1)
+		return (-1);
+
+	*valp = (intptr_t)val;
+	return (0);
+}
+
+/*
+ * Analog of mdb_symbol_iter() for a canned configuration.  Each symbol's
+ * "sym_id" is its index in the configuration's table.
  */
 static int
 v8cfg_canned_iter(v8_cfg_t *cfgp, int (*func)(mdb_symbol_t *, void *),
@@ -55,7 +80,7 @@ v8cfg_canned_iter(v8_cfg_t *cfgp, int (*func)(mdb_symbol_t *, void *),
 		mdbsym.sym_object = NULL;
 		mdbsym.sym_sym = NULL;
 		mdbsym.sym_table = 0;
-		mdbsym.sym_id = 0;
+		mdbsym.sym_id = v8sym - cfgp->v8cfg_symbols;
 
 		if ((rv = func(&mdbsym, arg)) != 0)
 			return (rv);
@@ -84,6 +109,16 @@ v8cfg_canned_readsym(v8_cfg_t *cfgp, const char *name, intptr_t *valp)
 	return (0);
 }
 
+/*
+ * Analog of v8cfg_target_symvalue() for a canned configuration.
+ */
+static int
+v8cfg_canned_symvalue(v8_cfg_t *cfgp, mdb_symbol_t *symp, intptr_t *valp)
+{
+	*valp = cfgp->v8cfg_symbols[symp->sym_id].v8cs_value;
+	return (0);
+}
+
 /*
  * Canned configuration for the V8 bundled with Node.js v0.4.8 and later.
  */
@@ -699,10 +734,10 @@ static v8_cfg_symbol_t v8_symbols_node_06[] = {
 };
 
 v8_cfg_t v8_cfg_04 = { "node-0.4", "node v0.4", v8_symbols_node_04,
-    v8cfg_canned_iter, v8cfg_canned_readsym };
+    v8cfg_canned_iter, v8cfg_canned_readsym, v8cfg_canned_symvalue };
 
 v8_cfg_t v8_cfg_06 = { "node-0.6", "node v0.6", v8_symbols_node_06,
-    v8cfg_canned_iter, v8cfg_canned_readsym };
+    v8cfg_canned_iter, v8cfg_canned_readsym, v8cfg_canned_symvalue };
 
 v8_cfg_t *v8_cfgs[] = {
 	&v8_cfg_04,
@@ -711,4 +746,269 @@ v8_cfg_t *v8_cfgs[] = {
 };
 
 v8_cfg_t v8_cfg_target = { NULL, NULL, NULL, v8cfg_target_iter,
-	v8cfg_target_readsym };
+	v8cfg_target_readsym, v8cfg_target_symvalue };
+
+/*
+ * Configuration cache
+ *
+ * Autoconfiguring from the target requires iterating every symbol in the node
+ * binary, which for large binaries takes much longer than everything else
+ * involved in loading the dmod.  Since the metadata for a given build never
+ * changes, we save it the first time we see a build and use it in place of the
+ * target's symbol table after that.  The saved file is just a canned
+ * configuration like the ones above: the "v8dbg_" symbols and their values,
+ * preceded by a header identifying the build they came from and describing the
+ * rest of the file:
+ *
+ *     mdb_v8 configuration cache 2
+ *     key 4.9.385.18-buildid-a0f2...
+ *     symbols 00001234 checksum 8c3f0e5ad1b27c44
+ *     v8dbg_AsciiStringTag 4
+ *     ...
+ *
+ * The checksum is a 64-bit FNV-1a hash of everything after the header.  A file
+ * that's truncated or corrupted would otherwise silently produce wrong offsets
+ * for every command, so if the symbol count or checksum doesn't match, or any
+ * line fails to parse, the whole file is ignored and we configure from the
+ * target instead (which replaces the file).
+ *
+ * Files are named after the key, so a directory of these can be shared by any
+ * number of builds.
+ */
+#define	V8CFG_CACHE_HEADER	"mdb_v8 configuration cache 2"
+#define	V8CFG_CACHE_SUMINIT	0xcbf29ce484222325ULL
+
+typedef struct v8cfg_cache {
+	v8_cfg_t	vcc_cfg;	/* configuration (must be first) */
+	char		*vcc_buf;	/* file contents (holds symbol names) */
+	size_t		vcc_bufsz;	/* size of "vcc_buf" */
+	size_t		vcc_nsymbols;	/* count of symbols in configuration */
+} v8cfg_cache_t;
+
+typedef struct v8cfg_cache_save {
+	FILE		*vcs_fp;	/* file being written */
+	uint64_t	vcs_sum;	/* checksum of symbols written */
+	size_t		vcs_nsymbols;	/* count of symbols written */
+} v8cfg_cache_save_t;
+
+static void
+v8cfg_cache_path(char *buf, size_t len, const char *dir, const char *key)
+{
+	(void) mdb_snprintf(buf, len, "%s/%s.cfg", dir, key);
+}
+
+static uint64_t
+v8cfg_cache_sum(uint64_t sum, const char *buf, size_t len)
+{
+	const uint8_t *p;
+
+	for (p = (const uint8_t *)buf; p < (const uint8_t *)buf + len; p++)
+		sum = (sum ^ *p) * 0x100000001b3ULL;
+
+	return (sum);
+}
+
+/*
+ * Splits off the next line of "*bufp", returning it (without its newline) and
+ * advancing "*bufp" past it.  Returns NULL at the end of the buffer.
+ */
+static char *
+v8cfg_cache_line(char **bufp)
+{
+	char *line = *bufp, *nl;
+
+	if (*line == '\0')
+		return (NULL);
+
+	if ((nl = strchr(line, '\n')) != NULL) {
+		*nl = '\0';
+		*bufp = nl + 1;
+	} else {
+		*bufp = line + strlen(line);
+	}
+
+	return (line);
+}
+
+/*
+ * Returns a configuration loaded from the cache file for "key" in directory
+ * "dir", or NULL if there's no valid cache file.  The caller must free the
+ * configuration with v8cfg_cache_free().
+ */
+v8_cfg_t *
+v8cfg_cache_load(const char *dir, const char *key)
+{
+	char path[MAXPATHLEN];
+	v8cfg_cache_t *vccp;
+	v8_cfg_symbol_t *v8sym;
+	struct stat st;
+	char *p, *line, *value, *end;
+	unsigned long long nsymbols, sum;
+	size_t nlines;
+	ssize_t nread;
+	long lvalue;
+	int fd;
+
+	v8cfg_cache_path(path, sizeof (path), dir, key);
+	if ((fd = open(path, O_RDONLY)) == -1)
+		return (NULL);
+
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		(void) close(fd);
+		return (NULL);
+	}
+
+	vccp = mdb_zalloc(sizeof (*vccp), UM_SLEEP);
+	vccp->vcc_bufsz = st.st_size + 1;
+	vccp->vcc_buf = mdb_zalloc(vccp->vcc_bufsz, UM_SLEEP);
+	nread = read(fd, vccp->vcc_buf, st.st_size);
+	(void) close(fd);
+	if (nread != st.st_size)
+		goto err;
+
+	/*
+	 * Validate the header, key, symbol count, and checksum before doing
+	 * anything else.  Every symbol line must end with a newline, so a file
+	 * truncated at a line boundary is caught by the count.
+	 */
+	p = vccp->vcc_buf;
+	if (strlen(p) != st.st_size ||
+	    (line = v8cfg_cache_line(&p)) == NULL ||
+	    strcmp(line, V8CFG_CACHE_HEADER) != 0 ||
+	    (line = v8cfg_cache_line(&p)) == NULL ||
+	    strncmp(line, "key ", sizeof ("key ") - 1) != 0 ||
+	    strcmp(line + sizeof ("key ") - 1, key) != 0 ||
+	    (line = v8cfg_cache_line(&p)) == NULL ||
+	    sscanf(line, "symbols %llu checksum %llx", &nsymbols, &sum) != 2 ||
+	    v8cfg_cache_sum(V8CFG_CACHE_SUMINIT, p, strlen(p)) != sum)
+		goto err;
+
+	for (nlines = 0, line = p; *line != '\0'; line++) {
+		if (*line == '\n')
+			nlines++;
+	}
+
+	if (nlines != nsymbols || (line > p && line[-1] != '\n'))
+		goto err;
+
+	vccp->vcc_nsymbols = nlines;
+	vccp->vcc_cfg.v8cfg_symbols = mdb_zalloc(
+	    (vccp->vcc_nsymbols + 1) * sizeof (v8_cfg_symbol_t), UM_SLEEP);
+	v8sym = vccp->vcc_cfg.v8cfg_symbols;
+	while ((line = v8cfg_cache_line(&p)) != NULL) {
+		if (strncmp(line, "v8dbg_", sizeof ("v8dbg_") - 1) != 0 ||
+		    (value = strchr(line, ' ')) == NULL)
+			goto err;
+
+		*value++ = '\0';
+		errno = 0;
+		lvalue = strtol(value, &end, 0);
+		if (errno != 0 || end == value || *end != '\0')
+			goto err;
+
+		v8sym->v8cs_name = line;
+		v8sym->v8cs_value = (intptr_t)lvalue;
+		v8sym++;
+	}
+
+	vccp->vcc_cfg.v8cfg_name = "cache";
+	vccp->vcc_cfg.v8cfg_label = "cached target metadata";
+	vccp->vcc_cfg.v8cfg_iter = v8cfg_canned_iter;
+	vccp->vcc_cfg.v8cfg_readsym = v8cfg_canned_readsym;
+	vccp->vcc_cfg.v8cfg_symvalue = v8cfg_canned_symvalue;
+	return (&vccp->vcc_cfg);
+
+err:
+	mdb_warn("ignoring invalid configuration cache file \"%s\"\n", path);
+	v8cfg_cache_free(&vccp->vcc_cfg);
+	return (NULL);
+}
+
+void
+v8cfg_cache_free(v8_cfg_t *cfgp)
+{
+	v8cfg_cache_t *vccp = (v8cfg_cache_t *)cfgp;
+
+	if (cfgp->v8cfg_symbols != NULL) {
+		mdb_free(cfgp->v8cfg_symbols,
+		    (vccp->vcc_nsymbols + 1) * sizeof (v8_cfg_symbol_t));
+	}
+
+	mdb_free(vccp->vcc_buf, vccp->vcc_bufsz);
+	mdb_free(vccp, sizeof (*vccp));
+}
+
+static int
+v8cfg_cache_save_symbol(mdb_symbol_t *symp, void *arg)
+{
+	v8cfg_cache_save_t *vcsp = arg;
+	char line[256];
+	intptr_t value;
+	int len;
+
+	if (strncmp(symp->sym_name, "v8dbg_", sizeof ("v8dbg_") - 1) != 0)
+		return (0);
+
+	if (v8cfg_target_symvalue(&v8_cfg_target, symp, &value) != 0) {
+		mdb_warn("failed to read symbol \"%s\"", symp->sym_name);
+		return (-1);
+	}
+
+	len = snprintf(line, sizeof (line), "%s %ld\n",
+	    symp->sym_name, (long)value);
+	if (len < 0 || len >= sizeof (line)) {
+		mdb_warn("symbol name too long: \"%s\"\n", symp->sym_name);
+		return (-1);
+	}
+
+	vcsp->vcs_sum = v8cfg_cache_sum(vcsp->vcs_sum, line, len);
+	vcsp->vcs_nsymbols++;
+	(void) fputs(line, vcsp->vcs_fp);
+	return (0);
+}
+
+/*
+ * Saves the target's metadata into the cache file for "key" in directory
+ * "dir".  The file is written under a temporary name and then renamed so that
+ * concurrent debuggers never see a partial file.  The symbol count and
+ * checksum aren't known until all of the symbols have been written, so the
+ * header is written with fixed-width placeholders and filled in afterwards.
+ */
+int
+v8cfg_cache_save(const char *dir, const char *key)
+{
+	char path[MAXPATHLEN], tmppath[MAXPATHLEN];
+	v8cfg_cache_save_t vcs;
+	FILE *fp;
+	long off;
+	int rv;
+
+	v8cfg_cache_path(path, sizeof (path), dir, key);
+	(void) mdb_snprintf(tmppath, sizeof (tmppath), "%s.%d",
+	    path, (int)getpid());
+	if ((fp = fopen(tmppath, "w")) == NULL) {
+		mdb_warn("failed to create \"%s\"", tmppath);
+		return (-1);
+	}
+
+	(void) fprintf(fp, "%s\nkey %s\n", V8CFG_CACHE_HEADER, key);
+	off = ftell(fp);
+	(void) fprintf(fp, "symbols %08zu checksum %016llx\n", (size_t)0, 0ULL);
+
+	vcs.vcs_fp = fp;
+	vcs.vcs_sum = V8CFG_CACHE_SUMINIT;
+	vcs.vcs_nsymbols = 0;
+	rv = v8cfg_target_iter(&v8_cfg_target, v8cfg_cache_save_symbol, &vcs);
+	if (rv == 0 && (off == -1 || fseek(fp, off, SEEK_SET) != 0 ||
+	    fprintf(fp, "symbols %08zu checksum %016llx\n", vcs.vcs_nsymbols,
+	    (unsigned long long)vcs.vcs_sum) < 0))
+		rv = -1;
+
+	if (fclose(fp) != 0 || rv != 0 || rename(tmppath, path) != 0) {
+		mdb_warn("failed to save configuration cache \"%s\"", path);
+		(void) unlink(tmppath);
+		return (-1);
+	}
+
+	return (0);
+}
@@ -79,6 +79,7 @@
 #define	_MDBV8DBG_H
 
 #include <stdarg.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 /*
@@ -95,6 +96,19 @@ typedef struct {
 	int	ms_memflags;	/* memory allocation flags */
 } mdbv8_strbuf_t;
 
+typedef struct mdbv8_jsonl mdbv8_jsonl_t;
+
+/*
+ * Statistics for the caches of data decoded from the target.  See
+ * v8_cache_enabled().
+ */
+typedef struct v8cache_stats {
+	uint64_t	v8cs_hits;	/* lookups satisfied from the cache */
+	uint64_t	v8cs_misses;	/* entries decoded and cached */
+	uint64_t	v8cs_evictions;	/* entries displaced by others */
+	uint64_t	v8cs_nbytes;	/* bytes cached, where tracked */
+} v8cache_stats_t;
+
 typedef struct v8fixedarray v8fixedarray_t;
 typedef struct v8string v8string_t;
 
@@ -110,6 +124,7 @@ typedef struct v8scopeinfo_var v8scopeinfo_var_t;
 typedef enum {
 	MSF_ASCIIONLY	= 0x1,			/* replace non-ASCII */
 	MSF_JSON	= MSF_ASCIIONLY | 0x2,	/* partial JSON string */
+	MSF_UTF8	= 0x4,			/* write non-ASCII as UTF-8 */
 } mdbv8_strappend_flags_t;
 
 typedef enum {
@@ -149,11 +164,31 @@ void mdbv8_strbuf_reserve(mdbv8_strbuf_t *, ssize_t);
 void mdbv8_strbuf_appendc(mdbv8_strbuf_t *, uint16_t, mdbv8_strappend_flags_t);
 void mdbv8_strbuf_appends(mdbv8_strbuf_t *, const char *,
     mdbv8_strappend_flags_t);
+void mdbv8_strbuf_appendbytes(mdbv8_strbuf_t *, const char *, size_t);
+size_t mdbv8_strbuf_appendutf16(mdbv8_strbuf_t *, const uint16_t *, size_t,
+    size_t, mdbv8_strappend_flags_t);
 void mdbv8_strbuf_sprintf(mdbv8_strbuf_t *, const char *, ...);
 void mdbv8_strbuf_vsprintf(mdbv8_strbuf_t *, const char *, va_list);
 const char *mdbv8_strbuf_tocstr(mdbv8_strbuf_t *);
 
 size_t mdbv8_strbuf_nbytesforchar(uint16_t, mdbv8_strappend_flags_t);
+size_t mdbv8_strbuf_nclean(const char *, size_t, mdbv8_strappend_flags_t);
+
+
+/*
+ * Writing "JSON lines" output: one JSON object per line.
+ */
+
+mdbv8_jsonl_t *mdbv8_jsonl_alloc(void);
+void mdbv8_jsonl_flush(mdbv8_jsonl_t *);
+
+void mdbv8_jsonl_begin(mdbv8_jsonl_t *);
+void mdbv8_jsonl_end(mdbv8_jsonl_t *);
+void mdbv8_jsonl_array_begin(mdbv8_jsonl_t *, const char *);
+void mdbv8_jsonl_array_end(mdbv8_jsonl_t *);
+void mdbv8_jsonl_string(mdbv8_jsonl_t *, const char *, const char *);
+void mdbv8_jsonl_addr(mdbv8_jsonl_t *, const char *, uintptr_t);
+void mdbv8_jsonl_uint(mdbv8_jsonl_t *, const char *, uint64_t);
 
 
 /*
@@ -192,6 +227,13 @@ void v8string_free(v8string_t *);
 size_t v8string_length(v8string_t *);
 int v8string_write(v8string_t *, mdbv8_strbuf_t *,
     mdbv8_strappend_flags_t, v8string_flags_t);
+boolean_t v8string_cache_write(uintptr_t, mdbv8_strbuf_t *,
+    mdbv8_strappend_flags_t, v8string_flags_t);
+
+void v8string_cache_stats(v8cache_stats_t *);
+void v8string_cache_clear(void);
+void v8lineends_stats(v8cache_stats_t *);
+void v8lineends_clear(void);
 
 
 /*
@@ -338,9 +380,11 @@ void v8boundfunction_free(v8boundfunction_t *);
  */
 
 /*
+ * v8heapobject_size() attempts to determine the size of a given V8 heap object.
  * v8contains() attempts to determine whether a given V8 heap object contains a
  * target address.
  */
+int v8heapobject_size(uintptr_t, uint8_t, size_t *);
 int v8contains(uintptr_t, uint8_t, uintptr_t, boolean_t *);
 
 /*
@@ -358,8 +402,27 @@ typedef struct {
 	uintptr_t	v8w_origaddr;	/* adjusted address */
 	uintptr_t	v8w_baseaddr;	/* address of containing V8 object */
 	uint8_t		v8w_basetype;	/* type of containing V8 object */
+	boolean_t	v8w_indexed;	/* result came from object index */
 } v8whatis_t;
 
 v8whatis_error_t v8whatis(uintptr_t, size_t, v8whatis_t *);
+void v8whatis_batch(const uintptr_t *, size_t, size_t, v8whatis_t *,
+    v8whatis_error_t *);
+
+/*
+ * The object-start index is an optional, sorted table of the start addresses of
+ * heap objects found during a heap scan (see ::findjsobjects -i).  When it
+ * covers the target address, v8whatis() uses it instead of probing backwards
+ * through memory.  To build the index, callers invoke v8whatis_index_begin(),
+ * then v8whatis_index_range() for each range of memory scanned followed by
+ * v8whatis_index_add() for each candidate object (and its Map) in that range,
+ * and finally v8whatis_index_finish().
+ */
+void v8whatis_index_begin(void);
+void v8whatis_index_range(uintptr_t, size_t);
+void v8whatis_index_add(uintptr_t, uintptr_t);
+void v8whatis_index_finish(void);
+boolean_t v8whatis_index_ready(void);
+size_t v8whatis_index_count(void);
 
 #endif	/* _MDBV8DBG_H */
@@ -16,8 +16,91 @@
  */
 
 #include "mdb_v8_impl.h"
+#include "mdb_v8_dbi.h"
 
+#include <fcntl.h>
 #include <libproc.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/elf.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+/*
+ * dbi_lookup_by_name(name, addrp): look up the address of the symbol "name" in
+ * the target.
+ */
+int
+dbi_lookup_by_name(const char *name, uintptr_t *addrp)
+{
+	GElf_Sym sym;
+
+	if (mdb_lookup_by_name(name, &sym) != 0)
+		return (-1);
+
+	*addrp = (uintptr_t)sym.st_value;
+	return (0);
+}
+
+/*
+ * dbi_readsym(buf, size, name): read "size" bytes at the address of symbol
+ * "name" into "buf".
+ */
+int
+dbi_readsym(void *buf, size_t size, const char *name)
+{
+	return (mdb_readsym(buf, size, name) == -1 ? -1 : 0);
+}
+
+int
+dbi_symbol_iter(int (*func)(mdb_symbol_t *, void *), void *arg)
+{
+	return (mdb_symbol_iter(MDB_OBJ_EVERY, MDB_DYNSYM,
+	    MDB_BIND_GLOBAL | MDB_TYPE_OBJECT | MDB_TYPE_FUNC, func, arg));
+}
+
+/*
+ * Describes the state of a dbi_mapping_iter() operation.
+ */
+typedef struct dbi_mapping_op {
+	int		(*dmo_callback)(const dbi_mapping_t *, void *);
+	void		*dmo_cbarg;
+} dbi_mapping_op_t;
+
+static int
+dbi_mapping_one(dbi_mapping_op_t *dmop, const prmap_t *pmp, const char *name)
+{
+	dbi_mapping_t map;
+
+	map.dm_vaddr = pmp->pr_vaddr;
+	map.dm_size = pmp->pr_size;
+	map.dm_brk = (pmp->pr_mflags & MA_BREAK) != 0;
+	map.dm_name = name;
+	return (dmop->dmo_callback(&map, dmop->dmo_cbarg));
+}
+
+/*
+ * dbi_mapping_iter(func, arg): invoke "func" for each mapping in the target's
+ * address space, stopping early if "func" returns non-zero.  Returns -1 on
+ * failure (including when "func" stops the iteration).
+ */
+int
+dbi_mapping_iter(int (*callback)(const dbi_mapping_t *, void *), void *cbarg)
+{
+	struct ps_prochandle *Pr;
+	dbi_mapping_op_t dmo;
+
+	if (mdb_get_xdata("pshandle", &Pr, sizeof (Pr)) == -1) {
+		mdb_warn("couldn't read pshandle xdata");
+		return (-1);
+	}
+
+	dmo.dmo_callback = callback;
+	dmo.dmo_cbarg = cbarg;
+	return (Pmapping_iter(Pr, (proc_map_f *)dbi_mapping_one, &dmo) != 0 ?
+	    -1 : 0);
+}
 
 /*
  * dbi_ugrep(addr, func, arg): find references to "addr" in the address space
@@ -43,20 +126,14 @@ typedef struct ugrep_op {
 	size_t		ug_bufsz;	/* size of "ug_buf" */
 } ugrep_op_t;
 
-static int ugrep_mapping(ugrep_op_t *, const prmap_t *, const char *);
+static int ugrep_mapping(const dbi_mapping_t *, void *);
 
 int
 dbi_ugrep(uintptr_t addr, int (*callback)(uintptr_t, void *), void *cbarg)
 {
-	struct ps_prochandle *Pr;
 	ugrep_op_t ugrep;
 	int err;
 
-	if (mdb_get_xdata("pshandle", &Pr, sizeof (Pr)) == -1) {
-		mdb_warn("couldn't read pshandle xdata");
-		return (-1);
-	}
-
 	ugrep.ug_addr = addr;
 	ugrep.ug_result = 0;
 	ugrep.ug_callback = callback;
@@ -64,16 +141,16 @@ dbi_ugrep(uintptr_t addr, int (*callback)(uintptr_t, void *), void *cbarg)
 	ugrep.ug_bufsz = 4096;
 	ugrep.ug_buf = mdb_zalloc(ugrep.ug_bufsz, UM_SLEEP);
 
-	err = Pmapping_iter(Pr, (proc_map_f *)ugrep_mapping, &ugrep);
+	err = dbi_mapping_iter(ugrep_mapping, &ugrep);
 	mdb_free(ugrep.ug_buf, ugrep.ug_bufsz);
 
 	return (err != 0 ? -1 : ugrep.ug_result);
 }
 
-/* ARGSUSED */
 static int
-ugrep_mapping(ugrep_op_t *ugrep, const prmap_t *pmp, const char *name)
+ugrep_mapping(const dbi_mapping_t *dmp, void *arg)
 {
+	ugrep_op_t *ugrep = arg;
 	uintptr_t chunkbase, vaddr;
 	uintptr_t *buf;
 	size_t ntoread, bufsz, nptrs, i;
@@ -81,10 +158,10 @@ ugrep_mapping(ugrep_op_t *ugrep, const prmap_t *pmp, const char *name)
 	buf = ugrep->ug_buf;
 	bufsz = ugrep->ug_bufsz;
 
-	for (chunkbase = pmp->pr_vaddr;
-	    chunkbase < pmp->pr_vaddr + pmp->pr_size; chunkbase += bufsz) {
+	for (chunkbase = dmp->dm_vaddr;
+	    chunkbase < dmp->dm_vaddr + dmp->dm_size; chunkbase += bufsz) {
 		ntoread = MIN(bufsz,
-		    pmp->pr_size - (chunkbase - pmp->pr_vaddr));
+		    dmp->dm_size - (chunkbase - dmp->dm_vaddr));
 
 		if (mdb_vread(buf, ntoread, chunkbase) == -1) {
 			/*
@@ -109,3 +186,756 @@ ugrep_mapping(ugrep_op_t *ugrep, const prmap_t *pmp, const char *name)
 
 	return (0);
 }
+
+/*
+ * dbi_object_fingerprint(addr, buf, len): write into "buf" a string that
+ * identifies the build of the object (e.g., the node executable) mapped at
+ * "addr".  If the object has a GNU build ID note, the string is based on that.
+ * Otherwise, it's based on a checksum of the object's ELF header and program
+ * headers, which describe the size and placement of every segment and so
+ * differ between builds.  Both are read from the target's memory, since the
+ * first page of an object's text mapping contains its ELF header.
+ */
+#ifndef	NT_GNU_BUILD_ID
+#define	NT_GNU_BUILD_ID	3
+#endif
+
+#ifdef _LP64
+typedef Elf64_Ehdr	dbi_ehdr_t;
+typedef Elf64_Phdr	dbi_phdr_t;
+#else
+typedef Elf32_Ehdr	dbi_ehdr_t;
+typedef Elf32_Phdr	dbi_phdr_t;
+#endif
+
+#define	DBI_MAXPHDRS	64
+#define	DBI_MAXNOTES	4096
+#define	DBI_ELFPGMASK	0xfff	/* for page-aligning segment addresses */
+
+typedef struct dbi_object_find {
+	uintptr_t	dof_addr;		/* address within object */
+	char		dof_name[MAXPATHLEN];	/* object's name */
+	uintptr_t	dof_base;		/* lowest mapping of object */
+} dbi_object_find_t;
+
+static int
+dbi_object_find_name(const dbi_mapping_t *dmp, void *arg)
+{
+	dbi_object_find_t *dofp = arg;
+
+	if (dmp->dm_name == NULL || dofp->dof_addr < dmp->dm_vaddr ||
+	    dofp->dof_addr - dmp->dm_vaddr >= dmp->dm_size)
+		return (0);
+
+	(void) strlcpy(dofp->dof_name, dmp->dm_name, sizeof (dofp->dof_name));
+	return (0);
+}
+
+static int
+dbi_object_find_base(const dbi_mapping_t *dmp, void *arg)
+{
+	dbi_object_find_t *dofp = arg;
+
+	if (dmp->dm_name != NULL && strcmp(dmp->dm_name, dofp->dof_name) == 0 &&
+	    dmp->dm_vaddr < dofp->dof_base)
+		dofp->dof_base = dmp->dm_vaddr;
+
+	return (0);
+}
+
+static boolean_t
+dbi_object_buildid(uintptr_t bias, const dbi_phdr_t *phdrs, size_t nphdrs,
+    char *buf, size_t len)
+{
+	uint8_t notes[DBI_MAXNOTES];
+	uint32_t nhdr[3];
+	size_t i, j, off, size, namesz, descsz, n;
+
+	for (i = 0; i < nphdrs; i++) {
+		if (phdrs[i].p_type != PT_NOTE)
+			continue;
+
+		size = MIN(phdrs[i].p_filesz, sizeof (notes));
+		if (mdb_vread(notes, size, bias + phdrs[i].p_vaddr) == -1)
+			continue;
+
+		for (off = 0; off + sizeof (nhdr) <= size;
+		    off += sizeof (nhdr) + namesz + descsz) {
+			bcopy(notes + off, nhdr, sizeof (nhdr));
+			namesz = (nhdr[0] + 3) & ~3;
+			descsz = (nhdr[1] + 3) & ~3;
+			if (off + sizeof (nhdr) + namesz + nhdr[1] > size)
+				break;
+
+			if (nhdr[2] != NT_GNU_BUILD_ID || nhdr[0] != 4 ||
+			    strcmp((char *)notes + off + sizeof (nhdr),
+			    "GNU") != 0)
+				continue;
+
+			n = mdb_snprintf(buf, len, "buildid-");
+			for (j = 0; j < nhdr[1] && n < len; j++) {
+				n += mdb_snprintf(buf + n, len - n, "%02x",
+				    notes[off + sizeof (nhdr) + namesz + j]);
+			}
+
+			return (n < len);
+		}
+	}
+
+	return (B_FALSE);
+}
+
+int
+dbi_object_fingerprint(uintptr_t addr, char *buf, size_t len)
+{
+	dbi_object_find_t dof;
+	dbi_ehdr_t ehdr;
+	dbi_phdr_t phdrs[DBI_MAXPHDRS];
+	uintptr_t bias, lowest;
+	uint64_t sum;
+	const uint8_t *p;
+	size_t i, nphdrs;
+
+	bzero(&dof, sizeof (dof));
+	dof.dof_addr = addr;
+	dof.dof_base = (uintptr_t)-1;
+	if (dbi_mapping_iter(dbi_object_find_name, &dof) != 0 ||
+	    dof.dof_name[0] == '\0' ||
+	    dbi_mapping_iter(dbi_object_find_base, &dof) != 0)
+		return (-1);
+
+	if (mdb_vread(&ehdr, sizeof (ehdr), dof.dof_base) == -1 ||
+	    bcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+	    ehdr.e_phentsize != sizeof (dbi_phdr_t) ||
+	    ehdr.e_phnum == 0 || ehdr.e_phnum > DBI_MAXPHDRS)
+		return (-1);
+
+	nphdrs = ehdr.e_phnum;
+	if (mdb_vread(phdrs, nphdrs * sizeof (dbi_phdr_t),
+	    dof.dof_base + ehdr.e_phoff) == -1)
+		return (-1);
+
+	/*
+	 * For position-independent objects, the note's address needs to be
+	 * adjusted by the difference between where the first loadable segment
+	 * was mapped and the address it was linked at.
+	 */
+	lowest = (uintptr_t)-1;
+	for (i = 0; i < nphdrs; i++) {
+		if (phdrs[i].p_type == PT_LOAD && phdrs[i].p_vaddr < lowest)
+			lowest = phdrs[i].p_vaddr;
+	}
+
+	if (lowest == (uintptr_t)-1)
+		return (-1);
+
+	bias = dof.dof_base - (lowest & ~(uintptr_t)DBI_ELFPGMASK);
+	if (dbi_object_buildid(bias, phdrs, nphdrs, buf, len))
+		return (0);
+
+	/*
+	 * There's no build ID, so fall back to a checksum (64-bit FNV-1a) of
+	 * the headers.
+	 */
+	sum = 0xcbf29ce484222325ULL;
+	for (p = (const uint8_t *)&ehdr; p < (const uint8_t *)(&ehdr + 1); p++)
+		sum = (sum ^ *p) * 0x100000001b3ULL;
+	for (p = (const uint8_t *)phdrs;
+	    p < (const uint8_t *)(phdrs + nphdrs); p++)
+		sum = (sum ^ *p) * 0x100000001b3ULL;
+
+	(void) mdb_snprintf(buf, len, "elf-%016llx", (u_longlong_t)sum);
+	return (0);
+}
+
+/*
+ * dbi_vread(buf, size, addr): read "size" bytes at "addr" in the target into
+ * "buf".  This is the interface that the low-level heap readers (e.g.,
+ * read_heap_ptr() and read_typebyte()) use.  Printing even a modest object
+ * graph involves thousands of these reads, each only a few bytes, and nearly
+ * all of them hit a small number of pages.  To avoid a round-trip through the
+ * debugger for each one, we keep an LRU cache of fixed-size pages of the
+ * target's address space.  Reads larger than a page bypass the cache.
+ *
+ * Pages that can't be read as a whole (e.g., because they're at the edge of a
+ * mapping or not present in the core file) are remembered in a small
+ * direct-mapped table of unreadable pages, so that reads within them go
+ * straight to mdb_vread() without first attempting to fill the page again.
+ *
+ * Cached pages are only valid as long as the target's memory doesn't change,
+ * so we only use the cache for core files.  For live targets, reads go
+ * straight to mdb_vread().  dbi_vread_invalidate() discards the contents of
+ * the cache, and should be used whenever the target's memory may have changed.
+ */
+#define	DBI_PAGESHIFT	16
+#define	DBI_PAGESIZE	(1 << DBI_PAGESHIFT)
+#define	DBI_PAGEMASK	(~((uintptr_t)DBI_PAGESIZE - 1))
+#define	DBI_NPAGES	64
+#define	DBI_NBUCKETS	128
+#define	DBI_NUNREADABLE	256
+
+typedef struct dbi_page {
+	uintptr_t	dp_addr;	/* address of page in target */
+	boolean_t	dp_valid;	/* page contents are valid */
+	uint8_t		*dp_data;	/* contents of page */
+	struct dbi_page	*dp_hnext;	/* next page in hash bucket */
+	struct dbi_page	*dp_lprev;	/* more recently used page */
+	struct dbi_page	*dp_lnext;	/* less recently used page */
+} dbi_page_t;
+
+typedef struct dbi_cache {
+	dbi_page_t	*dc_buckets[DBI_NBUCKETS];	/* hash table */
+	dbi_page_t	*dc_mru;	/* most recently used page */
+	dbi_page_t	*dc_lru;	/* least recently used page */
+	size_t		dc_npages;	/* number of pages allocated */
+	uintptr_t	dc_unreadable[DBI_NUNREADABLE]; /* see below */
+	dbi_cache_stats_t dc_stats;	/* statistics */
+} dbi_cache_t;
+
+static dbi_cache_t dbi_cache;
+
+/*
+ * Entries in dc_unreadable are the addresses of pages that could not be read,
+ * with the low bit set to distinguish them from empty slots.  (Page addresses
+ * are always aligned, so the low bit is otherwise unused.)
+ */
+static uintptr_t *
+dbi_cache_unreadable(uintptr_t pageaddr)
+{
+	return (&dbi_cache.dc_unreadable[
+	    (pageaddr >> DBI_PAGESHIFT) % DBI_NUNREADABLE]);
+}
+
+static dbi_page_t **
+dbi_cache_bucket(uintptr_t pageaddr)
+{
+	return (&dbi_cache.dc_buckets[
+	    (pageaddr >> DBI_PAGESHIFT) % DBI_NBUCKETS]);
+}
+
+static void
+dbi_cache_lru_remove(dbi_page_t *dpp)
+{
+	dbi_cache_t *dcp = &dbi_cache;
+
+	if (dpp->dp_lprev != NULL)
+		dpp->dp_lprev->dp_lnext = dpp->dp_lnext;
+	else
+		dcp->dc_mru = dpp->dp_lnext;
+
+	if (dpp->dp_lnext != NULL)
+		dpp->dp_lnext->dp_lprev = dpp->dp_lprev;
+	else
+		dcp->dc_lru = dpp->dp_lprev;
+
+	dpp->dp_lprev = dpp->dp_lnext = NULL;
+}
+
+static void
+dbi_cache_lru_insert(dbi_page_t *dpp)
+{
+	dbi_cache_t *dcp = &dbi_cache;
+
+	dpp->dp_lprev = NULL;
+	dpp->dp_lnext = dcp->dc_mru;
+	if (dcp->dc_mru != NULL)
+		dcp->dc_mru->dp_lprev = dpp;
+	dcp->dc_mru = dpp;
+	if (dcp->dc_lru == NULL)
+		dcp->dc_lru = dpp;
+}
+
+static void
+dbi_cache_hash_remove(dbi_page_t *dpp)
+{
+	dbi_page_t **dppp;
+
+	for (dppp = dbi_cache_bucket(dpp->dp_addr); *dppp != NULL;
+	    dppp = &(*dppp)->dp_hnext) {
+		if (*dppp == dpp) {
+			*dppp = dpp->dp_hnext;
+			break;
+		}
+	}
+
+	dpp->dp_hnext = NULL;
+}
+
+/*
+ * Returns the cached page containing "pageaddr", reading it in if necessary.
+ * Returns NULL if the page could not be read, either now or previously.
+ *
+ * Invalid pages are always kept at the LRU end of the list, so that they're
+ * reused before any valid page is evicted and before another page is
+ * allocated.
+ */
+static dbi_page_t *
+dbi_cache_page(uintptr_t pageaddr)
+{
+	dbi_cache_t *dcp = &dbi_cache;
+	dbi_page_t *dpp, **bucketp;
+	uintptr_t *unreadablep;
+
+	if (dcp->dc_mru != NULL && dcp->dc_mru->dp_valid &&
+	    dcp->dc_mru->dp_addr == pageaddr) {
+		dcp->dc_stats.dcs_hits++;
+		return (dcp->dc_mru);
+	}
+
+	bucketp = dbi_cache_bucket(pageaddr);
+	for (dpp = *bucketp; dpp != NULL; dpp = dpp->dp_hnext) {
+		if (dpp->dp_addr == pageaddr) {
+			dcp->dc_stats.dcs_hits++;
+			dbi_cache_lru_remove(dpp);
+			dbi_cache_lru_insert(dpp);
+			return (dpp);
+		}
+	}
+
+	unreadablep = dbi_cache_unreadable(pageaddr);
+	if (*unreadablep == (pageaddr | 1)) {
+		dcp->dc_stats.dcs_unreadable++;
+		return (NULL);
+	}
+
+	dcp->dc_stats.dcs_misses++;
+
+	if (dcp->dc_lru != NULL && !dcp->dc_lru->dp_valid) {
+		dpp = dcp->dc_lru;
+		dbi_cache_lru_remove(dpp);
+	} else if (dcp->dc_npages < DBI_NPAGES) {
+		dpp = mdb_zalloc(sizeof (*dpp), UM_SLEEP);
+		dpp->dp_data = mdb_alloc(DBI_PAGESIZE, UM_SLEEP);
+		dcp->dc_npages++;
+	} else {
+		dpp = dcp->dc_lru;
+		dbi_cache_lru_remove(dpp);
+		dbi_cache_hash_remove(dpp);
+		dpp->dp_valid = B_FALSE;
+		dcp->dc_stats.dcs_evictions++;
+	}
+
+	/*
+	 * If we can't read the whole page, remember that, and put the page
+	 * back at the LRU end of the list so that it gets reused next.  The
+	 * caller will read directly from the target instead.
+	 */
+	if (mdb_vread(dpp->dp_data, DBI_PAGESIZE, pageaddr) == -1) {
+		*unreadablep = pageaddr | 1;
+		dpp->dp_lprev = dcp->dc_lru;
+		dpp->dp_lnext = NULL;
+		if (dcp->dc_lru != NULL)
+			dcp->dc_lru->dp_lnext = dpp;
+		dcp->dc_lru = dpp;
+		if (dcp->dc_mru == NULL)
+			dcp->dc_mru = dpp;
+		return (NULL);
+	}
+
+	dpp->dp_addr = pageaddr;
+	dpp->dp_valid = B_TRUE;
+	dpp->dp_hnext = *bucketp;
+	*bucketp = dpp;
+	dbi_cache_lru_insert(dpp);
+	return (dpp);
+}
+
+ssize_t
+dbi_vread(void *buf, size_t size, uintptr_t addr)
+{
+	dbi_page_t *dpp;
+	uintptr_t pageaddr;
+	size_t off, nbytes, done;
+	const void *src;
+
+	if ((src = dbi_vptr(addr, size)) != NULL) {
+		dbi_cache.dc_stats.dcs_mapped++;
+		bcopy(src, buf, size);
+		return (size);
+	}
+
+	if (size > DBI_PAGESIZE || mdb_get_state() != MDB_STATE_DEAD) {
+		dbi_cache.dc_stats.dcs_bypass++;
+		return (mdb_vread(buf, size, addr));
+	}
+
+	/*
+	 * A read may span two pages.  If either page can't be read as a whole,
+	 * just read the requested bytes directly.
+	 */
+	for (done = 0; done < size; done += nbytes) {
+		pageaddr = (addr + done) & DBI_PAGEMASK;
+		off = addr + done - pageaddr;
+		nbytes = MIN(size - done, DBI_PAGESIZE - off);
+
+		if ((dpp = dbi_cache_page(pageaddr)) == NULL) {
+			return (mdb_vread(buf, size, addr));
+		}
+
+		bcopy(dpp->dp_data + off, (uint8_t *)buf + done, nbytes);
+	}
+
+	return (size);
+}
+
+/*
+ * Discard all cached pages, along with the record of unreadable pages.  The
+ * memory for the pages themselves is retained for reuse.  Since every page is
+ * now invalid, the list trivially has all invalid pages at its LRU end.
+ */
+void
+dbi_vread_invalidate(void)
+{
+	dbi_cache_t *dcp = &dbi_cache;
+	dbi_page_t *dpp;
+
+	bzero(dcp->dc_buckets, sizeof (dcp->dc_buckets));
+	bzero(dcp->dc_unreadable, sizeof (dcp->dc_unreadable));
+	for (dpp = dcp->dc_mru; dpp != NULL; dpp = dpp->dp_lnext) {
+		dpp->dp_valid = B_FALSE;
+		dpp->dp_hnext = NULL;
+	}
+
+	dcp->dc_stats.dcs_invalidations++;
+}
+
+void
+dbi_vread_stats(dbi_cache_stats_t *statsp)
+{
+	*statsp = dbi_cache.dc_stats;
+	statsp->dcs_npages = dbi_cache.dc_npages;
+	statsp->dcs_pagesize = DBI_PAGESIZE;
+}
+
+/*
+ * Support for reading directly from a mapped core file.  A core file's memory
+ * contents are described by its PT_LOAD program headers, each of which maps a
+ * range of the file onto a range of the target's address space.  (Segments may
+ * be only partly present in the file, or not at all, depending on the core
+ * file content settings when it was created.)  We record the part of each
+ * segment that's present in the file, sorted by address.
+ */
+typedef struct dbi_segment {
+	uintptr_t	ds_vaddr;	/* start of segment in target */
+	size_t		ds_size;	/* bytes of segment present in file */
+	const uint8_t	*ds_data;	/* segment contents (in our mapping) */
+} dbi_segment_t;
+
+typedef struct dbi_core {
+	char		*dco_path;	/* path to core file */
+	size_t		dco_pathlen;	/* size of "dco_path" buffer */
+	void		*dco_base;	/* base of mapping (NULL if unmapped) */
+	size_t		dco_size;	/* size of mapping */
+	dbi_segment_t	*dco_segs;	/* segments, sorted by address */
+	size_t		dco_nsegs;	/* number of segments */
+	size_t		dco_maxsegs;	/* number of segments allocated */
+	dbi_segment_t	*dco_last;	/* most recently used segment */
+} dbi_core_t;
+
+static dbi_core_t dbi_core;
+
+static int
+dbi_core_cmp_segments(const void *l, const void *r)
+{
+	const dbi_segment_t *lhs = l;
+	const dbi_segment_t *rhs = r;
+
+	if (lhs->ds_vaddr < rhs->ds_vaddr)
+		return (-1);
+
+	return (lhs->ds_vaddr > rhs->ds_vaddr ? 1 : 0);
+}
+
+/*
+ * Record a PT_LOAD segment of the core file, if its contents are present in the
+ * file.  Returns -1 if the segment describes data outside the file.
+ */
+static int
+dbi_core_segment(dbi_core_t *dcp, uint64_t vaddr, uint64_t offset,
+    uint64_t filesz)
+{
+	dbi_segment_t *dsp;
+
+	if (filesz == 0) {
+		return (0);
+	}
+
+	if (offset > dcp->dco_size || filesz > dcp->dco_size - offset ||
+	    vaddr > UINTPTR_MAX || filesz - 1 > UINTPTR_MAX - vaddr) {
+		return (-1);
+	}
+
+	dsp = &dcp->dco_segs[dcp->dco_nsegs++];
+	dsp->ds_vaddr = (uintptr_t)vaddr;
+	dsp->ds_size = (size_t)filesz;
+	dsp->ds_data = (const uint8_t *)dcp->dco_base + offset;
+	return (0);
+}
+
+/*
+ * Parse the ELF program headers of the mapped core file, filling in the
+ * segment table.  We support whichever ELF class matches our own data model,
+ * since that's the only kind of target we can debug anyway.
+ */
+static int
+dbi_core_parse(dbi_core_t *dcp)
+{
+	const uint8_t *base = dcp->dco_base;
+	uint64_t phoff;
+	size_t i, phnum, phentsize;
+	int class;
+
+	if (dcp->dco_size < EI_NIDENT ||
+	    bcmp(base, ELFMAG, SELFMAG) != 0) {
+		mdb_warn("not an ELF file\n");
+		return (-1);
+	}
+
+	class = sizeof (uintptr_t) == 8 ? ELFCLASS64 : ELFCLASS32;
+	if (base[EI_CLASS] != class) {
+		mdb_warn("ELF class does not match debugger module\n");
+		return (-1);
+	}
+
+	if (class == ELFCLASS64) {
+		const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)base;
+
+		if (dcp->dco_size < sizeof (*ehdr)) {
+			mdb_warn("ELF header is truncated\n");
+			return (-1);
+		}
+
+		if (ehdr->e_type != ET_CORE) {
+			mdb_warn("not an ELF core file\n");
+			return (-1);
+		}
+
+		phoff = ehdr->e_phoff;
+		phnum = ehdr->e_phnum;
+		phentsize = ehdr->e_phentsize;
+		if (phentsize < sizeof (Elf64_Phdr))
+			phnum = 0;
+	} else {
+		const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *)base;
+
+		if (dcp->dco_size < sizeof (*ehdr)) {
+			mdb_warn("ELF header is truncated\n");
+			return (-1);
+		}
+
+		if (ehdr->e_type != ET_CORE) {
+			mdb_warn("not an ELF core file\n");
+			return (-1);
+		}
+
+		phoff = ehdr->e_phoff;
+		phnum = ehdr->e_phnum;
+		phentsize = ehdr->e_phentsize;
+		if (phentsize < sizeof (Elf32_Phdr))
+			phnum = 0;
+	}
+
+	if (phnum == 0 || phoff > dcp->dco_size ||
+	    phnum * phentsize > dcp->dco_size - phoff) {
+		mdb_warn("ELF program headers are missing or truncated\n");
+		return (-1);
+	}
+
+	dcp->dco_maxsegs = phnum;
+	dcp->dco_segs = mdb_zalloc(phnum * sizeof (dcp->dco_segs[0]),
+	    UM_SLEEP);
+	for (i = 0; i < phnum; i++) {
+		const uint8_t *php = base + phoff + i * phentsize;
+		int rv = 0;
+
+		if (class == ELFCLASS64) {
+			const Elf64_Phdr *phdr = (const Elf64_Phdr *)php;
+			if (phdr->p_type == PT_LOAD) {
+				rv = dbi_core_segment(dcp, phdr->p_vaddr,
+				    phdr->p_offset, phdr->p_filesz);
+			}
+		} else {
+			const Elf32_Phdr *phdr = (const Elf32_Phdr *)php;
+			if (phdr->p_type == PT_LOAD) {
+				rv = dbi_core_segment(dcp, phdr->p_vaddr,
+				    phdr->p_offset, phdr->p_filesz);
+			}
+		}
+
+		if (rv != 0) {
+			mdb_warn("segment %d extends past end of file\n",
+			    (int)i);
+			return (-1);
+		}
+	}
+
+	qsort(dcp->dco_segs, dcp->dco_nsegs, sizeof (dcp->dco_segs[0]),
+	    dbi_core_cmp_segments);
+	return (0);
+}
+
+/*
+ * Make sure that the mapped core file actually describes the target that we're
+ * debugging by comparing the start of several segments with what the debugger
+ * reads from the same addresses.
+ */
+static int
+dbi_core_verify(dbi_core_t *dcp)
+{
+	uint8_t buf[256];
+	size_t i, nbytes, nchecked;
+	dbi_segment_t *dsp;
+
+	for (i = 0, nchecked = 0; i < dcp->dco_nsegs && nchecked < 8; i++) {
+		dsp = &dcp->dco_segs[i];
+		nbytes = MIN(sizeof (buf), dsp->ds_size);
+		if (mdb_vread(buf, nbytes, dsp->ds_vaddr) == -1) {
+			continue;
+		}
+
+		if (bcmp(buf, dsp->ds_data, nbytes) != 0) {
+			mdb_warn("contents at %p do not match target\n",
+			    dsp->ds_vaddr);
+			return (-1);
+		}
+
+		nchecked++;
+	}
+
+	if (nchecked == 0) {
+		mdb_warn("found no segments in common with target\n");
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Map the core file at "path" for use by dbi_vptr().  The target must be a
+ * core file, and "path" must be the same core file that the debugger is
+ * examining.
+ */
+int
+dbi_core_open(const char *path)
+{
+	dbi_core_t *dcp = &dbi_core;
+	struct stat st;
+	int fd;
+
+	if (mdb_get_state() != MDB_STATE_DEAD) {
+		mdb_warn("target is not a core file\n");
+		return (-1);
+	}
+
+	dbi_core_close();
+
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		mdb_warn("failed to open \"%s\"", path);
+		return (-1);
+	}
+
+	if (fstat(fd, &st) != 0) {
+		mdb_warn("failed to stat \"%s\"", path);
+		(void) close(fd);
+		return (-1);
+	}
+
+	dcp->dco_size = st.st_size;
+	dcp->dco_base = mmap(NULL, dcp->dco_size, PROT_READ, MAP_PRIVATE,
+	    fd, 0);
+	(void) close(fd);
+	if (dcp->dco_base == MAP_FAILED) {
+		mdb_warn("failed to map \"%s\"", path);
+		dcp->dco_base = NULL;
+		dcp->dco_size = 0;
+		return (-1);
+	}
+
+	if (dbi_core_parse(dcp) != 0 || dbi_core_verify(dcp) != 0) {
+		mdb_warn("not using \"%s\"\n", path);
+		dbi_core_close();
+		return (-1);
+	}
+
+	dcp->dco_pathlen = strlen(path) + 1;
+	dcp->dco_path = mdb_alloc(dcp->dco_pathlen, UM_SLEEP);
+	(void) strlcpy(dcp->dco_path, path, dcp->dco_pathlen);
+
+	/*
+	 * Anything in the page cache was read through the debugger, and is
+	 * identical to what's in the mapping, but there's no sense keeping it.
+	 */
+	dbi_vread_invalidate();
+	return (0);
+}
+
+/*
+ * Unmap any mapped core file.
+ */
+void
+dbi_core_close(void)
+{
+	dbi_core_t *dcp = &dbi_core;
+
+	if (dcp->dco_base != NULL) {
+		(void) munmap(dcp->dco_base, dcp->dco_size);
+	}
+
+	maybefree(dcp->dco_segs, dcp->dco_maxsegs * sizeof (dcp->dco_segs[0]),
+	    UM_SLEEP);
+	maybefree(dcp->dco_path, dcp->dco_pathlen, UM_SLEEP);
+	bzero(dcp, sizeof (*dcp));
+}
+
+/*
+ * Returns the path to the mapped core file, or NULL if there is none.
+ */
+const char *
+dbi_core_path(void)
+{
+	return (dbi_core.dco_path);
+}
+
+const void *
+dbi_vptr(uintptr_t addr, size_t size)
+{
+	dbi_core_t *dcp = &dbi_core;
+	dbi_segment_t *dsp;
+	size_t lower, upper, mid;
+
+	if (dcp->dco_base == NULL) {
+		return (NULL);
+	}
+
+	dsp = dcp->dco_last;
+	if (dsp == NULL || addr < dsp->ds_vaddr ||
+	    addr - dsp->ds_vaddr >= dsp->ds_size) {
+		lower = 0;
+		upper = dcp->dco_nsegs;
+		while (lower < upper) {
+			mid = (lower + upper) / 2;
+			if (dcp->dco_segs[mid].ds_vaddr <= addr) {
+				lower = mid + 1;
+			} else {
+				upper = mid;
+			}
+		}
+
+		if (lower == 0) {
+			return (NULL);
+		}
+
+		dsp = &dcp->dco_segs[lower - 1];
+		if (addr - dsp->ds_vaddr >= dsp->ds_size) {
+			return (NULL);
+		}
+
+		dcp->dco_last = dsp;
+	}
+
+	if (size > dsp->ds_size - (addr - dsp->ds_vaddr)) {
+		return (NULL);
+	}
+
+	return (dsp->ds_data + (addr - dsp->ds_vaddr));
+}
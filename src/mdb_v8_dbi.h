@@ -18,4 +18,66 @@
 
 int dbi_ugrep(uintptr_t, int (*func)(uintptr_t, void *), void *);
 
+/*
+ * Target symbols and mappings.  These are the only facilities besides reading
+ * memory that the heap and stack analysis code needs from the debugger, and
+ * they're provided here (rather than by calling libproc or the module API
+ * directly) so that the same code can be driven by a program other than mdb
+ * (see src/standalone).
+ *
+ * dbi_symbol_iter() iterates the global data and function symbols in the
+ * dynamic symbol tables of all loaded objects.  dbi_mapping_iter() iterates
+ * the mappings of the target's address space.
+ */
+typedef struct dbi_mapping {
+	uintptr_t	dm_vaddr;	/* start of mapping */
+	size_t		dm_size;	/* size of mapping */
+	boolean_t	dm_brk;		/* mapping is the process heap */
+	const char	*dm_name;	/* mapped object (NULL if anonymous) */
+} dbi_mapping_t;
+
+int dbi_lookup_by_name(const char *, uintptr_t *);
+int dbi_readsym(void *, size_t, const char *);
+int dbi_symbol_iter(int (*)(mdb_symbol_t *, void *), void *);
+int dbi_mapping_iter(int (*)(const dbi_mapping_t *, void *), void *);
+
+/*
+ * dbi_object_fingerprint() identifies the build of the object (executable or
+ * library) containing a given address, using its GNU build ID if it has one.
+ */
+int dbi_object_fingerprint(uintptr_t, char *, size_t);
+
+/*
+ * dbi_vread() is equivalent to mdb_vread(), but small reads are satisfied from
+ * a cache of recently-read pages of the target's address space.
+ */
+typedef struct {
+	uint64_t	dcs_mapped;	/* reads satisfied from mapped core */
+	uint64_t	dcs_hits;	/* reads satisfied from the cache */
+	uint64_t	dcs_misses;	/* reads that required reading a page */
+	uint64_t	dcs_bypass;	/* reads not eligible for caching */
+	uint64_t	dcs_unreadable;	/* reads from known-unreadable pages */
+	uint64_t	dcs_evictions;	/* pages evicted to make room */
+	uint64_t	dcs_invalidations; /* calls to dbi_vread_invalidate() */
+	size_t		dcs_npages;	/* pages currently cached */
+	size_t		dcs_pagesize;	/* size of each page */
+} dbi_cache_stats_t;
+
+ssize_t dbi_vread(void *, size_t, uintptr_t);
+void dbi_vread_invalidate(void);
+void dbi_vread_stats(dbi_cache_stats_t *);
+
+/*
+ * When debugging a core file, the core file itself can be mapped directly into
+ * our address space with dbi_core_open().  After that, dbi_vptr() returns a
+ * read-only pointer to the contents of target memory (without copying it) when
+ * the requested range is wholly contained within one segment of the core file.
+ * Otherwise (including for live targets), it returns NULL, and the caller must
+ * fall back to dbi_vread().
+ */
+int dbi_core_open(const char *);
+void dbi_core_close(void);
+const char *dbi_core_path(void);
+const void *dbi_vptr(uintptr_t, size_t);
+
 #endif	/* _MDBV8DBI_H */
@@ -29,6 +29,7 @@ struct v8function {
 	uintptr_t	v8func_addr;		/* address in target proc */
 	int		v8func_memflags;	/* allocation flags */
 	uintptr_t	v8func_shared;		/* SharedFunctionInfo */
+	uintptr_t	v8func_context;		/* Context (0 if unknown) */
 };
 
 struct v8funcinfo {
@@ -50,6 +51,26 @@ struct v8code {
 	uintptr_t	v8code_instr_size;	/* size of instructions */
 };
 
+/*
+ * Line endings tables: see v8lineends_lineno() for details.
+ */
+typedef struct v8lineends {
+	uintptr_t		v8le_addr;	/* address of FixedArray */
+	uintptr_t		*v8le_data;	/* copied-in contents */
+	size_t			v8le_nents;	/* count of entries */
+	struct v8lineends	*v8le_hnext;	/* next in hash bucket */
+	struct v8lineends	*v8le_prev;	/* more recently used */
+	struct v8lineends	*v8le_next;	/* less recently used */
+} v8lineends_t;
+
+#define	V8LINEENDS_NBUCKETS	1024
+#define	V8LINEENDS_MAXBYTES	(16 * 1024 * 1024)
+
+static v8lineends_t *v8lineends_hash[V8LINEENDS_NBUCKETS];
+static v8lineends_t *v8lineends_mru;
+static v8lineends_t *v8lineends_lru;
+static v8cache_stats_t v8lineends_stats_cur;
+
 struct v8context {
 	uintptr_t	v8ctx_addr;	/* context address in target process */
 	int		v8ctx_memflags;	/* memory allocation flags */
@@ -174,11 +195,18 @@ static v8boundfunction_t *v8boundfunction_load_direct(uintptr_t, int);
 v8function_t *
 v8function_load(uintptr_t addr, int memflags)
 {
+	v8header_t hdr;
 	uint8_t type;
-	uintptr_t shared;
+	uintptr_t shared, context;
 	v8function_t *funcp;
 
-	if (!V8_IS_HEAPOBJECT(addr) || read_typebyte(&type, addr) != 0) {
+	if (!V8_IS_HEAPOBJECT(addr)) {
+		v8_warn("%p: not a heap object\n", addr);
+		return (NULL);
+	}
+
+	read_heap_header(&hdr, addr, V8_SIZE_JSFUNCTION);
+	if (read_header_typebyte(&type, &hdr) != 0) {
 		v8_warn("%p: not a heap object\n", addr);
 		return (NULL);
 	}
@@ -188,7 +216,7 @@ v8function_load(uintptr_t addr, int memflags)
 		return (NULL);
 	}
 
-	if (read_heap_ptr(&shared, addr, V8_OFF_JSFUNCTION_SHARED) != 0) {
+	if (read_header_ptr(&shared, &hdr, V8_OFF_JSFUNCTION_SHARED) != 0) {
 		v8_warn("%p: no SharedFunctionInfo\n", addr);
 		return (NULL);
 	}
@@ -197,9 +225,17 @@ v8function_load(uintptr_t addr, int memflags)
 		return (NULL);
 	}
 
+	/*
+	 * The context is usually in the header we've already read.  If not,
+	 * leave it for v8function_context() to read if it's needed.
+	 */
 	funcp->v8func_addr = addr;
 	funcp->v8func_memflags = memflags;
 	funcp->v8func_shared = shared;
+	if (hdr.vh_size >= V8_OFF_JSFUNCTION_CONTEXT - V8_OFF_HEAP(0) +
+	    sizeof (uintptr_t) && read_header_ptr(&context, &hdr,
+	    V8_OFF_JSFUNCTION_CONTEXT) == 0)
+		funcp->v8func_context = context;
 	return (funcp);
 }
 
@@ -229,7 +265,8 @@ v8function_context(v8function_t *funcp, int memflags)
 	uintptr_t addr, context;
 
 	addr = funcp->v8func_addr;
-	if (read_heap_ptr(&context, addr, V8_OFF_JSFUNCTION_CONTEXT) != 0) {
+	if ((context = funcp->v8func_context) == 0 &&
+	    read_heap_ptr(&context, addr, V8_OFF_JSFUNCTION_CONTEXT) != 0) {
 		v8_warn("%p: failed to read context\n", addr);
 		return (NULL);
 	}
@@ -253,16 +290,14 @@ v8function_context(v8function_t *funcp, int memflags)
 v8scopeinfo_t *
 v8function_scopeinfo(v8function_t *funcp, int memflags)
 {
-	uintptr_t closure, shared, scopeinfo;
+	uintptr_t scopeinfo;
 
 	if (V8_OFF_SHAREDFUNCTIONINFO_SCOPE_INFO == -1) {
 		v8_warn("could not find \"scope_info\"");
 		return (NULL);
 	}
 
-	closure = funcp->v8func_addr;
-	if (read_heap_ptr(&shared, closure, V8_OFF_JSFUNCTION_SHARED) != 0 ||
-	    read_heap_ptr(&scopeinfo, shared,
+	if (read_heap_ptr(&scopeinfo, funcp->v8func_shared,
 	    V8_OFF_SHAREDFUNCTIONINFO_SCOPE_INFO) != 0) {
 		return (NULL);
 	}
@@ -294,23 +329,35 @@ v8funcinfo_t *
 v8funcinfo_load(uintptr_t funcinfo, int memflags)
 {
 	v8funcinfo_t *fip;
+	v8header_t fihdr, scripthdr;
 	uintptr_t script, name, inferred_name, code;
 	uintptr_t scriptpath, lineends, tokenpos;
 
-	if (read_heap_maybesmi(&tokenpos, funcinfo,
+	/*
+	 * Everything we need comes from the SharedFunctionInfo and its Script,
+	 * so read each of their headers once and decode from those.
+	 */
+	read_heap_header(&fihdr, funcinfo, V8_SIZE_SHAREDFUNCTIONINFO);
+	if (read_header_maybesmi(&tokenpos, &fihdr,
 	    V8_OFF_SHAREDFUNCTIONINFO_FUNCTION_TOKEN_POSITION) != 0 ||
-	    read_heap_ptr(&name, funcinfo,
+	    read_header_ptr(&name, &fihdr,
 	    V8_OFF_SHAREDFUNCTIONINFO_NAME) != 0 ||
-	    read_heap_ptr(&script, funcinfo,
-	    V8_OFF_SHAREDFUNCTIONINFO_SCRIPT) != 0 ||
-	    read_heap_ptr(&scriptpath, script, V8_OFF_SCRIPT_NAME) != 0 ||
-	    read_heap_ptr(&lineends, script, V8_OFF_SCRIPT_LINE_ENDS) != 0 ||
-	    read_heap_ptr(&code, funcinfo,
+	    read_header_ptr(&script, &fihdr,
+	    V8_OFF_SHAREDFUNCTIONINFO_SCRIPT) != 0) {
+		return (NULL);
+	}
+
+	read_heap_header(&scripthdr, script, V8_SIZE_SCRIPT);
+	if (read_header_ptr(&scriptpath, &scripthdr,
+	    V8_OFF_SCRIPT_NAME) != 0 ||
+	    read_header_ptr(&lineends, &scripthdr,
+	    V8_OFF_SCRIPT_LINE_ENDS) != 0 ||
+	    read_header_ptr(&code, &fihdr,
 	    V8_OFF_SHAREDFUNCTIONINFO_CODE) != 0) {
 		return (NULL);
 	}
 
-	if (read_heap_ptr(&inferred_name, funcinfo,
+	if (read_header_ptr(&inferred_name, &fihdr,
 	    V8_OFF_SHAREDFUNCTIONINFO_IDENTIFIER) != 0) {
 		inferred_name = 0;
 	}
@@ -433,15 +480,13 @@ int
 v8funcinfo_definition_location(v8funcinfo_t *fip, mdbv8_strbuf_t *strb,
     mdbv8_strappend_flags_t flags)
 {
-	uintptr_t tokpos, lower, upper, i;
-	uintptr_t *data;
-	v8fixedarray_t *arrayp;
-	int memflags;
+	uintptr_t tokpos;
+	int lineno;
 
 	/*
 	 * The "function" token position is an SMI, and has already been decoded
-	 * at this point.  For both the -1 check and the binary search
-	 * algorithm below, it's easier to compare this to other SMI-encoded
+	 * at this point.  For both the -1 check and the search of the line
+	 * endings table, it's easier to compare this to other SMI-encoded
 	 * values, so we re-encode the token position.
 	 */
 	tokpos = V8_VALUE_SMI(fip->v8fi_tokenpos);
@@ -469,51 +514,167 @@ v8funcinfo_definition_location(v8funcinfo_t *fip, mdbv8_strbuf_t *strb,
 		return (0);
 	}
 
-	memflags = UM_NOSLEEP;
-	arrayp = v8fixedarray_load(fip->v8fi_line_endings, memflags);
-	if (arrayp == NULL) {
+	if (v8lineends_lineno(fip->v8fi_line_endings, tokpos, &lineno) != 0)
 		return (-1);
-	}
 
-	if (v8fixedarray_length(arrayp) == 0) {
+	if (lineno == 0)
 		mdbv8_strbuf_sprintf(strb, "position out of range");
-		v8fixedarray_free(arrayp);
+	else
+		mdbv8_strbuf_sprintf(strb, "line %d", lineno);
+
+	return (0);
+}
+
+/*
+ * Each Script has a table of the (SMI-encoded) positions of the ends of its
+ * lines, which we search to map token positions to line numbers.  Listing
+ * functions or stack frames involves doing this for many functions, most of
+ * which are defined in relatively few scripts, so rather than reading a table
+ * each time, we keep the tables we've read in a cache keyed by the table's
+ * address (which identifies the Script).  The cache is limited to
+ * V8LINEENDS_MAXBYTES, with the least recently used tables evicted first.  It's
+ * only used when v8_cache_enabled().
+ */
+static size_t
+v8lineends_search(const uintptr_t *data, size_t nents, uintptr_t tokpos)
+{
+	size_t lower, upper, i;
+
+	if (nents == 0 || tokpos > data[nents - 1])
 		return (0);
+
+	if (tokpos <= data[0])
+		return (1);
+
+	lower = 0;
+	upper = nents - 1;
+	i = 0;
+	while (upper >= 1) {
+		i = (lower + upper) >> 1;
+		if (tokpos > data[i])
+			lower = i + 1;
+		else if (tokpos <= data[i - 1])
+			upper = i - 1;
+		else
+			break;
 	}
 
-	data = v8fixedarray_as_array(arrayp, memflags);
-	if (data == NULL) {
-		v8fixedarray_free(arrayp);
-		return (-1);
+	return (i + 1);
+}
+
+static void
+v8lineends_unlink(v8lineends_t *lep)
+{
+	if (lep->v8le_prev != NULL)
+		lep->v8le_prev->v8le_next = lep->v8le_next;
+	else
+		v8lineends_mru = lep->v8le_next;
+
+	if (lep->v8le_next != NULL)
+		lep->v8le_next->v8le_prev = lep->v8le_prev;
+	else
+		v8lineends_lru = lep->v8le_prev;
+}
+
+static void
+v8lineends_link(v8lineends_t *lep)
+{
+	lep->v8le_prev = NULL;
+	lep->v8le_next = v8lineends_mru;
+	if (v8lineends_mru != NULL)
+		v8lineends_mru->v8le_prev = lep;
+	else
+		v8lineends_lru = lep;
+	v8lineends_mru = lep;
+}
+
+static void
+v8lineends_evict(v8lineends_t *lep)
+{
+	v8lineends_t **lepp;
+
+	lepp = &v8lineends_hash[(lep->v8le_addr >> 3) % V8LINEENDS_NBUCKETS];
+	while (*lepp != lep)
+		lepp = &(*lepp)->v8le_hnext;
+	*lepp = lep->v8le_hnext;
+
+	v8lineends_unlink(lep);
+	v8lineends_stats_cur.v8cs_nbytes -=
+	    lep->v8le_nents * sizeof (uintptr_t);
+	if (lep->v8le_data != NULL)
+		mdb_free(lep->v8le_data, lep->v8le_nents * sizeof (uintptr_t));
+	mdb_free(lep, sizeof (*lep));
+}
+
+/*
+ * Given the address of a Script's line endings table and an SMI-encoded token
+ * position, stores into "*linenop" the 1-based number of the line containing
+ * that position, or 0 if the position is past the end of the table.
+ */
+int
+v8lineends_lineno(uintptr_t addr, uintptr_t tokpos, int *linenop)
+{
+	v8lineends_t *lep, **bucketp;
+	uintptr_t *data;
+	size_t nents, nbytes;
+
+	bucketp = &v8lineends_hash[(addr >> 3) % V8LINEENDS_NBUCKETS];
+	for (lep = *bucketp; lep != NULL; lep = lep->v8le_hnext) {
+		if (lep->v8le_addr == addr)
+			break;
 	}
 
-	lower = 0;
-	upper = v8fixedarray_length(arrayp) - 1;
-	if (tokpos > data[upper]) {
-		mdbv8_strbuf_sprintf(strb, "position out of range");
-	} else if (tokpos <= data[0]) {
-		mdbv8_strbuf_sprintf(strb, "line 1");
-	} else {
-		i = 0;
-		while (upper >= 1) {
-			i = (lower + upper) >> 1;
-			if (tokpos > data[i])
-				lower = i + 1;
-			else if (tokpos <= data[i - 1])
-				upper = i - 1;
-			else
-				break;
-		}
+	if (lep != NULL) {
+		v8lineends_stats_cur.v8cs_hits++;
+		v8lineends_unlink(lep);
+		v8lineends_link(lep);
+		*linenop = v8lineends_search(lep->v8le_data,
+		    lep->v8le_nents, tokpos);
+		return (0);
+	}
 
-		mdbv8_strbuf_sprintf(strb, "line %d", i + 1);
+	if (read_heap_array(addr, &data, &nents, UM_SLEEP) != 0)
+		return (-1);
+
+	*linenop = v8lineends_search(data, nents, tokpos);
+	nbytes = nents * sizeof (uintptr_t);
+	if (!v8_cache_enabled() || nbytes > V8LINEENDS_MAXBYTES) {
+		if (data != NULL)
+			mdb_free(data, nbytes);
+		return (0);
+	}
+
+	v8lineends_stats_cur.v8cs_misses++;
+	while (v8lineends_lru != NULL &&
+	    v8lineends_stats_cur.v8cs_nbytes + nbytes > V8LINEENDS_MAXBYTES) {
+		v8lineends_stats_cur.v8cs_evictions++;
+		v8lineends_evict(v8lineends_lru);
 	}
 
-	maybefree(data, sizeof (data[0]) * v8fixedarray_length(arrayp),
-	    memflags);
-	v8fixedarray_free(arrayp);
+	lep = mdb_alloc(sizeof (*lep), UM_SLEEP);
+	lep->v8le_addr = addr;
+	lep->v8le_data = data;
+	lep->v8le_nents = nents;
+	lep->v8le_hnext = *bucketp;
+	*bucketp = lep;
+	v8lineends_link(lep);
+	v8lineends_stats_cur.v8cs_nbytes += nbytes;
 	return (0);
 }
 
+void
+v8lineends_stats(v8cache_stats_t *statsp)
+{
+	*statsp = v8lineends_stats_cur;
+}
+
+void
+v8lineends_clear(void)
+{
+	while (v8lineends_lru != NULL)
+		v8lineends_evict(v8lineends_lru);
+}
+
 /*
  * Loads the V8Code object function "fip".  This is useful for disassembling a
  * JavaScript function.
@@ -1169,13 +1330,20 @@ v8boundfunction_load_bindings(uintptr_t addr, int memflags)
 static v8boundfunction_t *
 v8boundfunction_load_direct(uintptr_t addr, int memflags)
 {
+	v8header_t hdr;
 	uint8_t type;
 	uintptr_t boundArgs;
 	v8boundfunction_t *bfp;
 
 	assert(V8_TYPE_JSBOUNDFUNCTION != -1);
 
-	if (!V8_IS_HEAPOBJECT(addr) || read_typebyte(&type, addr) != 0) {
+	if (!V8_IS_HEAPOBJECT(addr)) {
+		v8_warn("%p: not a heap object\n", addr);
+		return (NULL);
+	}
+
+	read_heap_header(&hdr, addr, V8_SIZE_JSBOUNDFUNCTION);
+	if (read_header_typebyte(&type, &hdr) != 0) {
 		v8_warn("%p: not a heap object\n", addr);
 		return (NULL);
 	}
@@ -1189,11 +1357,11 @@ v8boundfunction_load_direct(uintptr_t addr, int memflags)
 		return (NULL);
 	}
 
-	if (read_heap_ptr(&bfp->v8bf_target, addr,
+	if (read_header_ptr(&bfp->v8bf_target, &hdr,
 	    V8_OFF_JSBOUNDFUNCTION_BOUND_TARGET_FUNCTION) == -1 ||
-	    read_heap_ptr(&bfp->v8bf_this, addr,
+	    read_header_ptr(&bfp->v8bf_this, &hdr,
 	    V8_OFF_JSBOUNDFUNCTION_BOUND_THIS) == -1 ||
-	    read_heap_ptr(&boundArgs, addr,
+	    read_header_ptr(&boundArgs, &hdr,
 	    V8_OFF_JSBOUNDFUNCTION_BOUND_ARGUMENTS) == -1 ||
 	    read_heap_array(boundArgs, &bfp->v8bf_array,
 	    &bfp->v8bf_arraylen, memflags) == -1) {
@@ -32,6 +32,17 @@
 
 #include <sys/mdb_modapi.h>
 
+/*
+ * Local copy of the fixed-size part of a heap object.  See read_heap_header().
+ */
+#define	V8_HEADER_MAXWORDS	32
+
+typedef struct v8header {
+	uintptr_t	vh_addr;			/* object address */
+	size_t		vh_size;			/* bytes copied */
+	uintptr_t	vh_words[V8_HEADER_MAXWORDS];	/* object contents */
+} v8header_t;
+
 /*
  * XXX Cleanup work to be done on these:
  * - prefix these function names
@@ -43,9 +54,17 @@ int read_heap_array(uintptr_t, uintptr_t **, size_t *, int);
 int read_heap_maybesmi(uintptr_t *, uintptr_t, ssize_t);
 int read_heap_ptr(uintptr_t *, uintptr_t, ssize_t);
 int read_heap_smi(uintptr_t *, uintptr_t, ssize_t);
+void read_heap_header(v8header_t *, uintptr_t, size_t);
+int read_header_maybesmi(uintptr_t *, const v8header_t *, ssize_t);
+int read_header_ptr(uintptr_t *, const v8header_t *, ssize_t);
+int read_header_smi(uintptr_t *, const v8header_t *, ssize_t);
+int read_header_typebyte(uint8_t *, const v8header_t *);
 int read_size(size_t *, uintptr_t);
 int read_typebyte(uint8_t *, uintptr_t);
+
+int v8lineends_lineno(uintptr_t, uintptr_t, int *);
 void v8_warn(const char *, ...);
+boolean_t v8_cache_enabled(void);
 boolean_t jsobj_is_undefined(uintptr_t);
 
 /*
@@ -90,6 +109,8 @@ extern ssize_t V8_OFF_JSFUNCTION_LITERALS_OR_BINDINGS;
 extern ssize_t V8_OFF_JSFUNCTION_SHARED;
 extern ssize_t V8_OFF_JSOBJECT_ELEMENTS;
 extern ssize_t V8_OFF_MAP_INOBJECT_PROPERTIES;
+extern ssize_t V8_OFF_MAP_INSTANCE_ATTRIBUTES;
+extern ssize_t V8_OFF_MAP_INSTANCE_SIZE;
 extern ssize_t V8_OFF_SCRIPT_LINE_ENDS;
 extern ssize_t V8_OFF_SCRIPT_NAME;
 extern ssize_t V8_OFF_SEQASCIISTR_CHARS;
@@ -107,6 +128,12 @@ extern ssize_t V8_OFF_SLICEDSTRING_PARENT;
 extern ssize_t V8_OFF_SLICEDSTRING_OFFSET;
 extern ssize_t V8_OFF_STRING_LENGTH;
 
+extern size_t V8_SIZE_JSBOUNDFUNCTION;
+extern size_t V8_SIZE_JSFUNCTION;
+extern size_t V8_SIZE_SCRIPT;
+extern size_t V8_SIZE_SHAREDFUNCTIONINFO;
+extern size_t V8_SIZE_STRING;
+
 extern intptr_t V8_CONTEXT_IDX_CLOSURE;
 extern intptr_t V8_CONTEXT_IDX_EXT;
 extern intptr_t V8_CONTEXT_IDX_GLOBAL;
@@ -120,6 +147,8 @@ extern intptr_t V8_SCOPEINFO_IDX_NPARAMS;
 extern intptr_t V8_SCOPEINFO_IDX_NSTACKLOCALS;
 extern intptr_t V8_SCOPEINFO_OFFSET_STACK_LOCALS;
 
+extern intptr_t V8_PointerSizeLog2;
+
 extern intptr_t V8_HeapObjectTag;
 extern intptr_t V8_HeapObjectTagMask;
 extern intptr_t V8_SmiTag;
@@ -127,6 +156,16 @@ extern intptr_t V8_SmiTagMask;
 extern intptr_t V8_SmiValueShift;
 extern intptr_t V8_SmiShiftSize;
 
+/*
+ * UTF-16 surrogates.  A high surrogate followed by a low surrogate encodes a
+ * single code point outside the Basic Multilingual Plane.
+ */
+#define	UTF16_ISHIGH(c)		((c) >= 0xd800 && (c) <= 0xdbff)
+#define	UTF16_ISLOW(c)		((c) >= 0xdc00 && (c) <= 0xdfff)
+#define	UTF16_ISSURROGATE(c)	((c) >= 0xd800 && (c) <= 0xdfff)
+#define	UTF16_CODEPOINT(hi, lo)	\
+	(0x10000 + ((((uint32_t)(hi)) - 0xd800) << 10) + ((lo) - 0xdc00))
+
 /* see node_string.h */
 #define	NODE_OFF_EXTSTR_DATA		sizeof (uintptr_t)
 
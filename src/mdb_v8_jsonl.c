@@ -0,0 +1,180 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * mdb_v8_jsonl.c: buffered writer for machine-readable output.
+ *
+ * Commands that support "-j" emit one JSON object per line ("JSON lines")
+ * rather than columns of text, so that other programs can consume the output
+ * without parsing it.  Records are assembled in a large buffer that's flushed
+ * to the debugger's output only when it starts to fill up (and when the
+ * command calls mdbv8_jsonl_flush() at the end), rather than issuing separate
+ * mdb_printf() calls for each field.  Records may span a flush.  The writer is
+ * garbage-collected, so it isn't leaked if the command is interrupted.
+ * Strings are escaped with MSF_JSON, and addresses are written as hexadecimal
+ * strings, since they may not be representable as JavaScript numbers.
+ */
+
+#include "mdb_v8_dbg.h"
+#include "mdb_v8_impl.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <string.h>
+
+#define	MDBV8_JSONL_BUFSZ	(256 * 1024)
+#define	MDBV8_JSONL_MAXDEPTH	8
+
+struct mdbv8_jsonl {
+	mdbv8_strbuf_t	mjl_strb;		/* pending output */
+	char		*mjl_buf;		/* buffer for mjl_strb */
+	uint_t		mjl_depth;		/* current nesting depth */
+	boolean_t	mjl_first[MDBV8_JSONL_MAXDEPTH]; /* next is first */
+};
+
+mdbv8_jsonl_t *
+mdbv8_jsonl_alloc(void)
+{
+	mdbv8_jsonl_t *jsl;
+
+	jsl = mdb_zalloc(sizeof (*jsl), UM_SLEEP | UM_GC);
+	jsl->mjl_buf = mdb_alloc(MDBV8_JSONL_BUFSZ, UM_SLEEP | UM_GC);
+	mdbv8_strbuf_init(&jsl->mjl_strb, jsl->mjl_buf, MDBV8_JSONL_BUFSZ);
+	return (jsl);
+}
+
+/*
+ * Write out any buffered output.  Commands must call this when they're done
+ * emitting records.
+ */
+void
+mdbv8_jsonl_flush(mdbv8_jsonl_t *jsl)
+{
+	if (jsl->mjl_buf[0] != '\0')
+		mdb_printf("%s", jsl->mjl_buf);
+
+	mdbv8_strbuf_rewind(&jsl->mjl_strb);
+}
+
+/*
+ * Begin the next value, which takes at most "nbytes" bytes (not counting its
+ * key), within the current object or array.  Values too large for the buffer
+ * are truncated.
+ */
+static void
+mdbv8_jsonl_value(mdbv8_jsonl_t *jsl, const char *key, size_t nbytes)
+{
+	mdbv8_strbuf_t *strb = &jsl->mjl_strb;
+
+	if (key != NULL)
+		nbytes += 4 * strlen(key) + 3;
+
+	if (mdbv8_strbuf_bytesleft(strb) < nbytes + 1)
+		mdbv8_jsonl_flush(jsl);
+
+	if (jsl->mjl_depth > 0) {
+		if (!jsl->mjl_first[jsl->mjl_depth - 1])
+			mdbv8_strbuf_appendc(strb, ',', 0);
+		jsl->mjl_first[jsl->mjl_depth - 1] = B_FALSE;
+	}
+
+	if (key != NULL) {
+		mdbv8_strbuf_appendc(strb, '"', 0);
+		mdbv8_strbuf_appends(strb, key, MSF_JSON);
+		mdbv8_strbuf_appends(strb, "\":", 0);
+	}
+}
+
+static void
+mdbv8_jsonl_push(mdbv8_jsonl_t *jsl, const char *key, char c)
+{
+	mdbv8_jsonl_value(jsl, key, 1);
+	mdbv8_strbuf_appendc(&jsl->mjl_strb, c, 0);
+
+	assert(jsl->mjl_depth < MDBV8_JSONL_MAXDEPTH);
+	jsl->mjl_first[jsl->mjl_depth++] = B_TRUE;
+}
+
+static void
+mdbv8_jsonl_pop(mdbv8_jsonl_t *jsl, char c)
+{
+	assert(jsl->mjl_depth > 0);
+	jsl->mjl_depth--;
+
+	if (mdbv8_strbuf_bytesleft(&jsl->mjl_strb) < 2)
+		mdbv8_jsonl_flush(jsl);
+	mdbv8_strbuf_appendc(&jsl->mjl_strb, c, 0);
+}
+
+/*
+ * Begin a new record.  This must be matched by a call to mdbv8_jsonl_end().
+ */
+void
+mdbv8_jsonl_begin(mdbv8_jsonl_t *jsl)
+{
+	assert(jsl->mjl_depth == 0);
+	mdbv8_jsonl_push(jsl, NULL, '{');
+}
+
+void
+mdbv8_jsonl_end(mdbv8_jsonl_t *jsl)
+{
+	mdbv8_jsonl_pop(jsl, '}');
+	assert(jsl->mjl_depth == 0);
+
+	if (mdbv8_strbuf_bytesleft(&jsl->mjl_strb) < 2)
+		mdbv8_jsonl_flush(jsl);
+	mdbv8_strbuf_appendc(&jsl->mjl_strb, '\n', 0);
+
+	if (mdbv8_strbuf_bytesleft(&jsl->mjl_strb) < MDBV8_JSONL_BUFSZ / 2)
+		mdbv8_jsonl_flush(jsl);
+}
+
+/*
+ * Begin an array-valued field of the current record.  Elements are added by
+ * passing a NULL key to the functions below, and the array is terminated with
+ * mdbv8_jsonl_array_end().
+ */
+void
+mdbv8_jsonl_array_begin(mdbv8_jsonl_t *jsl, const char *key)
+{
+	mdbv8_jsonl_push(jsl, key, '[');
+}
+
+void
+mdbv8_jsonl_array_end(mdbv8_jsonl_t *jsl)
+{
+	mdbv8_jsonl_pop(jsl, ']');
+}
+
+void
+mdbv8_jsonl_string(mdbv8_jsonl_t *jsl, const char *key, const char *value)
+{
+	mdbv8_jsonl_value(jsl, key, 4 * strlen(value) + 2);
+	mdbv8_strbuf_appendc(&jsl->mjl_strb, '"', 0);
+	mdbv8_strbuf_reserve(&jsl->mjl_strb, 1);
+	mdbv8_strbuf_appends(&jsl->mjl_strb, value, MSF_JSON);
+	mdbv8_strbuf_reserve(&jsl->mjl_strb, -1);
+	mdbv8_strbuf_appendc(&jsl->mjl_strb, '"', 0);
+}
+
+void
+mdbv8_jsonl_addr(mdbv8_jsonl_t *jsl, const char *key, uintptr_t value)
+{
+	mdbv8_jsonl_value(jsl, key, 2 * sizeof (value) + 4);
+	mdbv8_strbuf_sprintf(&jsl->mjl_strb, "\"0x%" PRIxPTR "\"", value);
+}
+
+void
+mdbv8_jsonl_uint(mdbv8_jsonl_t *jsl, const char *key, uint64_t value)
+{
+	mdbv8_jsonl_value(jsl, key, 20);
+	mdbv8_strbuf_sprintf(&jsl->mjl_strb, "%" PRIu64, value);
+}
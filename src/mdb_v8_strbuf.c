@@ -22,6 +22,46 @@ typedef enum {
 	MSB_NOALLOC	= 0x1,	/* stack-allocated strbuf */
 } mdbv8_strbuf_flags_t;
 
+static boolean_t mdbv8_strbuf_isclean(uint8_t, mdbv8_strappend_flags_t);
+
+/*
+ * Returns the number of bytes in the UTF-8 encoding of (non-ASCII) code point
+ * "cp".
+ */
+static size_t
+mdbv8_strbuf_utf8len(uint32_t cp)
+{
+	if (cp < 0x800)
+		return (2);
+
+	if (cp < 0x10000)
+		return (3);
+
+	return (4);
+}
+
+/*
+ * Writes the UTF-8 encoding of (non-ASCII) code point "cp" to "dst", which
+ * must have room for mdbv8_strbuf_utf8len(cp) bytes.
+ */
+static void
+mdbv8_strbuf_utf8(char *dst, uint32_t cp)
+{
+	if (cp < 0x800) {
+		dst[0] = 0xc0 | (cp >> 6);
+		dst[1] = 0x80 | (cp & 0x3f);
+	} else if (cp < 0x10000) {
+		dst[0] = 0xe0 | (cp >> 12);
+		dst[1] = 0x80 | ((cp >> 6) & 0x3f);
+		dst[2] = 0x80 | (cp & 0x3f);
+	} else {
+		dst[0] = 0xf0 | (cp >> 18);
+		dst[1] = 0x80 | ((cp >> 12) & 0x3f);
+		dst[2] = 0x80 | ((cp >> 6) & 0x3f);
+		dst[3] = 0x80 | (cp & 0x3f);
+	}
+}
+
 mdbv8_strbuf_t *
 mdbv8_strbuf_alloc(size_t nbytes, int memflags)
 {
@@ -116,7 +156,24 @@ void
 mdbv8_strbuf_appendc(mdbv8_strbuf_t *strb, uint16_t c,
     mdbv8_strappend_flags_t flags)
 {
-	if ((flags & MSF_ASCIIONLY) != 0 && !isascii(c)) {
+	char utf8[4];
+	size_t len;
+
+	/*
+	 * Surrogates only make sense in pairs, which are written with
+	 * mdbv8_strbuf_appendutf16(), so a surrogate here is replaced like any
+	 * other character we can't print.
+	 */
+	if ((flags & MSF_UTF8) != 0 && !isascii(c) && !UTF16_ISSURROGATE(c)) {
+		len = mdbv8_strbuf_utf8len(c);
+		if (mdbv8_strbuf_bytesleft(strb) >= len) {
+			mdbv8_strbuf_utf8(utf8, c);
+			mdbv8_strbuf_appendbytes(strb, utf8, len);
+		}
+		return;
+	}
+
+	if ((flags & (MSF_ASCIIONLY | MSF_UTF8)) != 0 && !isascii(c)) {
 		c = '?';
 	}
 
@@ -143,7 +200,7 @@ mdbv8_strbuf_appendc(mdbv8_strbuf_t *strb, uint16_t c,
 			return;
 
 		case '"':
-			mdbv8_strbuf_sprintf(strb, "\"");
+			mdbv8_strbuf_sprintf(strb, "\\\"");
 			return;
 
 		default:
@@ -178,9 +235,205 @@ mdbv8_strbuf_nbytesforchar(uint16_t c, mdbv8_strappend_flags_t flags)
 		}
 	}
 
+	/*
+	 * A surrogate pair takes four bytes.  We count those against the high
+	 * surrogate so that callers checking whether the next character will
+	 * fit don't split the pair, and one byte for the low surrogate, which
+	 * overestimates the total but is exact for an unpaired low surrogate.
+	 */
+	if ((flags & MSF_UTF8) != 0 && !isascii(c)) {
+		if (UTF16_ISHIGH(c))
+			return (4);
+
+		if (UTF16_ISLOW(c))
+			return (1);
+
+		return (mdbv8_strbuf_utf8len(c));
+	}
+
 	return (1);
 }
 
+/*
+ * Returns true if mdbv8_strbuf_appendc() would write byte "c" to the output
+ * unchanged.  This must be kept in sync with mdbv8_strbuf_appendc().
+ */
+static boolean_t
+mdbv8_strbuf_isclean(uint8_t c, mdbv8_strappend_flags_t flags)
+{
+	if (c == '\0' || !isascii(c))
+		return (B_FALSE);
+
+	if ((flags & MSF_JSON) == MSF_JSON &&
+	    (iscntrl(c) || c == '\\' || c == '"'))
+		return (B_FALSE);
+
+	return (B_TRUE);
+}
+
+/*
+ * Returns the length of the longest prefix of the "len" bytes at "src" that
+ * mdbv8_strbuf_appendc() would write to the output unchanged, so that callers
+ * can copy those bytes with mdbv8_strbuf_appendbytes() instead of appending
+ * them one at a time.  Large strings are almost entirely made up of such runs,
+ * so we check a word at a time: a word can be skipped if none of its bytes are
+ * zero, non-ASCII, or (for JSON) control characters, backslashes, or double
+ * quotes.  The tests below are the usual tricks for finding a zero byte in a
+ * word; they may flag bytes above a byte that really matches, but never miss
+ * one, so we just fall back to checking bytes individually at the first word
+ * that might contain a match.
+ */
+size_t
+mdbv8_strbuf_nclean(const char *src, size_t len, mdbv8_strappend_flags_t flags)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+	const uint64_t highs = 0x8080808080808080ULL;
+	boolean_t json = (flags & MSF_JSON) == MSF_JSON;
+	uint64_t w, x, bad;
+	size_t i = 0;
+
+	for (; i + sizeof (w) <= len; i += sizeof (w)) {
+		bcopy(src + i, &w, sizeof (w));
+		bad = (w & highs) | ((w - ones) & ~w & highs);
+		if (json) {
+			bad |= (w - ones * 0x20) & ~w & highs;
+			x = w ^ (ones * 0x7f);
+			bad |= (x - ones) & ~x & highs;
+			x = w ^ (ones * '\\');
+			bad |= (x - ones) & ~x & highs;
+			x = w ^ (ones * '"');
+			bad |= (x - ones) & ~x & highs;
+		}
+
+		if (bad != 0)
+			break;
+	}
+
+	for (; i < len; i++) {
+		if (!mdbv8_strbuf_isclean(src[i], flags))
+			break;
+	}
+
+	return (i);
+}
+
+/*
+ * Appends "nbytes" bytes from "src" to the buffer as-is, truncating them (as
+ * mdbv8_strbuf_sprintf() would) if there isn't enough space.
+ */
+void
+mdbv8_strbuf_appendbytes(mdbv8_strbuf_t *strb, const char *src, size_t nbytes)
+{
+	size_t len;
+
+	if (strb->ms_curbufsz <= strb->ms_reservesz)
+		return;
+
+	len = MIN(nbytes, strb->ms_curbufsz - strb->ms_reservesz - 1);
+	bcopy(src, strb->ms_curbuf, len);
+	strb->ms_curbuf[len] = '\0';
+	strb->ms_curbufsz -= len;
+	strb->ms_curbuf += len;
+}
+
+/*
+ * Transcodes the "nunits" UTF-16 code units at "src" into the buffer for as
+ * long as they can be written without escaping or replacement: that is, clean
+ * ASCII characters (see mdbv8_strbuf_nclean()) and, with MSF_UTF8, non-ASCII
+ * characters and surrogate pairs, which are written as UTF-8.  At most
+ * "maxbytes" bytes are written, and a character is never split.  Returns the
+ * number of code units consumed, which callers handle the next of with
+ * mdbv8_strbuf_appendc() if it's not all of them.
+ *
+ * Most text is long runs of ASCII, so as in mdbv8_strbuf_nclean(), we check
+ * four code units at a time for that case: a word of them is ASCII if no unit
+ * has any of its top nine bits set, and we check the resulting bytes by
+ * filling each unit's (zero) high byte with a clean character and applying the
+ * same tests mdbv8_strbuf_nclean() uses.
+ */
+size_t
+mdbv8_strbuf_appendutf16(mdbv8_strbuf_t *strb, const uint16_t *src,
+    size_t nunits, size_t maxbytes, mdbv8_strappend_flags_t flags)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+	const uint64_t highs = 0x8080808080808080ULL;
+	boolean_t json = (flags & MSF_JSON) == MSF_JSON;
+	char *dst = strb->ms_curbuf;
+	size_t i, o, len, k, nused;
+	uint64_t w, x, bad;
+	uint32_t cp;
+	uint16_t c;
+
+	if (strb->ms_curbufsz <= strb->ms_reservesz)
+		return (0);
+
+	maxbytes = MIN(maxbytes, strb->ms_curbufsz - strb->ms_reservesz - 1);
+	i = o = 0;
+	while (i < nunits) {
+		if (i + 4 <= nunits && o + 4 <= maxbytes) {
+			bcopy(src + i, &w, sizeof (w));
+			if ((w & 0xff80ff80ff80ff80ULL) == 0) {
+				w |= 0x4100410041004100ULL;
+				bad = (w - ones) & ~w & highs;
+				if (json) {
+					bad |= (w - ones * 0x20) & ~w & highs;
+					x = w ^ (ones * 0x7f);
+					bad |= (x - ones) & ~x & highs;
+					x = w ^ (ones * '\\');
+					bad |= (x - ones) & ~x & highs;
+					x = w ^ (ones * '"');
+					bad |= (x - ones) & ~x & highs;
+				}
+
+				if (bad == 0) {
+					for (k = 0; k < 4; k++)
+						dst[o + k] = (char)src[i + k];
+					i += 4;
+					o += 4;
+					continue;
+				}
+			}
+		}
+
+		c = src[i];
+		if (isascii(c)) {
+			if (!mdbv8_strbuf_isclean(c, flags) || o + 1 > maxbytes)
+				break;
+
+			dst[o++] = (char)c;
+			i++;
+			continue;
+		}
+
+		if ((flags & MSF_UTF8) == 0 || UTF16_ISLOW(c))
+			break;
+
+		if (UTF16_ISHIGH(c)) {
+			if (i + 1 >= nunits || !UTF16_ISLOW(src[i + 1]))
+				break;
+
+			cp = UTF16_CODEPOINT(c, src[i + 1]);
+			nused = 2;
+		} else {
+			cp = c;
+			nused = 1;
+		}
+
+		len = mdbv8_strbuf_utf8len(cp);
+		if (o + len > maxbytes)
+			break;
+
+		mdbv8_strbuf_utf8(dst + o, cp);
+		o += len;
+		i += nused;
+	}
+
+	dst[o] = '\0';
+	strb->ms_curbuf += o;
+	strb->ms_curbufsz -= o;
+	return (i);
+}
+
 void
 mdbv8_strbuf_sprintf(mdbv8_strbuf_t *strb, const char *format, ...)
 {
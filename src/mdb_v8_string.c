@@ -47,18 +47,40 @@ struct v8string {
 	} v8s_info;
 };
 
+static int v8string_write_fill(v8string_t *, mdbv8_strbuf_t *,
+    mdbv8_strappend_flags_t, v8string_flags_t);
+static int v8string_write_range(v8string_t *, mdbv8_strbuf_t *,
+    mdbv8_strappend_flags_t, v8string_flags_t, size_t, ssize_t, size_t *);
 static int v8string_write_seq(v8string_t *, mdbv8_strbuf_t *,
-    mdbv8_strappend_flags_t, v8string_flags_t, size_t, ssize_t);
+    mdbv8_strappend_flags_t, v8string_flags_t, size_t, ssize_t, size_t *);
 static int v8string_write_cons(v8string_t *, mdbv8_strbuf_t *,
-    mdbv8_strappend_flags_t, v8string_flags_t);
+    mdbv8_strappend_flags_t, v8string_flags_t, size_t, ssize_t, size_t *);
 static int v8string_write_ext(v8string_t *, mdbv8_strbuf_t *,
-    mdbv8_strappend_flags_t, v8string_flags_t);
+    mdbv8_strappend_flags_t, v8string_flags_t, size_t, ssize_t, size_t *);
 static int v8string_write_sliced(v8string_t *, mdbv8_strbuf_t *,
-    mdbv8_strappend_flags_t, v8string_flags_t);
+    mdbv8_strappend_flags_t, v8string_flags_t, size_t, ssize_t, size_t *);
 
 static const char *v8s_truncate_marker = "[...]";
 static size_t v8s_truncate_marker_bytes = sizeof ("[...]") - 1;
 
+/*
+ * Decoded strings: see v8string_cache_write() for details.
+ */
+typedef struct v8string_cent {
+	uintptr_t		v8sc_addr;	/* address of String */
+	mdbv8_strappend_flags_t	v8sc_strflags;	/* flags used to write it */
+	v8string_flags_t	v8sc_v8flags;	/* flags used to write it */
+	size_t			v8sc_nbytes;	/* bytes in v8sc_str */
+	char			*v8sc_str;	/* decoded string */
+} v8string_cent_t;
+
+#define	V8STRING_NCACHE		4096
+#define	V8STRING_CACHE_MAXLEN	256	/* longest string cached */
+#define	V8STRING_CACHE_SLOP	64	/* see v8string_write_fill() */
+
+static v8string_cent_t v8string_cache[V8STRING_NCACHE];
+static v8cache_stats_t v8string_cache_stats_cur;
+
 /*
  * Loads a V8 String object.
  * See the patterns in mdb_v8_dbg.h for interface details.
@@ -66,11 +88,18 @@ static size_t v8s_truncate_marker_bytes = sizeof ("[...]") - 1;
 v8string_t *
 v8string_load(uintptr_t addr, int memflags)
 {
+	v8header_t hdr;
 	uint8_t type;
 	uintptr_t length;
 	v8string_t *strp;
 
-	if (read_typebyte(&type, addr) != 0) {
+	/*
+	 * Everything we need is in the string's header, so read it all at once.
+	 * This matters for ConsStrings in particular, since writing one out
+	 * means loading every node in the tree.
+	 */
+	read_heap_header(&hdr, addr, V8_SIZE_STRING);
+	if (read_header_typebyte(&type, &hdr) != 0) {
 		v8_warn("could not read type for string: %p\n", addr);
 		return (NULL);
 	}
@@ -86,7 +115,7 @@ v8string_load(uintptr_t addr, int memflags)
 		return (NULL);
 	}
 
-	if (read_heap_smi(&length, addr, V8_OFF_STRING_LENGTH) != 0) {
+	if (read_header_smi(&length, &hdr, V8_OFF_STRING_LENGTH) != 0) {
 		v8_warn("failed to read string length: %p\n", addr);
 		return (NULL);
 	}
@@ -101,27 +130,27 @@ v8string_load(uintptr_t addr, int memflags)
 	strp->v8s_memflags = memflags;
 
 	if (V8_STRREP_CONS(type)) {
-		if (read_heap_ptr(&strp->v8s_info.v8s_consinfo.v8s_cons_p1,
-		    addr, V8_OFF_CONSSTRING_FIRST) != 0 ||
-		    read_heap_ptr(&strp->v8s_info.v8s_consinfo.v8s_cons_p2,
-		    addr, V8_OFF_CONSSTRING_SECOND) != 0) {
+		if (read_header_ptr(&strp->v8s_info.v8s_consinfo.v8s_cons_p1,
+		    &hdr, V8_OFF_CONSSTRING_FIRST) != 0 ||
+		    read_header_ptr(&strp->v8s_info.v8s_consinfo.v8s_cons_p2,
+		    &hdr, V8_OFF_CONSSTRING_SECOND) != 0) {
 			v8_warn("failed to read cons ptrs: %p\n", addr);
 			goto fail;
 		}
 	} else if (V8_STRREP_SLICED(type)) {
-		if (read_heap_ptr(
+		if (read_header_ptr(
 		    &strp->v8s_info.v8s_slicedinfo.v8s_sliced_parent,
-		    addr, V8_OFF_SLICEDSTRING_PARENT) != 0 ||
-		    read_heap_smi(
+		    &hdr, V8_OFF_SLICEDSTRING_PARENT) != 0 ||
+		    read_header_smi(
 		    &strp->v8s_info.v8s_slicedinfo.v8s_sliced_offset,
-		    addr, V8_OFF_SLICEDSTRING_OFFSET) != 0) {
+		    &hdr, V8_OFF_SLICEDSTRING_OFFSET) != 0) {
 			v8_warn("failed to read slice info: %p\n", addr);
 			goto fail;
 		}
 	} else if (V8_STRREP_EXT(type)) {
-		if (read_heap_ptr(
+		if (read_header_ptr(
 		    &strp->v8s_info.v8s_external.v8s_external_data,
-		    addr, V8_OFF_EXTERNALSTRING_RESOURCE) != 0 ||
+		    &hdr, V8_OFF_EXTERNALSTRING_RESOURCE) != 0 ||
 		    read_heap_ptr(
 		    &strp->v8s_info.v8s_external.v8s_external_nodedata,
 		    strp->v8s_info.v8s_external.v8s_external_data,
@@ -177,9 +206,156 @@ int
 v8string_write(v8string_t *strp, mdbv8_strbuf_t *strb,
     mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags)
 {
+	if (v8string_cache_write(strp->v8s_addr, strb, strflags, v8flags))
+		return (0);
+
+	return (v8string_write_fill(strp, strb, strflags, v8flags));
+}
+
+static v8string_cent_t *
+v8string_cache_slot(uintptr_t addr, mdbv8_strappend_flags_t strflags,
+    v8string_flags_t v8flags)
+{
+	return (&v8string_cache[((addr >> 3) ^ strflags ^
+	    (v8flags >> JSSTR_FLAGSHIFT)) % V8STRING_NCACHE]);
+}
+
+/*
+ * Many of the same strings are written over and over: property names as each
+ * object of a given "class" is printed, and function and script names as each
+ * stack frame or function is described.  Short strings are therefore cached
+ * once they've been written, in a direct-mapped cache (v8string_cache) keyed by
+ * the String's address and the flags used to write it.  v8string_cache_write()
+ * appends the cached form of the string at "addr" to "strb" and returns true if
+ * it's present, and returns false without writing anything otherwise.  This
+ * lets callers that haven't yet loaded the String skip doing so.
+ *
+ * The cache is only used when v8_cache_enabled().  Only strings written in
+ * full are cached, and a cached string is only used if it fits in the buffer
+ * in its entirety, so the output is always exactly what v8string_write()
+ * would have produced.
+ */
+boolean_t
+v8string_cache_write(uintptr_t addr, mdbv8_strbuf_t *strb,
+    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags)
+{
+	v8string_cent_t *centp;
+
+	centp = v8string_cache_slot(addr, strflags, v8flags);
+	if (centp->v8sc_str == NULL || centp->v8sc_addr != addr ||
+	    centp->v8sc_strflags != strflags ||
+	    centp->v8sc_v8flags != v8flags ||
+	    centp->v8sc_nbytes > mdbv8_strbuf_bytesleft(strb))
+		return (B_FALSE);
+
+	v8string_cache_stats_cur.v8cs_hits++;
+	mdbv8_strbuf_appendbytes(strb, centp->v8sc_str, centp->v8sc_nbytes);
+	return (B_TRUE);
+}
+
+/*
+ * Implementation of v8string_write() for strings not found in the cache: writes
+ * the string and caches the result if appropriate.
+ */
+static int
+v8string_write_fill(v8string_t *strp, mdbv8_strbuf_t *strb,
+    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags)
+{
+	v8string_cent_t *centp;
+	v8string_flags_t keyflags = v8flags;
+	const char *start;
+	size_t avail, nbytes;
 	int err;
+	boolean_t cacheable, quoted;
+
+	/*
+	 * Only cache the string if there's room for the longest possible
+	 * encoding of it (four bytes per character), plus the quotes and any
+	 * message describing a failure to read it.  If there is, we know that
+	 * what we write below won't be truncated.
+	 */
+	start = strb->ms_curbuf;
+	avail = mdbv8_strbuf_bytesleft(strb);
+	cacheable = v8_cache_enabled() &&
+	    (v8flags & JSSTR_VERBOSE) == 0 &&
+	    strp->v8s_len <= V8STRING_CACHE_MAXLEN &&
+	    avail >= 4 * strp->v8s_len + V8STRING_CACHE_SLOP;
+
+	quoted = (v8flags & JSSTR_QUOTED) != 0;
+	if (quoted) {
+		mdbv8_strbuf_appendc(strb, '"', strflags);
+		v8flags &= ~JSSTR_QUOTED;
+		mdbv8_strbuf_reserve(strb, 1);
+	}
+
+	err = v8string_write_range(strp, strb, strflags, v8flags, 0, -1, NULL);
+
+	if (quoted) {
+		mdbv8_strbuf_reserve(strb, -1);
+		mdbv8_strbuf_appendc(strb, '"', strflags);
+	}
+
+	if (!cacheable || err != 0)
+		return (err);
+
+	v8string_cache_stats_cur.v8cs_misses++;
+	centp = v8string_cache_slot(strp->v8s_addr, strflags, keyflags);
+	if (centp->v8sc_str != NULL) {
+		v8string_cache_stats_cur.v8cs_evictions++;
+		v8string_cache_stats_cur.v8cs_nbytes -= centp->v8sc_nbytes + 1;
+		mdb_free(centp->v8sc_str, centp->v8sc_nbytes + 1);
+	}
+
+	nbytes = strb->ms_curbuf - start;
+	centp->v8sc_addr = strp->v8s_addr;
+	centp->v8sc_strflags = strflags;
+	centp->v8sc_v8flags = keyflags;
+	centp->v8sc_nbytes = nbytes;
+	centp->v8sc_str = mdb_alloc(nbytes + 1, UM_SLEEP);
+	bcopy(start, centp->v8sc_str, nbytes);
+	centp->v8sc_str[nbytes] = '\0';
+	v8string_cache_stats_cur.v8cs_nbytes += nbytes + 1;
+	return (0);
+}
+
+void
+v8string_cache_stats(v8cache_stats_t *statsp)
+{
+	*statsp = v8string_cache_stats_cur;
+}
+
+void
+v8string_cache_clear(void)
+{
+	v8string_cent_t *centp;
+	size_t i;
+
+	for (i = 0; i < V8STRING_NCACHE; i++) {
+		centp = &v8string_cache[i];
+		if (centp->v8sc_str == NULL)
+			continue;
+
+		mdb_free(centp->v8sc_str, centp->v8sc_nbytes + 1);
+		centp->v8sc_str = NULL;
+	}
+
+	v8string_cache_stats_cur.v8cs_nbytes = 0;
+}
+
+/*
+ * Writes the "length" characters of "strp" starting at "offset" (or, if
+ * "length" is -1, everything from "offset" to the end of the string).  If
+ * "nwrittenp" is non-NULL, the number of characters actually written is
+ * stored there.  This is less than requested if the output was truncated.
+ */
+static int
+v8string_write_range(v8string_t *strp, mdbv8_strbuf_t *strb,
+    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags,
+    size_t offset, ssize_t length, size_t *nwrittenp)
+{
 	uint8_t type;
-	boolean_t quoted;
+	size_t nwritten = 0;
+	int err;
 
 	/*
 	 * XXX For verbose, need to write obj_jstype() replacement that uses
@@ -199,34 +375,45 @@ v8string_write(v8string_t *strp, mdbv8_strbuf_t *strb,
 	else
 		v8flags &= ~JSSTR_ISASCII;
 
-	quoted = (v8flags & JSSTR_QUOTED) != 0;
-	if (quoted) {
-		mdbv8_strbuf_appendc(strb, '"', strflags);
-		v8flags &= ~JSSTR_QUOTED;
-		mdbv8_strbuf_reserve(strb, 1);
-	}
-
 	v8flags = JSSTR_BUMPDEPTH(v8flags) & (~JSSTR_QUOTED);
 	if (V8_STRREP_SEQ(type)) {
-		err = v8string_write_seq(strp, strb, strflags, v8flags, 0, -1);
+		err = v8string_write_seq(strp, strb, strflags, v8flags,
+		    offset, length, &nwritten);
 	} else if (V8_STRREP_CONS(type)) {
-		err = v8string_write_cons(strp, strb, strflags, v8flags);
+		err = v8string_write_cons(strp, strb, strflags, v8flags,
+		    offset, length, &nwritten);
 	} else if (V8_STRREP_EXT(type)) {
-		err = v8string_write_ext(strp, strb, strflags, v8flags);
+		err = v8string_write_ext(strp, strb, strflags, v8flags,
+		    offset, length, &nwritten);
 	} else {
 		/* Types are checked in v8string_load(). */
 		assert(V8_STRREP_SLICED(type));
-		err = v8string_write_sliced(strp, strb, strflags, v8flags);
+		err = v8string_write_sliced(strp, strb, strflags, v8flags,
+		    offset, length, &nwritten);
 	}
 
-	if (quoted) {
-		mdbv8_strbuf_reserve(strb, -1);
-		mdbv8_strbuf_appendc(strb, '"', strflags);
-	}
+	if (nwrittenp != NULL)
+		*nwrittenp = nwritten;
 
 	return (err);
 }
 
+/*
+ * Given a string of "nchars" characters, normalizes the range of characters
+ * denoted by "offset" and "length" (as described for v8string_write_range())
+ * so that it lies within the string.
+ */
+static void
+v8string_range(size_t nchars, size_t offset, ssize_t length,
+    size_t *offsetp, size_t *lengthp)
+{
+	*offsetp = MIN(offset, nchars);
+	if (length == -1 || (size_t)length > nchars - *offsetp)
+		*lengthp = nchars - *offsetp;
+	else
+		*lengthp = length;
+}
+
 /*
  * This structure is used to keep track of state while writing out a sequential
  * string.
@@ -271,15 +458,17 @@ typedef enum {
 
 static v8string_sizecheck_t v8string_write_sizecheck(v8string_write_t *);
 static int v8string_write_seq_chunk(v8string_write_t *);
+static size_t v8string_write_seq_run(v8string_write_t *, size_t);
 
 /*
- * Implementation of v8string_write() for sequential strings.  "usliceoffset"
- * and "uslicelen" denote the a range of characters in the string to write.
+ * Implementation of v8string_write_range() for sequential strings.
+ * "usliceoffset" and "uslicelen" denote the a range of characters in the
+ * string to write.
  */
 static int
 v8string_write_seq(v8string_t *strp, mdbv8_strbuf_t *strb,
     mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags,
-    size_t usliceoffset, ssize_t uslicelen)
+    size_t usliceoffset, ssize_t uslicelen, size_t *nwrittenp)
 {
 	size_t sliceoffset;	/* actual slice offset */
 	size_t slicelen;	/* actual slice length */
@@ -380,6 +569,7 @@ v8string_write_seq(v8string_t *strp, mdbv8_strbuf_t *strb,
 		}
 	}
 
+	*nwrittenp = write.v8sw_nreadchars;
 	return (err);
 }
 
@@ -424,9 +614,23 @@ v8string_write_seq_chunk(v8string_write_t *writep)
 		writep->v8sw_asciicheck = B_FALSE;
 	}
 
+	/*
+	 * Don't split a surrogate pair across chunks.  If this chunk ends with
+	 * the first half of one, leave it to be read again with the next chunk.
+	 */
+	if ((writep->v8sw_v8flags & JSSTR_ISASCII) == 0 &&
+	    !writep->v8sw_chunklast && nbytestoread >= 2 * sizeof (uint16_t) &&
+	    UTF16_ISHIGH(*((uint16_t *)(writep->v8sw_chunk +
+	    nbytestoread - sizeof (uint16_t))))) {
+		nbytestoread -= sizeof (uint16_t);
+	}
+
 	writep->v8sw_chunki = 0;
 	while (writep->v8sw_nreadchars < writep->v8sw_slicelen &&
 	    writep->v8sw_chunki < nbytestoread) {
+		if (v8string_write_seq_run(writep, nbytestoread) != 0)
+			continue;
+
 		sizecheck = v8string_write_sizecheck(writep);
 		if (sizecheck == V8SC_WONTFIT) {
 			/*
@@ -465,16 +669,34 @@ v8string_write_seq_chunk(v8string_write_t *writep)
 		if ((writep->v8sw_v8flags & JSSTR_ISASCII) != 0) {
 			mdbv8_strbuf_appendc(
 			    writep->v8sw_strb,
-			    writep->v8sw_chunk[writep->v8sw_chunki],
+			    (uint8_t)writep->v8sw_chunk[writep->v8sw_chunki],
 			    writep->v8sw_strflags);
 		} else {
-			uint16_t chrval;
+			uint16_t *chrp;
 			assert(writep->v8sw_chunki % 2 == 0);
-			chrval = *((uint16_t *)(
-			    writep->v8sw_chunk + writep->v8sw_chunki));
-			mdbv8_strbuf_appendc(
-			    writep->v8sw_strb, chrval,
-			    writep->v8sw_strflags);
+			chrp = (uint16_t *)(
+			    writep->v8sw_chunk + writep->v8sw_chunki);
+
+			/*
+			 * A surrogate pair has to be written all at once.
+			 */
+			if ((writep->v8sw_strflags & MSF_UTF8) != 0 &&
+			    UTF16_ISHIGH(chrp[0]) &&
+			    writep->v8sw_chunki + sizeof (uint16_t) <
+			    nbytestoread &&
+			    writep->v8sw_nreadchars + 1 <
+			    writep->v8sw_slicelen &&
+			    mdbv8_strbuf_appendutf16(writep->v8sw_strb,
+			    chrp, 2, SIZE_MAX, writep->v8sw_strflags) == 2) {
+				writep->v8sw_readoff +=
+				    writep->v8sw_inbytesperchar;
+				writep->v8sw_nreadchars++;
+				writep->v8sw_chunki +=
+				    writep->v8sw_inbytesperchar;
+			} else {
+				mdbv8_strbuf_appendc(writep->v8sw_strb,
+				    chrp[0], writep->v8sw_strflags);
+			}
 		}
 
 		writep->v8sw_nreadchars++;
@@ -489,11 +711,64 @@ v8string_write_seq_chunk(v8string_write_t *writep)
 	return (0);
 }
 
+/*
+ * Returns the most bytes of output that writing one character (or surrogate
+ * pair) can take.
+ */
+static size_t
+v8string_write_maxbytesperchar(v8string_write_t *writep)
+{
+	return ((writep->v8sw_strflags & MSF_UTF8) != 0 ? 4 : 2);
+}
+
+/*
+ * Copy the run of characters starting at the current position in the chunk
+ * that need no escaping or replacement straight into the output buffer: for
+ * one-byte strings, a plain copy of clean ASCII, and for two-byte strings, a
+ * block transcode with mdbv8_strbuf_appendutf16().  The run is limited so
+ * that, as in the one-at-a-time path, we never use up the space needed for
+ * the truncation marker (see v8string_write_sizecheck()); whatever's left over
+ * goes through that path.  Returns the number of characters written.
+ */
+static size_t
+v8string_write_seq_run(v8string_write_t *writep, size_t nbytestoread)
+{
+	size_t outbytesleft, maxoutbytesperchar;
+	size_t nchars, maxbytes;
+	const char *chunkp;
+
+	maxoutbytesperchar = v8string_write_maxbytesperchar(writep);
+	outbytesleft = mdbv8_strbuf_bytesleft(writep->v8sw_strb);
+	if (outbytesleft <= maxoutbytesperchar + v8s_truncate_marker_bytes)
+		return (0);
+
+	maxbytes = outbytesleft - maxoutbytesperchar -
+	    v8s_truncate_marker_bytes;
+	nchars = MIN((nbytestoread - writep->v8sw_chunki) /
+	    writep->v8sw_inbytesperchar,
+	    writep->v8sw_slicelen - writep->v8sw_nreadchars);
+	chunkp = writep->v8sw_chunk + writep->v8sw_chunki;
+	if ((writep->v8sw_v8flags & JSSTR_ISASCII) != 0) {
+		nchars = mdbv8_strbuf_nclean(chunkp, MIN(nchars, maxbytes),
+		    writep->v8sw_strflags);
+		mdbv8_strbuf_appendbytes(writep->v8sw_strb, chunkp, nchars);
+	} else {
+		nchars = mdbv8_strbuf_appendutf16(writep->v8sw_strb,
+		    (const uint16_t *)chunkp, nchars, maxbytes,
+		    writep->v8sw_strflags);
+	}
+
+	writep->v8sw_readoff += nchars * writep->v8sw_inbytesperchar;
+	writep->v8sw_nreadchars += nchars;
+	writep->v8sw_chunki += nchars * writep->v8sw_inbytesperchar;
+	return (nchars);
+}
+
 static v8string_sizecheck_t
 v8string_write_sizecheck(v8string_write_t *writep)
 {
 	size_t outbytesleft;
-	size_t maxoutbytesperchar = 2;
+	size_t maxoutbytesperchar = v8string_write_maxbytesperchar(writep);
 	size_t i, noutbytes;
 	uint16_t chrval;
 	size_t firstcharbytes, nreadchars;
@@ -522,7 +797,7 @@ v8string_write_sizecheck(v8string_write_t *writep)
 	while (i < writep->v8sw_chunksz &&
 	    writep->v8sw_nreadchars + nreadchars < writep->v8sw_slicelen) {
 		if ((writep->v8sw_v8flags & JSSTR_ISASCII) != 0) {
-			chrval = writep->v8sw_chunk[i];
+			chrval = (uint8_t)writep->v8sw_chunk[i];
 		} else {
 			chrval = *((uint16_t *)(writep->v8sw_chunk + i));
 		}
@@ -557,56 +832,120 @@ v8string_write_sizecheck(v8string_write_t *writep)
 }
 
 /*
- * Implementation of v8string_write() for ConsStrings.
+ * Implementation of v8string_write_range() for ConsStrings.  A ConsString is
+ * the concatenation of two other strings, either of which may itself be a
+ * ConsString, so these form a binary tree whose leaves are the other kinds of
+ * strings.  Building a string by appending to it repeatedly (as with "+=" in a
+ * loop) produces trees that are thousands of levels deep, so rather than
+ * recursing, we walk the tree with an explicit stack of the subtrees that
+ * remain to be written, leftmost on top.  Each node's length is known as soon
+ * as it's loaded, so subtrees that lie entirely before the requested range are
+ * skipped without being descended into, and we stop as soon as we've written
+ * the whole range or the output has been truncated.  The stack is
+ * garbage-collected so that it's reclaimed even if the dcmd is interrupted.
  */
 static int
 v8string_write_cons(v8string_t *strp, mdbv8_strbuf_t *strb,
-    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags)
+    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags,
+    size_t offset, ssize_t length, size_t *nwrittenp)
 {
-	uintptr_t str1addr, str2addr;
-	v8string_t *str1p, *str2p;
-	v8string_flags_t flags;
+	uintptr_t *stack, *newstack;
+	size_t stacksz, nstack;
+	size_t skip, left, nchars, nwritten, nvisited;
+	v8string_t *nodep;
+	uintptr_t addr;
+	int memflags = strp->v8s_memflags;
 	int rv = 0;
 
-	str1addr = strp->v8s_info.v8s_consinfo.v8s_cons_p1;
-	str2addr = strp->v8s_info.v8s_consinfo.v8s_cons_p2;
-	if ((v8flags & JSSTR_VERBOSE) != 0) {
-		mdb_printf("str %p: cons of %p and %p\n",
-		    strp->v8s_addr, str1addr, str2addr);
-	}
+	v8string_range(v8string_length(strp), offset, length, &skip, &left);
+	*nwrittenp = 0;
 
-	str1p = v8string_load(
-	    strp->v8s_info.v8s_consinfo.v8s_cons_p1, strp->v8s_memflags);
-	str2p = v8string_load(
-	    strp->v8s_info.v8s_consinfo.v8s_cons_p2, strp->v8s_memflags);
+	stacksz = 64;
+	stack = mdb_alloc(stacksz * sizeof (uintptr_t), UM_SLEEP | UM_GC);
 
-	if (str1p == NULL || str2p == NULL) {
-		mdbv8_strbuf_sprintf(strb,
-		    "<string (failed to read cons ptrs)>");
-	} else {
-		flags = JSSTR_BUMPDEPTH(v8flags);
-		rv = v8string_write(str1p, strb, strflags, flags);
-		if (rv == 0)
-			rv = v8string_write(str2p, strb, strflags, flags);
+	/*
+	 * A well-formed tree has fewer nodes than twice its length.  Bound
+	 * the walk by that so that a cycle in a corrupt tree can't make it go
+	 * on forever.
+	 */
+	nstack = 0;
+	nvisited = 0;
+	stack[nstack++] = strp->v8s_addr;
+	while (nstack > 0 && left > 0) {
+		addr = stack[--nstack];
+		if (nvisited++ > 2 * v8string_length(strp)) {
+			mdbv8_strbuf_sprintf(strb,
+			    "<string (cons string is malformed)>");
+			break;
+		}
+
+		if (addr == strp->v8s_addr) {
+			nodep = strp;
+		} else if ((nodep = v8string_load(addr, memflags)) == NULL) {
+			mdbv8_strbuf_sprintf(strb,
+			    "<string (failed to read cons ptrs)>");
+			break;
+		}
+
+		nchars = v8string_length(nodep);
+		if (nchars <= skip) {
+			skip -= nchars;
+		} else if (V8_STRREP_CONS(nodep->v8s_type)) {
+			if ((v8flags & JSSTR_VERBOSE) != 0) {
+				mdb_printf("str %p: cons of %p and %p\n",
+				    nodep->v8s_addr,
+				    nodep->v8s_info.v8s_consinfo.v8s_cons_p1,
+				    nodep->v8s_info.v8s_consinfo.v8s_cons_p2);
+			}
+
+			if (nstack + 2 > stacksz) {
+				newstack = mdb_alloc(
+				    2 * stacksz * sizeof (uintptr_t),
+				    UM_SLEEP | UM_GC);
+				bcopy(stack, newstack,
+				    nstack * sizeof (uintptr_t));
+				stack = newstack;
+				stacksz *= 2;
+			}
+
+			stack[nstack++] =
+			    nodep->v8s_info.v8s_consinfo.v8s_cons_p2;
+			stack[nstack++] =
+			    nodep->v8s_info.v8s_consinfo.v8s_cons_p1;
+		} else {
+			nchars = MIN(nchars - skip, left);
+			rv = v8string_write_range(nodep, strb, strflags,
+			    v8flags, skip, nchars, &nwritten);
+			*nwrittenp += nwritten;
+			left -= nchars;
+			skip = 0;
+			if (rv != 0 || nwritten < nchars)
+				left = 0;
+		}
+
+		if (nodep != strp)
+			v8string_free(nodep);
 	}
 
-	v8string_free(str1p);
-	v8string_free(str2p);
 	return (rv);
 }
 
 /*
- * Implementation of v8string_write() for SlicedStrings.
+ * Implementation of v8string_write_range() for SlicedStrings.
  */
 static int
 v8string_write_sliced(v8string_t *strp, mdbv8_strbuf_t *strb,
-    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags)
+    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags,
+    size_t roffset, ssize_t rlength, size_t *nwrittenp)
 {
 	uintptr_t parent, offset, length;
+	size_t soffset, slength;
 	v8string_t *pstrp;
 	v8string_flags_t flags;
 	int rv = 0;
 
+	*nwrittenp = 0;
+
 	parent = strp->v8s_info.v8s_slicedinfo.v8s_sliced_parent;
 	offset = strp->v8s_info.v8s_slicedinfo.v8s_sliced_offset;
 	length = v8string_length(strp);
@@ -630,8 +969,9 @@ v8string_write_sliced(v8string_t *strp, mdbv8_strbuf_t *strb,
 	}
 
 	flags = JSSTR_BUMPDEPTH(v8flags);
+	v8string_range(length, roffset, rlength, &soffset, &slength);
 	rv = v8string_write_seq(pstrp, strb, strflags, flags,
-	    offset, length);
+	    offset + soffset, slength, nwrittenp);
 
 out:
 	v8string_free(pstrp);
@@ -639,21 +979,24 @@ out:
 }
 
 /*
- * Implementation of v8string_write() for ExternalStrings.  This implementation
- * assumes that all external strings are Node strings.
+ * Implementation of v8string_write_range() for ExternalStrings.  This
+ * implementation assumes that all external strings are Node strings.
  */
 static int
 v8string_write_ext(v8string_t *strp, mdbv8_strbuf_t *strb,
-    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags)
+    mdbv8_strappend_flags_t strflags, v8string_flags_t v8flags,
+    size_t roffset, ssize_t rlength, size_t *nwrittenp)
 {
 	char buf[8192];
-	size_t ntotal;
+	size_t ntotal, offset, length;
 	uintptr_t charsp;
 	v8string_write_t write;
 	int err;
 
 	charsp = strp->v8s_info.v8s_external.v8s_external_nodedata;
 	ntotal = v8string_length(strp);
+	v8string_range(ntotal, roffset, rlength, &offset, &length);
+	*nwrittenp = 0;
 
 	if ((v8flags & JSSTR_VERBOSE) != 0) {
 		mdbv8_strbuf_sprintf(strb,
@@ -671,18 +1014,18 @@ v8string_write_ext(v8string_t *strp, mdbv8_strbuf_t *strb,
 	write.v8sw_strp = strp;
 	write.v8sw_v8flags = v8flags;
 	write.v8sw_charsp = charsp;
-	write.v8sw_readoff = 0;
+	write.v8sw_readoff = offset;
 	write.v8sw_inbytesperchar = 1;
 	write.v8sw_nreadchars = 0;
-	write.v8sw_sliceoffset = 0;
-	write.v8sw_slicelen = ntotal;
+	write.v8sw_sliceoffset = offset;
+	write.v8sw_slicelen = length;
 	write.v8sw_strb = strb;
 	write.v8sw_strflags = strflags;
 	write.v8sw_chunk = buf;
 	write.v8sw_chunksz = sizeof (buf);
 	write.v8sw_chunki = 0;
 	write.v8sw_chunklast = B_FALSE;
-	write.v8sw_done = ntotal == 0;
+	write.v8sw_done = length == 0;
 	write.v8sw_asciicheck = B_TRUE;
 	err = 0;
 
@@ -693,5 +1036,6 @@ v8string_write_ext(v8string_t *strp, mdbv8_strbuf_t *strb,
 		}
 	}
 
+	*nwrittenp = write.v8sw_nreadchars;
 	return (err);
 }
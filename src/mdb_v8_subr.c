@@ -18,6 +18,22 @@
 #include "v8dbg.h"
 #include "mdb_v8_dbg.h"
 #include "mdb_v8_impl.h"
+#include "mdb_v8_dbi.h"
+
+/*
+ * Besides the page cache in mdb_v8_dbi.c, mdb_v8 keeps caches of the results
+ * of decoding various heap objects: Map shapes, strings, scripts' line-ends
+ * tables, and descriptions of stack frames' functions.  These are keyed by the
+ * address of the object they came from and are never revalidated, which is
+ * only correct if the target's memory can't change.  So they're only used for
+ * core files: each cache checks v8_cache_enabled() before adding an entry.
+ * "::v8cache" reports their statistics and discards their contents.
+ */
+boolean_t
+v8_cache_enabled(void)
+{
+	return (mdb_get_state() == MDB_STATE_DEAD);
+}
 
 struct v8fixedarray {
 	uintptr_t	v8fa_addr;
@@ -69,7 +85,8 @@ v8fixedarray_free(v8fixedarray_t *arrayp)
  *
  * This implementation is careful to avoid needing memory proportional to the
  * array size, as that makes it very difficult for end users to work with very
- * large arrays.
+ * large arrays.  If the array is available directly from a mapped core file,
+ * we iterate it in place instead.
  */
 int
 v8fixedarray_iter_elements(v8fixedarray_t *arrayp,
@@ -79,6 +96,7 @@ v8fixedarray_iter_elements(v8fixedarray_t *arrayp,
 	int maxnpgelts = 1024;
 	int curnpgelts;
 	uintptr_t *buf;
+	const uintptr_t *elts;
 	uintptr_t addr;
 	unsigned int index, length, i;
 	size_t maxpgsz, curpgsz;
@@ -89,10 +107,20 @@ v8fixedarray_iter_elements(v8fixedarray_t *arrayp,
 		return (0);
 	}
 
+	addr = arrayp->v8fa_addr + V8_OFF_FIXEDARRAY_DATA;
+	if ((elts = dbi_vptr(addr, length * sizeof (elts[0]))) != NULL) {
+		for (index = 0; index < length; index++) {
+			rv = func(arrayp, index, elts[index], uarg);
+			if (rv != 0) {
+				break;
+			}
+		}
+
+		return (rv);
+	}
+
 	maxpgsz = maxnpgelts * sizeof (buf[0]);
 	buf = alloca(maxpgsz);
-
-	addr = arrayp->v8fa_addr + V8_OFF_FIXEDARRAY_DATA;
 	index = 0;
 
 	do {
@@ -148,7 +176,7 @@ v8fixedarray_as_array(v8fixedarray_t *arrayp, int memflags)
 		return (NULL);
 	}
 
-	if (mdb_vread(elts, arraysz,
+	if (dbi_vread(elts, arraysz,
 	    arrayp->v8fa_addr + V8_OFF_FIXEDARRAY_DATA) == -1) {
 		maybefree(elts, arraysz, memflags);
 		return (NULL);
@@ -167,14 +195,13 @@ v8fixedarray_length(v8fixedarray_t *arrayp)
 }
 
 /*
- * Attempts to determine whether the object at "addr" might contain the address
- * "target".  This is used for low-level heuristic analysis.  Note that it's
- * possible that we cannot tell whether the address is contained (e.g., if this
- * is a variable-length object and we can't read how big it is).
+ * Attempts to determine the size in bytes of the heap object at "addr", whose
+ * type is "type".  This is used for low-level heuristic analysis.  Note that
+ * it's possible that we cannot tell how big the object is (e.g., if this is a
+ * variable-length object and we can't read its length).
  */
 int
-v8contains(uintptr_t addr, uint8_t type, uintptr_t target,
-    boolean_t *containsp)
+v8heapobject_size(uintptr_t addr, uint8_t type, size_t *sizep)
 {
 	size_t size;
 	uintptr_t objsize;
@@ -202,7 +229,7 @@ v8contains(uintptr_t addr, uint8_t type, uintptr_t target,
 		}
 
 		v8string_free(strp);
-		*containsp = target < addr + size;
+		*sizep = size;
 		return (0);
 	}
 
@@ -217,7 +244,7 @@ v8contains(uintptr_t addr, uint8_t type, uintptr_t target,
 		length = v8fixedarray_length(arrayp);
 		size = V8_OFF_FIXEDARRAY_DATA + length * sizeof (uintptr_t);
 		v8fixedarray_free(arrayp);
-		*containsp = target < addr + size;
+		*sizep = size;
 		return (0);
 	}
 
@@ -248,6 +275,26 @@ v8contains(uintptr_t addr, uint8_t type, uintptr_t target,
 		size += ninprops * sizeof (uintptr_t);
 	}
 
+	*sizep = size;
+	return (0);
+}
+
+/*
+ * Attempts to determine whether the object at "addr" might contain the address
+ * "target".  This is used for low-level heuristic analysis.  Note that it's
+ * possible that we cannot tell whether the address is contained (e.g., if this
+ * is a variable-length object and we can't read how big it is).
+ */
+int
+v8contains(uintptr_t addr, uint8_t type, uintptr_t target,
+    boolean_t *containsp)
+{
+	size_t size;
+
+	if (v8heapobject_size(addr, type, &size) != 0) {
+		return (-1);
+	}
+
 	*containsp = target < addr + size;
 	return (0);
 }
@@ -13,11 +13,78 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 
 #include "v8dbg.h"
 #include "mdb_v8_dbg.h"
 #include "mdb_v8_impl.h"
 
+/*
+ * The object-start index records the start address, type, and (when it can be
+ * determined cheaply) size of each heap object found during a heap scan, along
+ * with the ranges of memory that were scanned.  Once built, entries are sorted
+ * by address so that v8whatis() can find the object containing an address with
+ * a binary search rather than by probing backwards through memory.
+ *
+ * The heap scan reports every pointer-aligned word that looks like a tagged
+ * Map pointer, so the raw list contains false positives (e.g., Map pointers
+ * stored in fields of other objects).  We discard candidates whose "Map" is not
+ * itself a Map, and when the index is finished we discard candidates that fall
+ * inside the extent of a preceding object whose size we know.
+ */
+typedef struct v8whatis_entry {
+	uintptr_t	v8wie_addr;	/* tagged start address of object */
+	uint32_t	v8wie_size;	/* size of object (0 if unknown) */
+	uint8_t		v8wie_type;	/* type of object */
+} v8whatis_entry_t;
+
+typedef struct v8whatis_range {
+	uintptr_t	v8wir_base;	/* start of scanned range */
+	size_t		v8wir_size;	/* size of scanned range */
+} v8whatis_range_t;
+
+/*
+ * While the index is being built (and while resolving a batch of addresses),
+ * we keep a small direct-mapped cache of the Maps we've seen.  Most heap
+ * objects share a relatively small number of Maps, so this avoids reading each
+ * Map's header once per object.
+ */
+typedef struct v8whatis_mapinfo {
+	uintptr_t	v8wim_addr;	/* address of Map (0 if slot unused) */
+	boolean_t	v8wim_valid;	/* Map appears to be a Map */
+	uint8_t		v8wim_type;	/* instance type described by Map */
+	uint8_t		v8wim_size;	/* instance size, in words */
+} v8whatis_mapinfo_t;
+
+#define	V8WI_NMAPS	4096
+
+typedef struct v8whatis_index {
+	boolean_t		v8wi_ready;	/* index is complete */
+	v8whatis_entry_t	*v8wi_entries;	/* objects, sorted by addr */
+	size_t			v8wi_nentries;	/* count of valid entries */
+	size_t			v8wi_maxentries; /* count of alloc'd entries */
+	v8whatis_range_t	*v8wi_ranges;	/* ranges, sorted by addr */
+	size_t			v8wi_nranges;	/* count of valid ranges */
+	size_t			v8wi_maxranges;	/* count of alloc'd ranges */
+	v8whatis_mapinfo_t	*v8wi_maps;	/* Map cache (while building) */
+} v8whatis_index_t;
+
+static v8whatis_index_t v8whatis_index;
+
+/*
+ * When resolving a batch of addresses, we read memory through a window of at
+ * least this many bytes that slides forward through the sorted addresses.
+ */
+#define	V8WB_WINDOWSZ	(64 * 1024)
+
+typedef struct v8whatis_batchent {
+	uintptr_t	v8wbe_addr;	/* tagged, aligned target address */
+	size_t		v8wbe_idx;	/* index into caller's arrays */
+} v8whatis_batchent_t;
+
+static v8whatis_mapinfo_t *v8whatis_mapinfo(v8whatis_mapinfo_t *, uintptr_t);
+static int v8whatis_index_lookup(uintptr_t, v8whatis_t *, v8whatis_error_t *);
+
 /*
  * v8whatis() attempts to find the V8 heap object that contains "addr" by
  * looking at up to "maxoffset" bytes leading up to "addr" for the specific
@@ -36,9 +103,11 @@ v8whatis(uintptr_t addr, size_t maxoffset, v8whatis_t *whatisp)
 	size_t curoffset;
 	boolean_t contained;
 	uint8_t typebyte;
+	v8whatis_error_t err;
 
 	origaddr = addr;
 	whatisp->v8w_origaddr = origaddr;
+	whatisp->v8w_indexed = B_FALSE;
 
 	/*
 	 * Objects will always be stored at pointer-aligned addresses.  If we're
@@ -62,6 +131,15 @@ v8whatis(uintptr_t addr, size_t maxoffset, v8whatis_t *whatisp)
 	addr |= V8_HeapObjectTag;
 	whatisp->v8w_addr = addr;
 
+	/*
+	 * If we've built an object-start index that covers this address, then
+	 * it tells us exactly which object (if any) starts closest below the
+	 * target, and "maxoffset" is irrelevant.
+	 */
+	if (v8whatis_index_lookup(addr, whatisp, &err) == 0) {
+		return (err);
+	}
+
 	/*
 	 * At this point, we walk backwards from the address we're given looking
 	 * for something that looks like a V8 heap object.
@@ -128,3 +206,455 @@ v8whatis(uintptr_t addr, size_t maxoffset, v8whatis_t *whatisp)
 
 	return (V8W_OK);
 }
+
+/*
+ * Discard any existing object-start index and prepare to build a new one.
+ */
+void
+v8whatis_index_begin(void)
+{
+	v8whatis_index_t *wip = &v8whatis_index;
+
+	maybefree(wip->v8wi_entries,
+	    wip->v8wi_maxentries * sizeof (wip->v8wi_entries[0]), UM_SLEEP);
+	maybefree(wip->v8wi_ranges,
+	    wip->v8wi_maxranges * sizeof (wip->v8wi_ranges[0]), UM_SLEEP);
+	maybefree(wip->v8wi_maps,
+	    V8WI_NMAPS * sizeof (wip->v8wi_maps[0]), UM_SLEEP);
+	bzero(wip, sizeof (*wip));
+
+	wip->v8wi_maps = mdb_zalloc(V8WI_NMAPS * sizeof (wip->v8wi_maps[0]),
+	    UM_SLEEP);
+}
+
+/*
+ * Record that the range of memory ["base", "base" + "size") is being scanned.
+ * Subsequent calls to v8whatis_index_add() describe objects in this range.
+ */
+void
+v8whatis_index_range(uintptr_t base, size_t size)
+{
+	v8whatis_index_t *wip = &v8whatis_index;
+	v8whatis_range_t *newranges;
+	size_t newmax;
+
+	if (wip->v8wi_nranges == wip->v8wi_maxranges) {
+		newmax = wip->v8wi_maxranges == 0 ? 64 :
+		    wip->v8wi_maxranges * 2;
+		newranges = mdb_zalloc(newmax * sizeof (newranges[0]),
+		    UM_SLEEP);
+		if (wip->v8wi_nranges > 0) {
+			bcopy(wip->v8wi_ranges, newranges,
+			    wip->v8wi_nranges * sizeof (newranges[0]));
+			mdb_free(wip->v8wi_ranges,
+			    wip->v8wi_maxranges * sizeof (newranges[0]));
+		}
+
+		wip->v8wi_ranges = newranges;
+		wip->v8wi_maxranges = newmax;
+	}
+
+	wip->v8wi_ranges[wip->v8wi_nranges].v8wir_base = base;
+	wip->v8wi_ranges[wip->v8wi_nranges].v8wir_size = size;
+	wip->v8wi_nranges++;
+}
+
+/*
+ * Returns information about the Map at "map", reading it from the target if
+ * it's not already in the cache "maps" (an array of V8WI_NMAPS entries).
+ * Returns NULL if "map" does not appear to be a Map.
+ */
+static v8whatis_mapinfo_t *
+v8whatis_mapinfo(v8whatis_mapinfo_t *maps, uintptr_t map)
+{
+	v8whatis_mapinfo_t *mip;
+	uint8_t typebyte;
+
+	mip = &maps[(map >> V8_PointerSizeLog2) % V8WI_NMAPS];
+	if (mip->v8wim_addr != map) {
+		mip->v8wim_addr = map;
+		mip->v8wim_valid = read_typebyte(&typebyte, map) == 0 &&
+		    typebyte == V8_TYPE_MAP &&
+		    mdb_vread(&mip->v8wim_type, sizeof (mip->v8wim_type),
+		    map + V8_OFF_MAP_INSTANCE_ATTRIBUTES) != -1 &&
+		    mdb_vread(&mip->v8wim_size, sizeof (mip->v8wim_size),
+		    map + V8_OFF_MAP_INSTANCE_SIZE) != -1;
+	}
+
+	return (mip->v8wim_valid ? mip : NULL);
+}
+
+/*
+ * Record a candidate heap object at "addr" whose first word is "map".  This
+ * must be called after v8whatis_index_range() has been called for the range
+ * containing "addr".
+ */
+void
+v8whatis_index_add(uintptr_t addr, uintptr_t map)
+{
+	v8whatis_index_t *wip = &v8whatis_index;
+	v8whatis_mapinfo_t *mip;
+	v8whatis_range_t *rp;
+	v8whatis_entry_t *ep, *newentries;
+	size_t size, newmax;
+	uint8_t type;
+
+	assert(wip->v8wi_nranges > 0);
+	rp = &wip->v8wi_ranges[wip->v8wi_nranges - 1];
+
+	if ((addr & (sizeof (uintptr_t) - 1)) != V8_HeapObjectTag ||
+	    !V8_IS_HEAPOBJECT(map) ||
+	    (mip = v8whatis_mapinfo(wip->v8wi_maps, map)) == NULL) {
+		return;
+	}
+
+	/*
+	 * For fixed-size objects, the Map tells us the size.  Of the
+	 * variable-sized objects, sequential strings and FixedArrays are common
+	 * enough (and cheap enough to measure) that it's worth reading their
+	 * lengths.  We ignore any size that runs off the end of the range, as
+	 * this is most likely a false positive that would otherwise cause us to
+	 * discard valid objects that follow it.
+	 */
+	type = mip->v8wim_type;
+	size = (size_t)mip->v8wim_size << V8_PointerSizeLog2;
+	if (size == 0 && ((V8_TYPE_STRING(type) && V8_STRREP_SEQ(type)) ||
+	    type == V8_TYPE_FIXEDARRAY) &&
+	    v8heapobject_size(addr, type, &size) != 0) {
+		size = 0;
+	}
+
+	if (size > UINT32_MAX ||
+	    addr - V8_HeapObjectTag + size > rp->v8wir_base + rp->v8wir_size) {
+		size = 0;
+	}
+
+	if (wip->v8wi_nentries == wip->v8wi_maxentries) {
+		newmax = wip->v8wi_maxentries == 0 ? 4096 :
+		    wip->v8wi_maxentries * 2;
+		newentries = mdb_alloc(newmax * sizeof (newentries[0]),
+		    UM_SLEEP);
+		if (wip->v8wi_nentries > 0) {
+			bcopy(wip->v8wi_entries, newentries,
+			    wip->v8wi_nentries * sizeof (newentries[0]));
+			mdb_free(wip->v8wi_entries,
+			    wip->v8wi_maxentries * sizeof (newentries[0]));
+		}
+
+		wip->v8wi_entries = newentries;
+		wip->v8wi_maxentries = newmax;
+	}
+
+	ep = &wip->v8wi_entries[wip->v8wi_nentries++];
+	ep->v8wie_addr = addr;
+	ep->v8wie_size = (uint32_t)size;
+	ep->v8wie_type = type;
+}
+
+static int
+v8whatis_index_cmp_entries(const void *l, const void *r)
+{
+	const v8whatis_entry_t *lhs = l;
+	const v8whatis_entry_t *rhs = r;
+
+	if (lhs->v8wie_addr < rhs->v8wie_addr)
+		return (-1);
+
+	return (lhs->v8wie_addr > rhs->v8wie_addr ? 1 : 0);
+}
+
+static int
+v8whatis_index_cmp_ranges(const void *l, const void *r)
+{
+	const v8whatis_range_t *lhs = l;
+	const v8whatis_range_t *rhs = r;
+
+	if (lhs->v8wir_base < rhs->v8wir_base)
+		return (-1);
+
+	return (lhs->v8wir_base > rhs->v8wir_base ? 1 : 0);
+}
+
+/*
+ * Sort the index, discard candidates that fall inside other objects, and mark
+ * the index ready for use by v8whatis().
+ */
+void
+v8whatis_index_finish(void)
+{
+	v8whatis_index_t *wip = &v8whatis_index;
+	v8whatis_entry_t *ep;
+	uintptr_t end;
+	size_t i, n;
+
+	maybefree(wip->v8wi_maps, V8WI_NMAPS * sizeof (wip->v8wi_maps[0]),
+	    UM_SLEEP);
+	wip->v8wi_maps = NULL;
+
+	qsort(wip->v8wi_ranges, wip->v8wi_nranges,
+	    sizeof (wip->v8wi_ranges[0]), v8whatis_index_cmp_ranges);
+	qsort(wip->v8wi_entries, wip->v8wi_nentries,
+	    sizeof (wip->v8wi_entries[0]), v8whatis_index_cmp_entries);
+
+	end = 0;
+	for (i = 0, n = 0; i < wip->v8wi_nentries; i++) {
+		ep = &wip->v8wi_entries[i];
+		if (ep->v8wie_addr < end) {
+			continue;
+		}
+
+		if (ep->v8wie_size != 0) {
+			end = ep->v8wie_addr + ep->v8wie_size;
+		}
+
+		wip->v8wi_entries[n++] = *ep;
+	}
+
+	wip->v8wi_nentries = n;
+	wip->v8wi_ready = B_TRUE;
+}
+
+/*
+ * Returns true if the object-start index has been built.
+ */
+boolean_t
+v8whatis_index_ready(void)
+{
+	return (v8whatis_index.v8wi_ready);
+}
+
+/*
+ * Returns the number of objects in the object-start index.
+ */
+size_t
+v8whatis_index_count(void)
+{
+	return (v8whatis_index.v8wi_ready ? v8whatis_index.v8wi_nentries : 0);
+}
+
+/*
+ * Use the object-start index to find the object containing "addr" (which must
+ * already be tagged).  Returns -1 if there's no index or if the index doesn't
+ * cover "addr".  Otherwise, fills in "whatisp" and "errp" as described for
+ * v8whatis() and returns 0.
+ */
+static int
+v8whatis_index_lookup(uintptr_t addr, v8whatis_t *whatisp,
+    v8whatis_error_t *errp)
+{
+	v8whatis_index_t *wip = &v8whatis_index;
+	v8whatis_range_t *rp;
+	v8whatis_entry_t *ep;
+	size_t lower, upper, mid;
+	boolean_t contained;
+
+	if (!wip->v8wi_ready || wip->v8wi_nranges == 0) {
+		return (-1);
+	}
+
+	/*
+	 * Find the last scanned range starting at or below the address, and
+	 * make sure it actually contains the address.
+	 */
+	lower = 0;
+	upper = wip->v8wi_nranges;
+	while (lower < upper) {
+		mid = (lower + upper) / 2;
+		if (wip->v8wi_ranges[mid].v8wir_base <= addr) {
+			lower = mid + 1;
+		} else {
+			upper = mid;
+		}
+	}
+
+	if (lower == 0) {
+		return (-1);
+	}
+
+	rp = &wip->v8wi_ranges[lower - 1];
+	if (addr >= rp->v8wir_base + rp->v8wir_size) {
+		return (-1);
+	}
+
+	whatisp->v8w_indexed = B_TRUE;
+
+	/*
+	 * Now find the last object starting at or below the address.
+	 */
+	lower = 0;
+	upper = wip->v8wi_nentries;
+	while (lower < upper) {
+		mid = (lower + upper) / 2;
+		if (wip->v8wi_entries[mid].v8wie_addr <= addr) {
+			lower = mid + 1;
+		} else {
+			upper = mid;
+		}
+	}
+
+	if (lower == 0 ||
+	    wip->v8wi_entries[lower - 1].v8wie_addr < rp->v8wir_base) {
+		*errp = V8W_ERR_NOTFOUND;
+		return (0);
+	}
+
+	ep = &wip->v8wi_entries[lower - 1];
+	whatisp->v8w_baseaddr = ep->v8wie_addr;
+	whatisp->v8w_basetype = ep->v8wie_type;
+
+	/*
+	 * The size we recorded is conservative, so if the address falls
+	 * outside it, fall back to the same check that v8whatis() uses.
+	 */
+	if (addr < ep->v8wie_addr + ep->v8wie_size ||
+	    v8contains(ep->v8wie_addr, ep->v8wie_type, addr,
+	    &contained) != 0 || contained) {
+		*errp = V8W_OK;
+	} else {
+		*errp = V8W_ERR_DOESNTCONTAIN;
+	}
+
+	return (0);
+}
+
+static int
+v8whatis_batch_cmp(const void *l, const void *r)
+{
+	const v8whatis_batchent_t *lhs = l;
+	const v8whatis_batchent_t *rhs = r;
+
+	if (lhs->v8wbe_addr < rhs->v8wbe_addr)
+		return (-1);
+
+	return (lhs->v8wbe_addr > rhs->v8wbe_addr ? 1 : 0);
+}
+
+/*
+ * v8whatis_batch() is equivalent to invoking v8whatis() on each of the
+ * "naddrs" addresses in "addrs", storing the results into the corresponding
+ * elements of "whatis" and "errs".  Rather than probing memory separately for
+ * each address, we sort the addresses and make a single forward pass through
+ * memory, reading it through a window that's shared by nearby addresses.  We
+ * also cache what we learn about each Map we encounter.  This makes a big
+ * difference when resolving thousands of addresses from a pipeline (e.g., from
+ * ::ugrep), since those tend to be clustered in the heap.
+ */
+void
+v8whatis_batch(const uintptr_t *addrs, size_t naddrs, size_t maxoffset,
+    v8whatis_t *whatis, v8whatis_error_t *errs)
+{
+	v8whatis_batchent_t *ents;
+	v8whatis_mapinfo_t *maps, *mip;
+	v8whatis_t *whatisp;
+	v8whatis_error_t *errp;
+	uintptr_t *window;
+	uintptr_t addr, curaddr, map, lo, hi, wbase, wlimit, ptrlowbits;
+	size_t i, nwords, span, windowsz, curoffset;
+	boolean_t contained;
+
+	if (naddrs == 0) {
+		return;
+	}
+
+	ptrlowbits = sizeof (uintptr_t) - 1;
+	nwords = (maxoffset + ptrlowbits) / sizeof (uintptr_t);
+	span = nwords * sizeof (uintptr_t);
+	windowsz = span + V8WB_WINDOWSZ;
+
+	ents = mdb_alloc(naddrs * sizeof (ents[0]), UM_SLEEP);
+	maps = mdb_zalloc(V8WI_NMAPS * sizeof (maps[0]), UM_SLEEP);
+	window = mdb_alloc(windowsz, UM_SLEEP);
+
+	for (i = 0; i < naddrs; i++) {
+		whatisp = &whatis[i];
+		whatisp->v8w_origaddr = addrs[i];
+		whatisp->v8w_addr = (addrs[i] & ~ptrlowbits) | V8_HeapObjectTag;
+		whatisp->v8w_indexed = B_FALSE;
+		ents[i].v8wbe_addr = whatisp->v8w_addr;
+		ents[i].v8wbe_idx = i;
+	}
+
+	qsort(ents, naddrs, sizeof (ents[0]), v8whatis_batch_cmp);
+
+	wbase = wlimit = 0;
+	for (i = 0; i < naddrs; i++) {
+		addr = ents[i].v8wbe_addr;
+		whatisp = &whatis[ents[i].v8wbe_idx];
+		errp = &errs[ents[i].v8wbe_idx];
+
+		if (v8whatis_index_lookup(addr, whatisp, errp) == 0) {
+			continue;
+		}
+
+		if (nwords == 0) {
+			*errp = V8W_ERR_NOTFOUND;
+			continue;
+		}
+
+		/*
+		 * We need the Map word of each candidate object from "addr"
+		 * back through "addr" - "maxoffset".  If that's not in the
+		 * current window, slide the window forward so that it starts
+		 * with the lowest word we need.  If we can't read that much
+		 * (e.g., because the window runs off the end of a mapping),
+		 * try to read just what we need for this address, and if that
+		 * fails too, fall back to resolving this address by itself.
+		 */
+		hi = addr + V8_OFF_HEAPOBJECT_MAP + sizeof (uintptr_t);
+		if (hi < span) {
+			*errp = v8whatis(whatisp->v8w_origaddr, maxoffset,
+			    whatisp);
+			continue;
+		}
+
+		lo = hi - span;
+		if (lo < wbase || hi > wlimit) {
+			wbase = lo;
+			if (mdb_vread(window, windowsz, wbase) != -1) {
+				wlimit = wbase + windowsz;
+			} else if (mdb_vread(window, span, wbase) != -1) {
+				wlimit = hi;
+			} else {
+				wlimit = wbase;
+				*errp = v8whatis(whatisp->v8w_origaddr,
+				    maxoffset, whatisp);
+				continue;
+			}
+		}
+
+		/*
+		 * This is the same search that v8whatis() does, except that we
+		 * read the Map words out of our window and the Maps themselves
+		 * through the cache.
+		 */
+		mip = NULL;
+		for (curoffset = 0; curoffset < maxoffset;
+		    curoffset += sizeof (uintptr_t)) {
+			curaddr = addr - curoffset;
+			map = window[(curaddr + V8_OFF_HEAPOBJECT_MAP - wbase) /
+			    sizeof (uintptr_t)];
+			if ((mip = v8whatis_mapinfo(maps, map)) != NULL) {
+				break;
+			}
+		}
+
+		if (mip == NULL) {
+			*errp = V8W_ERR_NOTFOUND;
+			continue;
+		}
+
+		whatisp->v8w_baseaddr = curaddr;
+		whatisp->v8w_basetype = mip->v8wim_type;
+
+		if (v8contains(curaddr, mip->v8wim_type, addr,
+		    &contained) == 0 && !contained) {
+			*errp = V8W_ERR_DOESNTCONTAIN;
+		} else {
+			*errp = V8W_OK;
+		}
+	}
+
+	mdb_free(window, windowsz);
+	mdb_free(maps, V8WI_NMAPS * sizeof (maps[0]));
+	mdb_free(ents, naddrs * sizeof (ents[0]));
+}
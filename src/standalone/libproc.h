@@ -0,0 +1,47 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2018, Joyent, Inc.
+ */
+
+/*
+ * libproc.h: the subset of libproc that mdb_v8 uses, for the standalone build.
+ * The standalone program's Pmapping_iter() iterates the mappings described by
+ * the core file it has opened.  See mdbv8_target.c.
+ */
+
+#ifndef	_MDBV8_STANDALONE_LIBPROC_H
+#define	_MDBV8_STANDALONE_LIBPROC_H
+
+#include <sys/mdb_modapi.h>
+
+#define	PRMAPSZ		64
+
+#define	MA_EXEC		0x01	/* executable by the traced process */
+#define	MA_WRITE	0x02	/* writable by the traced process */
+#define	MA_READ		0x04	/* readable by the traced process */
+#define	MA_SHARED	0x08	/* changes are shared by mapped object */
+#define	MA_BREAK	0x10	/* grown by brk(2) */
+#define	MA_STACK	0x20	/* grown automatically on stack faults */
+#define	MA_ANON		0x40	/* anonymous memory */
+
+typedef struct prmap {
+	uintptr_t	pr_vaddr;		/* virtual address of mapping */
+	size_t		pr_size;		/* size of mapping in bytes */
+	char		pr_mapname[PRMAPSZ];	/* name in /proc/<pid>/object */
+	off_t		pr_offset;		/* offset into mapped object */
+	int		pr_mflags;		/* protection and attributes */
+	int		pr_pagesize;		/* pagesize for this mapping */
+} prmap_t;
+
+struct ps_prochandle;
+
+typedef int proc_map_f(void *, const prmap_t *, const char *);
+
+extern int Pmapping_iter(struct ps_prochandle *, proc_map_f *, void *);
+
+#endif	/* _MDBV8_STANDALONE_LIBPROC_H */
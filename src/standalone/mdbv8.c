@@ -0,0 +1,652 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2018, Joyent, Inc.
+ */
+
+/*
+ * mdbv8.c: standalone program for running mdb_v8's analysis over core files
+ * without mdb.  The debugger module's sources are compiled as-is into this
+ * program, with mdbv8_modapi.c and mdbv8_target.c providing the subset of the
+ * MDB module API that they use (plus the few target facilities that the module
+ * gets through mdb_v8_dbi.c).  This allows the same commands to be run in
+ * batch against core files from systems where mdb isn't available (notably
+ * Linux), and against many core files at once:
+ *
+ *     mdbv8 [-b binary] [-e command]... [-f cmdfile] [-j njobs] [-o outdir]
+ *         core...
+ *
+ * Commands are written as they would be in mdb, including pipelines (e.g.,
+ * "::findjsobjects -c Foo | ::findjsobjects | ::jsprint").  Only dcmds and
+ * walkers are supported; mdb's expression language is not.  The builtin
+ * "::walk", "::dcmds", "::walkers", and "::help" dcmds work as they do in mdb.
+ *
+ * If no commands are given with -e or -f, commands are read from stdin.  If
+ * there are multiple core files, each one is processed in a separate process,
+ * up to "njobs" at a time.  With -o, the output for each core file is written
+ * to a file in "outdir" named after the core file.
+ */
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <unistd.h>
+
+#include "mdbv8.h"
+#include "mdb_v8_dbi.h"
+
+extern const mdb_modinfo_t *_mdb_init(void);
+
+#define	MDBV8_MAXARGS	64
+#define	MDBV8_MAXSTAGES	8
+
+/*
+ * One element of a pipeline: "[addr]::dcmd [arg...]".
+ */
+typedef struct mdbv8_stage {
+	uintptr_t	ms_addr;
+	uint_t		ms_flags;
+	const char	*ms_dcmd;
+	int		ms_argc;
+	mdb_arg_t	ms_argv[MDBV8_MAXARGS];
+} mdbv8_stage_t;
+
+static boolean_t mdbv8_quit;
+
+/* ARGSUSED */
+static int
+mdbv8_walk_print(uintptr_t addr, const void *data, void *arg)
+{
+	mdb_printf("%p\n", addr);
+	return (WALK_NEXT);
+}
+
+static int
+mdbv8_dcmd_walk(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+{
+	if (argc != 1 || argv[0].a_type != MDB_TYPE_STRING)
+		return (DCMD_USAGE);
+
+	if (mdb_pwalk(argv[0].a_un.a_str, mdbv8_walk_print, NULL,
+	    (flags & DCMD_ADDRSPEC) != 0 ? addr : 0) != 0) {
+		mdb_warn("failed to walk \"%s\"\n", argv[0].a_un.a_str);
+		return (DCMD_ERR);
+	}
+
+	return (DCMD_OK);
+}
+
+static const mdb_dcmd_t *mdbv8_builtins;
+static const mdb_modinfo_t *mdbv8_modinfo;
+
+/* ARGSUSED */
+static int
+mdbv8_dcmd_dcmds(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+{
+	const mdb_dcmd_t *dp;
+
+	if (argc != 0)
+		return (DCMD_USAGE);
+
+	for (dp = mdbv8_builtins; dp->dc_name != NULL; dp++)
+		mdb_printf("%-19s - %s\n", dp->dc_name, dp->dc_descr);
+
+	for (dp = mdbv8_modinfo->mi_dcmds; dp->dc_name != NULL; dp++)
+		mdb_printf("%-19s - %s\n", dp->dc_name, dp->dc_descr);
+
+	return (DCMD_OK);
+}
+
+/* ARGSUSED */
+static int
+mdbv8_dcmd_walkers(uintptr_t addr, uint_t flags, int argc,
+    const mdb_arg_t *argv)
+{
+	const mdb_walker_t *wp;
+
+	if (argc != 0)
+		return (DCMD_USAGE);
+
+	for (wp = mdbv8_modinfo->mi_walkers; wp->walk_name != NULL; wp++)
+		mdb_printf("%-19s - %s\n", wp->walk_name, wp->walk_descr);
+
+	return (DCMD_OK);
+}
+
+/* ARGSUSED */
+static int
+mdbv8_dcmd_help(uintptr_t addr, uint_t flags, int argc, const mdb_arg_t *argv)
+{
+	const mdb_dcmd_t *dp, *tables[2];
+	const char *usage;
+	int i;
+
+	if (argc != 1 || argv[0].a_type != MDB_TYPE_STRING)
+		return (DCMD_USAGE);
+
+	tables[0] = mdbv8_builtins;
+	tables[1] = mdbv8_modinfo->mi_dcmds;
+	for (i = 0; i < 2; i++) {
+		for (dp = tables[i]; dp->dc_name != NULL; dp++) {
+			if (strcmp(dp->dc_name, argv[0].a_un.a_str) == 0)
+				break;
+		}
+
+		if (dp->dc_name != NULL)
+			break;
+	}
+
+	if (i == 2) {
+		mdb_warn("unknown dcmd: %s\n", argv[0].a_un.a_str);
+		return (DCMD_ERR);
+	}
+
+	usage = dp->dc_usage != NULL ? dp->dc_usage : "";
+	mdb_printf("NAME\n  %s - %s\n\nSYNOPSIS\n  %s::%s %s\n\n",
+	    dp->dc_name, dp->dc_descr, *usage == '?' ? "[ addr ] " :
+	    *usage == ':' ? "addr " : "", dp->dc_name,
+	    *usage == '?' || *usage == ':' ? usage + 1 : usage);
+
+	if (dp->dc_help != NULL) {
+		mdb_printf("DESCRIPTION\n");
+		mdb_inc_indent(2);
+		dp->dc_help();
+		mdb_dec_indent(2);
+		mdb_printf("\n");
+	}
+
+	return (DCMD_OK);
+}
+
+static const mdb_dcmd_t mdbv8_builtin_dcmds[] = {
+	{ "dcmds", NULL, "list available debugger commands",
+		mdbv8_dcmd_dcmds },
+	{ "help", "dcmd", "print help for a debugger command",
+		mdbv8_dcmd_help },
+	{ "walk", "?name", "walk data structure", mdbv8_dcmd_walk },
+	{ "walkers", NULL, "list available walkers", mdbv8_dcmd_walkers },
+	{ NULL }
+};
+
+/*
+ * Split "line" into pipeline stages and each stage into words.  Words may be
+ * quoted with single or double quotes.  This modifies "line" in place, and the
+ * resulting stages refer to it.
+ */
+static int
+mdbv8_parse(char *line, mdbv8_stage_t *stages, int *nstagesp)
+{
+	mdbv8_stage_t *msp;
+	char *p, *word, *addr, *q, quote;
+	int nstages = 0;
+
+	p = line;
+	for (;;) {
+		while (*p == ' ' || *p == '\t')
+			p++;
+
+		if (*p == '\0' || *p == '#')
+			break;
+
+		if (nstages == MDBV8_MAXSTAGES) {
+			mdb_warn("too many pipeline stages\n");
+			return (-1);
+		}
+
+		msp = &stages[nstages++];
+		bzero(msp, sizeof (*msp));
+
+		/*
+		 * Each stage starts with an optional address and "::".
+		 */
+		if ((q = strstr(p, "::")) == NULL) {
+			mdb_warn("syntax error: expected \"::dcmd\": %s\n", p);
+			return (-1);
+		}
+
+		*q = '\0';
+		for (addr = p; *addr == ' ' || *addr == '\t'; addr++)
+			continue;
+		for (word = q; word > addr &&
+		    (word[-1] == ' ' || word[-1] == '\t'); word--)
+			word[-1] = '\0';
+
+		if (*addr != '\0') {
+			msp->ms_addr = (uintptr_t)mdb_strtoull(addr);
+			msp->ms_flags = DCMD_ADDRSPEC;
+		}
+
+		p = q + 2;
+		msp->ms_dcmd = p;
+		while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '|')
+			p++;
+
+		while (*p != '\0' && *p != '|') {
+			if (*p == ' ' || *p == '\t') {
+				*p++ = '\0';
+				continue;
+			}
+
+			if (msp->ms_argc == MDBV8_MAXARGS) {
+				mdb_warn("too many arguments\n");
+				return (-1);
+			}
+
+			quote = (*p == '"' || *p == '\'') ? *p++ : '\0';
+			word = p;
+			if (quote != '\0') {
+				if ((q = strchr(p, quote)) == NULL) {
+					mdb_warn("unterminated quote\n");
+					return (-1);
+				}
+
+				*q = '\0';
+				p = q + 1;
+			} else {
+				while (*p != '\0' && *p != ' ' &&
+				    *p != '\t' && *p != '|')
+					p++;
+			}
+
+			msp->ms_argv[msp->ms_argc].a_type = MDB_TYPE_STRING;
+			msp->ms_argv[msp->ms_argc].a_un.a_str = word;
+			msp->ms_argc++;
+
+			if (quote == '\0' && *p == ' ')
+				*p++ = '\0';
+		}
+
+		if (*p == '|') {
+			*p++ = '\0';
+			if (*msp->ms_dcmd == '\0') {
+				mdb_warn("syntax error: missing dcmd name\n");
+				return (-1);
+			}
+			continue;
+		}
+
+		break;
+	}
+
+	if (nstages > 0 && *stages[nstages - 1].ms_dcmd == '\0') {
+		mdb_warn("syntax error: missing dcmd name\n");
+		return (-1);
+	}
+
+	*nstagesp = nstages;
+	return (0);
+}
+
+/*
+ * Parse the output of one stage of a pipeline into the addresses that are
+ * passed to the next stage.  As in mdb, the first word on each line is taken
+ * to be a hexadecimal value, and lines that don't begin with one are skipped.
+ */
+static uintptr_t *
+mdbv8_pipe_parse(char *text, size_t *npipep)
+{
+	uintptr_t *addrs;
+	size_t naddrs = 0, maxaddrs = 1;
+	char *line, *next, *end;
+	unsigned long long val;
+
+	for (line = text; *line != '\0'; line++) {
+		if (*line == '\n')
+			maxaddrs++;
+	}
+
+	addrs = mdb_alloc(maxaddrs * sizeof (addrs[0]), UM_SLEEP);
+	for (line = text; line != NULL && *line != '\0'; line = next) {
+		if ((next = strchr(line, '\n')) != NULL)
+			*next++ = '\0';
+
+		while (*line == ' ' || *line == '\t')
+			line++;
+
+		errno = 0;
+		val = strtoull(line, &end, 16);
+		if (end == line || errno != 0 ||
+		    (*end != '\0' && *end != ' ' && *end != '\t'))
+			continue;
+
+		addrs[naddrs++] = (uintptr_t)val;
+	}
+
+	*npipep = naddrs;
+	return (addrs);
+}
+
+/*
+ * Run one command line.  Returns 0 if all commands completed successfully.
+ */
+static int
+mdbv8_run(const char *cmdline)
+{
+	mdbv8_stage_t stages[MDBV8_MAXSTAGES], *msp;
+	uintptr_t *addrs = NULL;
+	size_t naddrs = 0, len;
+	char *line, *output;
+	int nstages, i, rv = DCMD_OK;
+
+	if ((line = strdup(cmdline)) == NULL) {
+		mdb_warn("failed to copy command");
+		return (-1);
+	}
+
+	if (mdbv8_parse(line, stages, &nstages) != 0) {
+		free(line);
+		return (-1);
+	}
+
+	if (nstages == 1 && (strcmp(stages[0].ms_dcmd, "quit") == 0 ||
+	    strcmp(stages[0].ms_dcmd, "q") == 0)) {
+		mdbv8_quit = B_TRUE;
+		free(line);
+		return (0);
+	}
+
+	for (i = 0; i < nstages; i++) {
+		msp = &stages[i];
+		if (i < nstages - 1)
+			mdbv8_output_push();
+
+		rv = mdbv8_call(msp->ms_dcmd, msp->ms_addr, msp->ms_flags,
+		    msp->ms_argc, msp->ms_argv, addrs, naddrs);
+
+		if (addrs != NULL)
+			mdb_free(addrs, 0);
+		addrs = NULL;
+
+		if (i < nstages - 1) {
+			output = mdbv8_output_pop(&len);
+			addrs = mdbv8_pipe_parse(output, &naddrs);
+			free(output);
+		}
+
+		if (rv != DCMD_OK)
+			break;
+	}
+
+	if (addrs != NULL)
+		mdb_free(addrs, 0);
+
+	(void) fflush(stdout);
+	mdbv8_gc();
+	free(line);
+	return (rv == DCMD_OK ? 0 : -1);
+}
+
+/*
+ * Analyze the core file "core" by running each of "cmds" against it.
+ * Returns the number of commands that failed, or -1 if the core file couldn't
+ * be opened.
+ */
+static int
+mdbv8_analyze(const char *core, const char *execpath, char **cmds,
+    int ncmds, boolean_t interactive)
+{
+	char *line = NULL;
+	size_t linesz = 0;
+	ssize_t len;
+	int i, nerrors = 0;
+
+	if (mdbv8_target_open(core, execpath) != 0)
+		return (-1);
+
+	mdbv8_builtins = mdbv8_builtin_dcmds;
+	mdbv8_modinfo = _mdb_init();
+	mdbv8_modapi_init(mdbv8_modinfo, mdbv8_builtins);
+	mdbv8_gc();
+
+	/*
+	 * Read heap memory directly from our mapping of the core file.
+	 */
+	(void) dbi_core_open(core);
+
+	for (i = 0; i < ncmds && !mdbv8_quit; i++) {
+		if (mdbv8_run(cmds[i]) != 0)
+			nerrors++;
+	}
+
+	while (interactive && !mdbv8_quit) {
+		(void) printf("> ");
+		(void) fflush(stdout);
+		if ((len = getline(&line, &linesz, stdin)) == -1)
+			break;
+
+		if (len > 0 && line[len - 1] == '\n')
+			line[len - 1] = '\0';
+
+		(void) mdbv8_run(line);
+	}
+
+	free(line);
+	(void) fflush(stdout);
+	dbi_core_close();
+	mdbv8_target_close();
+	return (nerrors);
+}
+
+static void
+usage(void)
+{
+	(void) fprintf(stderr, "usage: %s [-b binary] [-e command]... "
+	    "[-f cmdfile] [-j njobs]\n"
+	    "    [-o outdir] core...\n\n"
+	    "    -b binary   use \"binary\" as the program that dumped core\n"
+	    "    -e command  run \"command\" (may be repeated)\n"
+	    "    -f cmdfile  run the commands in \"cmdfile\"\n"
+	    "    -j njobs    analyze up to \"njobs\" core files at once\n"
+	    "    -o outdir   write the output for each core file to a file in "
+	    "\"outdir\"\n", mdbv8_progname);
+	exit(2);
+}
+
+/*
+ * Append each line of the file "fp" to the list of commands.
+ */
+static void
+mdbv8_read_commands(FILE *fp, char ***cmdsp, int *ncmdsp, int *maxcmdsp)
+{
+	char *line = NULL;
+	size_t linesz = 0;
+	ssize_t len;
+
+	while ((len = getline(&line, &linesz, fp)) != -1) {
+		if (len > 0 && line[len - 1] == '\n')
+			line[len - 1] = '\0';
+
+		if (*ncmdsp == *maxcmdsp) {
+			*maxcmdsp = MAX(*maxcmdsp * 2, 16);
+			*cmdsp = realloc(*cmdsp, *maxcmdsp * sizeof (char *));
+			if (*cmdsp == NULL) {
+				(void) fprintf(stderr, "%s: out of memory\n",
+				    mdbv8_progname);
+				exit(1);
+			}
+		}
+
+		(*cmdsp)[(*ncmdsp)++] = strdup(line);
+	}
+
+	free(line);
+}
+
+/*
+ * Open the output file for the "i"th core file in "outdir".  Output files are
+ * named after the core file, with a suffix to make them unique if necessary.
+ */
+static int
+mdbv8_open_output(const char *outdir, char **cores, int i)
+{
+	char path[PATH_MAX], namebuf[PATH_MAX], otherbuf[PATH_MAX];
+	const char *name;
+	int j, ndups = 0, fd;
+
+	(void) strlcpy(namebuf, cores[i], sizeof (namebuf));
+	name = basename(namebuf);
+	for (j = 0; j < i; j++) {
+		(void) strlcpy(otherbuf, cores[j], sizeof (otherbuf));
+		if (strcmp(basename(otherbuf), name) == 0)
+			ndups++;
+	}
+
+	if (ndups == 0) {
+		(void) snprintf(path, sizeof (path), "%s/%s.txt", outdir, name);
+	} else {
+		(void) snprintf(path, sizeof (path), "%s/%s.%d.txt", outdir,
+		    name, ndups);
+	}
+
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1) {
+		(void) fprintf(stderr, "%s: failed to open \"%s\": %s\n",
+		    mdbv8_progname, path, strerror(errno));
+	}
+
+	return (fd);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *execpath = NULL, *outdir = NULL;
+	char **cmds = NULL;
+	int ncmds = 0, maxcmds = 0, njobs = 1, nrunning = 0, nfailed = 0;
+	int c, i, fd, status;
+	boolean_t interactive = B_FALSE;
+	FILE *fp;
+	pid_t pid;
+
+	while ((c = getopt(argc, argv, "b:e:f:j:o:")) != -1) {
+		switch (c) {
+		case 'b':
+			execpath = optarg;
+			break;
+
+		case 'e':
+			if (ncmds == maxcmds) {
+				maxcmds = MAX(maxcmds * 2, 16);
+				cmds = realloc(cmds, maxcmds * sizeof (char *));
+				if (cmds == NULL) {
+					(void) fprintf(stderr,
+					    "%s: out of memory\n",
+					    mdbv8_progname);
+					return (1);
+				}
+			}
+
+			cmds[ncmds++] = optarg;
+			break;
+
+		case 'f':
+			if ((fp = fopen(optarg, "r")) == NULL) {
+				(void) fprintf(stderr, "%s: failed to open "
+				    "\"%s\": %s\n", mdbv8_progname, optarg,
+				    strerror(errno));
+				return (1);
+			}
+
+			mdbv8_read_commands(fp, &cmds, &ncmds, &maxcmds);
+			(void) fclose(fp);
+			break;
+
+		case 'j':
+			if ((njobs = atoi(optarg)) <= 0)
+				usage();
+			break;
+
+		case 'o':
+			outdir = optarg;
+			break;
+
+		default:
+			usage();
+		}
+	}
+
+	argc -= optind;
+	argv += optind;
+	if (argc == 0)
+		usage();
+
+	if (ncmds == 0) {
+		if (argc == 1 && outdir == NULL && isatty(STDIN_FILENO))
+			interactive = B_TRUE;
+		else
+			mdbv8_read_commands(stdin, &cmds, &ncmds, &maxcmds);
+	}
+
+	if (argc == 1 && outdir == NULL) {
+		return (mdbv8_analyze(argv[0], execpath, cmds, ncmds,
+		    interactive) == 0 ? 0 : 1);
+	}
+
+	/*
+	 * Without an output directory, the output for all core files goes to
+	 * stdout, so we process them one at a time.
+	 */
+	if (outdir == NULL)
+		njobs = 1;
+
+	for (i = 0; i < argc; i++) {
+		if (nrunning == njobs) {
+			if (wait(&status) != -1) {
+				nrunning--;
+				if (!WIFEXITED(status) ||
+				    WEXITSTATUS(status) != 0)
+					nfailed++;
+			}
+		}
+
+		fd = -1;
+		if (outdir != NULL &&
+		    (fd = mdbv8_open_output(outdir, argv, i)) == -1) {
+			nfailed++;
+			continue;
+		}
+
+		if (outdir == NULL)
+			(void) printf("==> %s <==\n", argv[i]);
+
+		(void) fflush(stdout);
+		(void) fflush(stderr);
+
+		if ((pid = fork()) == -1) {
+			(void) fprintf(stderr, "%s: fork: %s\n",
+			    mdbv8_progname, strerror(errno));
+			(void) close(fd);
+			nfailed++;
+			continue;
+		}
+
+		if (pid == 0) {
+			if (fd != -1) {
+				(void) dup2(fd, STDOUT_FILENO);
+				(void) dup2(fd, STDERR_FILENO);
+				(void) close(fd);
+			}
+
+			exit(mdbv8_analyze(argv[i], execpath, cmds, ncmds,
+			    B_FALSE) == 0 ? 0 : 1);
+		}
+
+		if (fd != -1)
+			(void) close(fd);
+		nrunning++;
+	}
+
+	while (nrunning > 0 && wait(&status) != -1) {
+		nrunning--;
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			nfailed++;
+	}
+
+	return (nfailed == 0 ? 0 : 1);
+}
@@ -0,0 +1,42 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2018, Joyent, Inc.
+ */
+
+/*
+ * mdbv8.h: interfaces shared by the pieces of the standalone "mdbv8" program.
+ */
+
+#ifndef	_MDBV8_H
+#define	_MDBV8_H
+
+#include <sys/mdb_modapi.h>
+#include <stdio.h>
+
+/*
+ * mdbv8_target.c: the target (an ELF core file, plus the objects that were
+ * mapped into the process that dumped it).
+ */
+int mdbv8_target_open(const char *, const char *);
+void mdbv8_target_close(void);
+const char *mdbv8_target_lookup_addr(uintptr_t, const char **, uintptr_t *);
+
+/*
+ * mdbv8_modapi.c: the rest of the module API, including output, allocation,
+ * option parsing, walkers, and dcmd invocation.
+ */
+void mdbv8_modapi_init(const mdb_modinfo_t *, const mdb_dcmd_t *);
+int mdbv8_call(const char *, uintptr_t, uint_t, int, const mdb_arg_t *,
+    uintptr_t *, size_t);
+void mdbv8_output_push(void);
+char *mdbv8_output_pop(size_t *);
+void mdbv8_gc(void);
+
+extern const char *mdbv8_progname;
+
+#endif	/* _MDBV8_H */
@@ -0,0 +1,996 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2018, Joyent, Inc.
+ */
+
+/*
+ * mdbv8_modapi.c: implementations of the parts of the MDB module API that
+ * don't depend on the target: formatted output, allocation, option parsing,
+ * walkers, and dcmd invocation.  These behave like their mdb counterparts in
+ * the ways that mdb_v8 depends on.  Notably:
+ *
+ *   o mdb_printf() and friends support mdb's "%a", "%A", "%p", "%Y", and "%?"
+ *     formats.  Formatting attributes like "%<b>" are ignored.
+ *
+ *   o Numbers are parsed as hexadecimal by default, as in mdb.
+ *
+ *   o Memory allocated with UM_GC is freed at the end of each command.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "mdbv8.h"
+
+const char *mdbv8_progname = "mdbv8";
+
+static const mdb_modinfo_t *mdbv8_modinfo;
+static const mdb_dcmd_t *mdbv8_builtins;
+
+/*
+ * Growable buffer used for formatting and for capturing output.
+ */
+typedef struct mdbv8_buf {
+	char		*mb_data;
+	size_t		mb_len;
+	size_t		mb_size;
+} mdbv8_buf_t;
+
+#define	MDBV8_MAXCAPTURE	8
+
+static mdbv8_buf_t mdbv8_capture[MDBV8_MAXCAPTURE];
+static int mdbv8_ncaptures;
+static ulong_t mdbv8_indent;
+static boolean_t mdbv8_midline;
+static uintptr_t mdbv8_dot;
+
+/*
+ * State of the current pipeline, for mdb_get_pipe().
+ */
+static uintptr_t *mdbv8_pipe_data;
+static size_t mdbv8_pipe_len;
+static boolean_t mdbv8_pipe_consumed;
+
+/*
+ * List of allocations made with UM_GC.
+ */
+typedef union mdbv8_gc {
+	union mdbv8_gc	*mg_next;
+	long double	mg_align;
+} mdbv8_gc_t;
+
+static mdbv8_gc_t *mdbv8_gclist;
+
+static void
+mdbv8_buf_append(mdbv8_buf_t *mbp, const char *str, size_t len)
+{
+	size_t newsize;
+	char *newdata;
+
+	if (mbp->mb_len + len + 1 > mbp->mb_size) {
+		newsize = MAX(mbp->mb_size * 2, mbp->mb_len + len + 1);
+		newsize = MAX(newsize, 256);
+		if ((newdata = realloc(mbp->mb_data, newsize)) == NULL) {
+			(void) fprintf(stderr, "%s: out of memory\n",
+			    mdbv8_progname);
+			abort();
+		}
+
+		mbp->mb_data = newdata;
+		mbp->mb_size = newsize;
+	}
+
+	bcopy(str, mbp->mb_data + mbp->mb_len, len);
+	mbp->mb_len += len;
+	mbp->mb_data[mbp->mb_len] = '\0';
+}
+
+static void
+mdbv8_buf_printf(mdbv8_buf_t *mbp, const char *fmt, ...)
+{
+	char sbuf[128];
+	char *buf = sbuf;
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(sbuf, sizeof (sbuf), fmt, ap);
+	va_end(ap);
+
+	if (len < 0)
+		return;
+
+	if (len >= sizeof (sbuf)) {
+		if ((buf = malloc(len + 1)) == NULL)
+			return;
+
+		va_start(ap, fmt);
+		(void) vsnprintf(buf, len + 1, fmt, ap);
+		va_end(ap);
+	}
+
+	mdbv8_buf_append(mbp, buf, len);
+	if (buf != sbuf)
+		free(buf);
+}
+
+/*
+ * Format the address "addr" symbolically.  If there's no symbol for it, "%a"
+ * prints the address itself, while "%A" prints only a "?".
+ */
+static void
+mdbv8_format_symbol(char *buf, size_t bufsz, uintptr_t addr, boolean_t bare)
+{
+	const char *name, *obj;
+	uintptr_t off;
+
+	if ((name = mdbv8_target_lookup_addr(addr, &obj, &off)) == NULL) {
+		if (bare)
+			(void) snprintf(buf, bufsz, "?");
+		else
+			(void) snprintf(buf, bufsz, "%lx", (ulong_t)addr);
+		return;
+	}
+
+	(void) snprintf(buf, bufsz, "%s%s%s", obj != NULL ? obj : "",
+	    obj != NULL ? "`" : "", name);
+	if (off != 0) {
+		size_t len = strlen(buf);
+		(void) snprintf(buf + len, bufsz - len, "+0x%lx", (ulong_t)off);
+	}
+}
+
+static void
+mdbv8_format(mdbv8_buf_t *mbp, const char *fmt, va_list ap)
+{
+	char spec[32], sym[512];
+	const char *p, *q;
+	size_t speclen;
+	int width, prec, nlong, nshort;
+	boolean_t haswidth, hasprec;
+	struct tm tm;
+	time_t t;
+
+	for (p = fmt; *p != '\0'; p++) {
+		if (*p != '%') {
+			for (q = p; *q != '\0' && *q != '%'; q++)
+				continue;
+			mdbv8_buf_append(mbp, p, q - p);
+			p = q - 1;
+			continue;
+		}
+
+		if (*++p == '\0')
+			break;
+
+		/*
+		 * Formatting attributes (bold, underline, and so on) have no
+		 * effect on our output.
+		 */
+		if (*p == '<') {
+			if ((q = strchr(p, '>')) == NULL)
+				break;
+			p = q;
+			continue;
+		}
+
+		if (*p == '%') {
+			mdbv8_buf_append(mbp, "%", 1);
+			continue;
+		}
+
+		spec[0] = '%';
+		speclen = 1;
+		while (*p != '\0' && strchr("-+ #0", *p) != NULL &&
+		    speclen < 8)
+			spec[speclen++] = *p++;
+
+		haswidth = hasprec = B_FALSE;
+		width = prec = 0;
+		if (*p == '?') {
+			haswidth = B_TRUE;
+			width = sizeof (uintptr_t) * 2;
+			p++;
+		} else if (*p == '*') {
+			haswidth = B_TRUE;
+			width = va_arg(ap, int);
+			p++;
+		} else if (*p >= '0' && *p <= '9') {
+			haswidth = B_TRUE;
+			while (*p >= '0' && *p <= '9')
+				width = width * 10 + (*p++ - '0');
+		}
+
+		if (*p == '.') {
+			hasprec = B_TRUE;
+			p++;
+			if (*p == '*') {
+				prec = va_arg(ap, int);
+				p++;
+			} else {
+				while (*p >= '0' && *p <= '9')
+					prec = prec * 10 + (*p++ - '0');
+			}
+		}
+
+		nlong = nshort = 0;
+		for (; *p == 'l' || *p == 'h'; p++) {
+			if (*p == 'l')
+				nlong++;
+			else
+				nshort++;
+		}
+
+		if (*p == '\0')
+			break;
+
+		if (haswidth)
+			speclen += snprintf(spec + speclen,
+			    sizeof (spec) - speclen, "%d", width);
+		if (hasprec)
+			speclen += snprintf(spec + speclen,
+			    sizeof (spec) - speclen, ".%d", prec);
+
+		switch (*p) {
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+		case 'c':
+			if (nlong >= 2) {
+				spec[speclen++] = 'l';
+				spec[speclen++] = 'l';
+			} else if (nlong == 1) {
+				spec[speclen++] = 'l';
+			}
+			spec[speclen++] = *p;
+			spec[speclen] = '\0';
+
+			if (*p == 'c') {
+				mdbv8_buf_printf(mbp, spec, va_arg(ap, int));
+			} else if (nlong >= 2) {
+				mdbv8_buf_printf(mbp, spec,
+				    va_arg(ap, long long));
+			} else if (nlong == 1) {
+				mdbv8_buf_printf(mbp, spec, va_arg(ap, long));
+			} else if (nshort != 0 && (*p == 'd' || *p == 'i')) {
+				mdbv8_buf_printf(mbp, spec,
+				    nshort == 1 ? (short)va_arg(ap, int) :
+				    (signed char)va_arg(ap, int));
+			} else if (nshort != 0) {
+				mdbv8_buf_printf(mbp, spec,
+				    nshort == 1 ? (ushort_t)va_arg(ap, int) :
+				    (uchar_t)va_arg(ap, int));
+			} else {
+				mdbv8_buf_printf(mbp, spec, va_arg(ap, int));
+			}
+			break;
+
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'g':
+		case 'G':
+			spec[speclen++] = *p;
+			spec[speclen] = '\0';
+			mdbv8_buf_printf(mbp, spec, va_arg(ap, double));
+			break;
+
+		case 'p':
+			(void) strcpy(spec + speclen, "lx");
+			mdbv8_buf_printf(mbp, spec,
+			    (ulong_t)va_arg(ap, uintptr_t));
+			break;
+
+		case 'a':
+		case 'A':
+			mdbv8_format_symbol(sym, sizeof (sym),
+			    va_arg(ap, uintptr_t), *p == 'A');
+			(void) strcpy(spec + speclen, "s");
+			mdbv8_buf_printf(mbp, spec, sym);
+			break;
+
+		case 'Y':
+			t = va_arg(ap, time_t);
+			if (localtime_r(&t, &tm) == NULL ||
+			    strftime(sym, sizeof (sym), "%Y %b %e %H:%M:%S",
+			    &tm) == 0)
+				(void) snprintf(sym, sizeof (sym), "?");
+			(void) strcpy(spec + speclen, "s");
+			mdbv8_buf_printf(mbp, spec, sym);
+			break;
+
+		case 's':
+			(void) strcpy(spec + speclen, "s");
+			q = va_arg(ap, const char *);
+			mdbv8_buf_printf(mbp, spec, q != NULL ? q : "<NULL>");
+			break;
+
+		default:
+			/*
+			 * Unsupported formats are emitted literally.
+			 */
+			mdbv8_buf_append(mbp, "%", 1);
+			mdbv8_buf_append(mbp, p, 1);
+			break;
+		}
+	}
+}
+
+size_t
+mdb_vsnprintf(char *buf, size_t nbytes, const char *fmt, va_list ap)
+{
+	mdbv8_buf_t mb;
+	size_t len;
+
+	bzero(&mb, sizeof (mb));
+	mdbv8_format(&mb, fmt, ap);
+	len = mb.mb_len;
+
+	if (nbytes != 0) {
+		size_t n = MIN(len, nbytes - 1);
+		if (n != 0)
+			bcopy(mb.mb_data, buf, n);
+		buf[n] = '\0';
+	}
+
+	free(mb.mb_data);
+	return (len);
+}
+
+size_t
+mdb_snprintf(char *buf, size_t nbytes, const char *fmt, ...)
+{
+	va_list ap;
+	size_t rv;
+
+	va_start(ap, fmt);
+	rv = mdb_vsnprintf(buf, nbytes, fmt, ap);
+	va_end(ap);
+	return (rv);
+}
+
+/*
+ * Emit formatted output, applying the current indentation to the start of
+ * each line.  Output goes to stdout unless it's being captured for a pipeline.
+ */
+static void
+mdbv8_output(const char *str, size_t len)
+{
+	static const char spaces[] = "                                ";
+	mdbv8_buf_t *mbp = mdbv8_ncaptures > 0 ?
+	    &mdbv8_capture[mdbv8_ncaptures - 1] : NULL;
+	const char *end = str + len, *eol;
+	size_t n;
+
+	while (str < end) {
+		if (!mdbv8_midline && *str != '\n') {
+			for (n = mdbv8_indent; n > 0; ) {
+				size_t nspaces = MIN(n, sizeof (spaces) - 1);
+				if (mbp != NULL)
+					mdbv8_buf_append(mbp, spaces, nspaces);
+				else
+					(void) fwrite(spaces, 1, nspaces,
+					    stdout);
+				n -= nspaces;
+			}
+		}
+
+		if ((eol = memchr(str, '\n', end - str)) != NULL) {
+			n = eol - str + 1;
+			mdbv8_midline = B_FALSE;
+		} else {
+			n = end - str;
+			mdbv8_midline = B_TRUE;
+		}
+
+		if (mbp != NULL)
+			mdbv8_buf_append(mbp, str, n);
+		else
+			(void) fwrite(str, 1, n, stdout);
+		str += n;
+	}
+}
+
+int
+mdb_printf(const char *fmt, ...)
+{
+	mdbv8_buf_t mb;
+	va_list ap;
+	int len;
+
+	bzero(&mb, sizeof (mb));
+	va_start(ap, fmt);
+	mdbv8_format(&mb, fmt, ap);
+	va_end(ap);
+
+	len = (int)mb.mb_len;
+	mdbv8_output(mb.mb_data, mb.mb_len);
+	free(mb.mb_data);
+	return (len);
+}
+
+/*
+ * Like mdb, if the message doesn't end with a newline, append a description
+ * of the current value of errno.
+ */
+void
+mdb_warn(const char *fmt, ...)
+{
+	int err = errno;
+	mdbv8_buf_t mb;
+	va_list ap;
+
+	bzero(&mb, sizeof (mb));
+	mdbv8_buf_printf(&mb, "%s: ", mdbv8_progname);
+	va_start(ap, fmt);
+	mdbv8_format(&mb, fmt, ap);
+	va_end(ap);
+
+	if (mb.mb_len == 0 || mb.mb_data[mb.mb_len - 1] != '\n')
+		mdbv8_buf_printf(&mb, ": %s\n", strerror(err));
+
+	(void) fflush(stdout);
+	(void) fwrite(mb.mb_data, 1, mb.mb_len, stderr);
+	free(mb.mb_data);
+}
+
+void
+mdb_inc_indent(ulong_t n)
+{
+	mdbv8_indent += n;
+}
+
+void
+mdb_dec_indent(ulong_t n)
+{
+	mdbv8_indent = n > mdbv8_indent ? 0 : mdbv8_indent - n;
+}
+
+/*
+ * Start capturing output, as for the left-hand side of a pipeline.
+ */
+void
+mdbv8_output_push(void)
+{
+	if (mdbv8_ncaptures == MDBV8_MAXCAPTURE) {
+		(void) fprintf(stderr, "%s: pipeline too deep\n",
+		    mdbv8_progname);
+		abort();
+	}
+
+	bzero(&mdbv8_capture[mdbv8_ncaptures], sizeof (mdbv8_buf_t));
+	mdbv8_ncaptures++;
+	mdbv8_midline = B_FALSE;
+}
+
+/*
+ * Stop capturing output and return what was captured.  The caller must free
+ * the result with free(3C).
+ */
+char *
+mdbv8_output_pop(size_t *lenp)
+{
+	mdbv8_buf_t *mbp = &mdbv8_capture[--mdbv8_ncaptures];
+
+	mdbv8_midline = B_FALSE;
+	if (mbp->mb_data == NULL)
+		mdbv8_buf_append(mbp, "", 0);
+
+	*lenp = mbp->mb_len;
+	return (mbp->mb_data);
+}
+
+void *
+mdb_alloc(size_t size, uint_t flags)
+{
+	mdbv8_gc_t *gcp;
+	void *buf;
+
+	if ((flags & UM_GC) != 0) {
+		if ((gcp = malloc(sizeof (*gcp) + size)) != NULL) {
+			gcp->mg_next = mdbv8_gclist;
+			mdbv8_gclist = gcp;
+			buf = gcp + 1;
+		} else {
+			buf = NULL;
+		}
+	} else {
+		buf = malloc(size != 0 ? size : 1);
+	}
+
+	if (buf == NULL && (flags & UM_SLEEP) != 0) {
+		(void) fprintf(stderr, "%s: failed to allocate %lu bytes\n",
+		    mdbv8_progname, (ulong_t)size);
+		abort();
+	}
+
+	return (buf);
+}
+
+void *
+mdb_zalloc(size_t size, uint_t flags)
+{
+	void *buf;
+
+	if ((buf = mdb_alloc(size, flags)) != NULL)
+		bzero(buf, size);
+
+	return (buf);
+}
+
+/* ARGSUSED */
+void
+mdb_free(void *buf, size_t size)
+{
+	free(buf);
+}
+
+/*
+ * Free all memory allocated with UM_GC.  This is called at the end of each
+ * command.
+ */
+void
+mdbv8_gc(void)
+{
+	mdbv8_gc_t *gcp, *next;
+
+	for (gcp = mdbv8_gclist; gcp != NULL; gcp = next) {
+		next = gcp->mg_next;
+		free(gcp);
+	}
+
+	mdbv8_gclist = NULL;
+}
+
+/*
+ * Parse a number using mdb's rules: the default radix is 16, and prefixes
+ * "0x", "0t", "0o", and "0i" select hexadecimal, decimal, octal, and binary.
+ */
+u_longlong_t
+mdb_strtoull(const char *str)
+{
+	u_longlong_t rv = 0;
+	const char *p = str;
+	int radix = 16, digit;
+
+	if (p[0] == '0' && p[1] != '\0') {
+		switch (p[1]) {
+		case 'x':
+		case 'X':
+			radix = 16;
+			p += 2;
+			break;
+		case 't':
+		case 'T':
+			radix = 10;
+			p += 2;
+			break;
+		case 'o':
+		case 'O':
+			radix = 8;
+			p += 2;
+			break;
+		case 'i':
+		case 'I':
+			radix = 2;
+			p += 2;
+			break;
+		default:
+			break;
+		}
+	}
+
+	for (; *p != '\0'; p++) {
+		if (*p >= '0' && *p <= '9')
+			digit = *p - '0';
+		else if (*p >= 'a' && *p <= 'f')
+			digit = *p - 'a' + 10;
+		else if (*p >= 'A' && *p <= 'F')
+			digit = *p - 'A' + 10;
+		else
+			digit = radix;
+
+		if (digit >= radix) {
+			mdb_warn("failed to parse \"%s\" as a number\n", str);
+			return (0);
+		}
+
+		rv = rv * radix + digit;
+	}
+
+	return (rv);
+}
+
+/*
+ * Option descriptor, as decoded from the arguments to mdb_getopts().
+ */
+typedef struct mdbv8_opt {
+	int		mo_char;
+	uint_t		mo_type;
+	uint_t		mo_bits;
+	void		*mo_ptr;
+	boolean_t	*mo_setp;
+} mdbv8_opt_t;
+
+#define	MDBV8_MAXOPTS	52
+
+int
+mdb_getopts(int argc, const mdb_arg_t *argv, ...)
+{
+	mdbv8_opt_t opts[MDBV8_MAXOPTS], *op;
+	const char *p, *optarg;
+	u_longlong_t val;
+	int nopts = 0, c, i, j;
+	va_list ap;
+
+	va_start(ap, argv);
+	while ((c = va_arg(ap, int)) != 0 && nopts < MDBV8_MAXOPTS) {
+		op = &opts[nopts++];
+		op->mo_char = c;
+		op->mo_type = va_arg(ap, uint_t);
+		op->mo_setp = NULL;
+		op->mo_bits = 0;
+
+		switch (op->mo_type) {
+		case MDB_OPT_SETBITS:
+		case MDB_OPT_CLRBITS:
+			op->mo_bits = va_arg(ap, uint_t);
+			op->mo_ptr = va_arg(ap, void *);
+			break;
+		case MDB_OPT_UINTPTR_SET:
+			op->mo_setp = va_arg(ap, boolean_t *);
+			op->mo_ptr = va_arg(ap, void *);
+			break;
+		default:
+			op->mo_ptr = va_arg(ap, void *);
+			break;
+		}
+	}
+	va_end(ap);
+
+	for (i = 0; i < argc; i++) {
+		if (argv[i].a_type != MDB_TYPE_STRING ||
+		    argv[i].a_un.a_str[0] != '-' ||
+		    argv[i].a_un.a_str[1] == '\0')
+			break;
+
+		if (strcmp(argv[i].a_un.a_str, "--") == 0)
+			return (i + 1);
+
+		for (p = argv[i].a_un.a_str + 1; *p != '\0'; p++) {
+			for (j = 0; j < nopts; j++) {
+				if (opts[j].mo_char == *p)
+					break;
+			}
+
+			if (j == nopts) {
+				mdb_warn("illegal option -- %c\n", *p);
+				return (i);
+			}
+
+			op = &opts[j];
+			if (op->mo_type == MDB_OPT_SETBITS) {
+				*(uint_t *)op->mo_ptr |= op->mo_bits;
+				continue;
+			}
+
+			if (op->mo_type == MDB_OPT_CLRBITS) {
+				*(uint_t *)op->mo_ptr &= ~op->mo_bits;
+				continue;
+			}
+
+			/*
+			 * The remaining option types take an argument, which
+			 * is either the rest of this word or the next one.
+			 */
+			optarg = NULL;
+			val = 0;
+			if (p[1] != '\0') {
+				optarg = p + 1;
+			} else if (i + 1 < argc) {
+				i++;
+				if (argv[i].a_type == MDB_TYPE_STRING)
+					optarg = argv[i].a_un.a_str;
+				else
+					val = argv[i].a_un.a_val;
+			} else {
+				mdb_warn("option requires an argument -- %c\n",
+				    *p);
+				return (i);
+			}
+
+			if (op->mo_type == MDB_OPT_STR) {
+				if (optarg == NULL) {
+					mdb_warn("option requires a string "
+					    "argument -- %c\n", *p);
+					return (i);
+				}
+
+				*(const char **)op->mo_ptr = optarg;
+				break;
+			}
+
+			if (optarg != NULL)
+				val = mdb_strtoull(optarg);
+
+			if (op->mo_type == MDB_OPT_UINT64) {
+				*(uint64_t *)op->mo_ptr = val;
+			} else {
+				*(uintptr_t *)op->mo_ptr = (uintptr_t)val;
+				if (op->mo_setp != NULL)
+					*op->mo_setp = B_TRUE;
+			}
+			break;
+		}
+	}
+
+	return (i);
+}
+
+uintptr_t
+mdb_get_dot(void)
+{
+	return (mdbv8_dot);
+}
+
+void
+mdb_set_dot(uintptr_t addr)
+{
+	mdbv8_dot = addr;
+}
+
+/*
+ * We don't implement the mdb language.  mdb_v8 only uses mdb_eval() for
+ * optional features (like enabling C++ demangling and disassembling code), so
+ * those features are unavailable.
+ */
+/* ARGSUSED */
+int
+mdb_eval(const char *cmd)
+{
+	errno = ENOTSUP;
+	return (-1);
+}
+
+void
+mdb_get_pipe(mdb_pipe_t *pipep)
+{
+	if (mdbv8_pipe_data == NULL || mdbv8_pipe_consumed) {
+		pipep->pipe_data = NULL;
+		pipep->pipe_len = 0;
+		return;
+	}
+
+	pipep->pipe_data = mdbv8_pipe_data;
+	pipep->pipe_len = mdbv8_pipe_len;
+	mdbv8_pipe_consumed = B_TRUE;
+}
+
+static const mdb_walker_t *
+mdbv8_walker_lookup(const char *name)
+{
+	const mdb_walker_t *wp;
+
+	for (wp = mdbv8_modinfo->mi_walkers; wp->walk_name != NULL; wp++) {
+		if (strcmp(wp->walk_name, name) == 0)
+			return (wp);
+	}
+
+	return (NULL);
+}
+
+static const mdb_dcmd_t *
+mdbv8_dcmd_lookup(const char *name)
+{
+	const mdb_dcmd_t *dp;
+
+	for (dp = mdbv8_builtins; dp->dc_name != NULL; dp++) {
+		if (strcmp(dp->dc_name, name) == 0)
+			return (dp);
+	}
+
+	for (dp = mdbv8_modinfo->mi_dcmds; dp->dc_name != NULL; dp++) {
+		if (strcmp(dp->dc_name, name) == 0)
+			return (dp);
+	}
+
+	return (NULL);
+}
+
+void
+mdbv8_modapi_init(const mdb_modinfo_t *modinfo, const mdb_dcmd_t *builtins)
+{
+	mdbv8_modinfo = modinfo;
+	mdbv8_builtins = builtins;
+}
+
+int
+mdb_pwalk(const char *name, mdb_walk_cb_t *func, void *arg, uintptr_t addr)
+{
+	const mdb_walker_t *wp;
+	mdb_walk_state_t ws;
+	int status;
+
+	if ((wp = mdbv8_walker_lookup(name)) == NULL) {
+		mdb_warn("\"%s\" is not a walker\n", name);
+		return (-1);
+	}
+
+	bzero(&ws, sizeof (ws));
+	ws.walk_callback = func;
+	ws.walk_cbdata = arg;
+	ws.walk_addr = addr;
+	ws.walk_arg = wp->walk_init_arg;
+
+	if (wp->walk_init(&ws) != WALK_NEXT)
+		return (-1);
+
+	while ((status = wp->walk_step(&ws)) == WALK_NEXT)
+		continue;
+
+	if (wp->walk_fini != NULL)
+		wp->walk_fini(&ws);
+
+	return (status == WALK_ERR ? -1 : 0);
+}
+
+int
+mdb_walk(const char *name, mdb_walk_cb_t *func, void *arg)
+{
+	return (mdb_pwalk(name, func, arg, 0));
+}
+
+/*
+ * Print a usage message for the dcmd "dp".  As in mdb, a leading "?" in the
+ * usage string means that an address is optional, and ":" means that one is
+ * required.
+ */
+static void
+mdbv8_usage(const mdb_dcmd_t *dp)
+{
+	const char *usage = dp->dc_usage != NULL ? dp->dc_usage : "";
+	const char *addr = "";
+
+	if (*usage == '?') {
+		addr = "[addr]";
+		usage++;
+	} else if (*usage == ':') {
+		addr = "addr";
+		usage++;
+	}
+
+	(void) fflush(stdout);
+	(void) fprintf(stderr, "Usage: %s::%s %s\n", addr, dp->dc_name, usage);
+}
+
+typedef struct mdbv8_walk_dcmd {
+	const mdb_dcmd_t	*mwd_dcmd;
+	int			mwd_argc;
+	const mdb_arg_t		*mwd_argv;
+	uint_t			mwd_flags;
+} mdbv8_walk_dcmd_t;
+
+/* ARGSUSED */
+static int
+mdbv8_walk_dcmd_cb(uintptr_t addr, const void *data, void *arg)
+{
+	mdbv8_walk_dcmd_t *mwdp = arg;
+	int rv;
+
+	rv = mwdp->mwd_dcmd->dc_funcp(addr, mwdp->mwd_flags, mwdp->mwd_argc,
+	    mwdp->mwd_argv);
+	mwdp->mwd_flags &= ~DCMD_LOOPFIRST;
+
+	if (rv == DCMD_USAGE)
+		mdbv8_usage(mwdp->mwd_dcmd);
+
+	return (rv == DCMD_OK || rv == DCMD_ERR ? WALK_NEXT : WALK_ERR);
+}
+
+int
+mdb_pwalk_dcmd(const char *wname, const char *dcname, int argc,
+    const mdb_arg_t *argv, uintptr_t addr)
+{
+	mdbv8_walk_dcmd_t mwd;
+
+	if ((mwd.mwd_dcmd = mdbv8_dcmd_lookup(dcname)) == NULL) {
+		mdb_warn("\"%s\" is not a dcmd\n", dcname);
+		return (-1);
+	}
+
+	mwd.mwd_argc = argc;
+	mwd.mwd_argv = argv;
+	mwd.mwd_flags = DCMD_ADDRSPEC | DCMD_LOOP | DCMD_LOOPFIRST;
+	return (mdb_pwalk(wname, mdbv8_walk_dcmd_cb, &mwd, addr));
+}
+
+int
+mdb_call_dcmd(const char *name, uintptr_t addr, uint_t flags, int argc,
+    const mdb_arg_t *argv)
+{
+	return (mdbv8_call(name, addr, flags, argc, argv, NULL, 0));
+}
+
+/*
+ * Invoke the dcmd "name".  If "addrs" is non-NULL, the dcmd is the right-hand
+ * side of a pipeline, and it's invoked once for each of the "naddrs" addresses
+ * in "addrs" (unless it consumes them all at once with mdb_get_pipe()).
+ */
+int
+mdbv8_call(const char *name, uintptr_t addr, uint_t flags, int argc,
+    const mdb_arg_t *argv, uintptr_t *addrs, size_t naddrs)
+{
+	const mdb_dcmd_t *dp;
+	size_t i;
+	int rv = DCMD_OK, status;
+
+	if ((dp = mdbv8_dcmd_lookup(name)) == NULL) {
+		mdb_warn("\"%s\" is not a dcmd\n", name);
+		return (DCMD_ERR);
+	}
+
+	if (addrs == NULL) {
+		mdb_set_dot(addr);
+		rv = dp->dc_funcp(addr, flags, argc, argv);
+		if (rv == DCMD_USAGE)
+			mdbv8_usage(dp);
+		return (rv);
+	}
+
+	mdbv8_pipe_consumed = B_FALSE;
+	for (i = 0; i < naddrs && !mdbv8_pipe_consumed; i++) {
+		mdbv8_pipe_data = &addrs[i];
+		mdbv8_pipe_len = naddrs - i;
+		mdb_set_dot(addrs[i]);
+
+		status = dp->dc_funcp(addrs[i], DCMD_ADDRSPEC | DCMD_LOOP |
+		    DCMD_PIPE | (i == 0 ? DCMD_LOOPFIRST : 0), argc, argv);
+		if (status == DCMD_USAGE) {
+			mdbv8_usage(dp);
+			rv = status;
+			break;
+		}
+
+		if (status != DCMD_OK)
+			rv = status;
+
+		if (status == DCMD_ABORT)
+			break;
+	}
+
+	mdbv8_pipe_data = NULL;
+	mdbv8_pipe_len = 0;
+	return (rv);
+}
+
+hrtime_t
+gethrtime(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((hrtime_t)ts.tv_sec * NANOSEC + ts.tv_nsec);
+}
+
+size_t
+mdbv8_strlcpy(char *dst, const char *src, size_t len)
+{
+	size_t srclen = strlen(src);
+
+	if (len != 0) {
+		size_t n = MIN(srclen, len - 1);
+		bcopy(src, dst, n);
+		dst[n] = '\0';
+	}
+
+	return (srclen);
+}
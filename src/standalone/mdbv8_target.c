@@ -0,0 +1,1038 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2018, Joyent, Inc.
+ */
+
+/*
+ * mdbv8_target.c: the standalone program's target, which is an ELF core file
+ * generated by a Linux kernel (or a tool like gcore(1)) for a Node.js process.
+ * This file implements the parts of the module API that read memory, look up
+ * symbols, iterate mappings, and fetch registers.
+ *
+ * Linux core files contain a PT_LOAD program header for each mapping in the
+ * process, but by default the contents of file-backed mappings that the
+ * process never wrote to (like the text of the "node" binary) are omitted.
+ * The core file's NT_FILE note tells us which files were mapped where, so we
+ * map those files ourselves, both to fill in the missing memory contents and
+ * to load their symbol tables.  The NT_PRSTATUS note contains the registers of
+ * each thread, and NT_AUXV tells us the entry point of the executable.
+ *
+ * We only support targets with the same ELF class and byte order as this
+ * program, and registers are only available for x86.
+ */
+
+#include <sys/mman.h>
+#include <sys/procfs.h>
+#include <sys/reg.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libproc.h>
+#include <unistd.h>
+
+#include "mdbv8.h"
+
+#ifdef	_LP64
+#define	ELFCLASS	ELFCLASS64
+typedef Elf64_Ehdr	Elf_Ehdr;
+typedef Elf64_Phdr	Elf_Phdr;
+typedef Elf64_Shdr	Elf_Shdr;
+typedef Elf64_Nhdr	Elf_Nhdr;
+typedef Elf64_auxv_t	Elf_auxv_t;
+#define	ELF_ST_BIND	ELF64_ST_BIND
+#define	ELF_ST_TYPE	ELF64_ST_TYPE
+#else
+#define	ELFCLASS	ELFCLASS32
+typedef Elf32_Ehdr	Elf_Ehdr;
+typedef Elf32_Phdr	Elf_Phdr;
+typedef Elf32_Shdr	Elf_Shdr;
+typedef Elf32_Nhdr	Elf_Nhdr;
+typedef Elf32_auxv_t	Elf_auxv_t;
+#define	ELF_ST_BIND	ELF32_ST_BIND
+#define	ELF_ST_TYPE	ELF32_ST_TYPE
+#endif
+
+/*
+ * A file that was mapped into the target process.
+ */
+typedef struct mdbv8_object {
+	char		*mo_path;	/* path recorded in the core file */
+	const char	*mo_name;	/* last component of "mo_path" */
+	const uint8_t	*mo_base;	/* our mapping of the file (or NULL) */
+	size_t		mo_size;	/* size of the file */
+	uintptr_t	mo_bias;	/* load bias of an ELF object */
+	boolean_t	mo_exec;	/* object is the primary executable */
+} mdbv8_object_t;
+
+/*
+ * A range of the target's address space whose contents we have.  The
+ * contents come either from the core file or from a mapped object.
+ */
+typedef struct mdbv8_region {
+	uintptr_t	mr_vaddr;	/* start of region in target */
+	size_t		mr_size;	/* size of region */
+	const uint8_t	*mr_data;	/* contents of region */
+} mdbv8_region_t;
+
+/*
+ * A mapping in the target process, as described by the core file's PT_LOAD
+ * program headers.
+ */
+typedef struct mdbv8_mapping {
+	uintptr_t	mm_vaddr;	/* start of mapping */
+	size_t		mm_size;	/* size of mapping */
+	int		mm_mflags;	/* MA_* flags */
+	off_t		mm_offset;	/* offset into object */
+	mdbv8_object_t	*mm_object;	/* mapped object (NULL if anonymous) */
+} mdbv8_mapping_t;
+
+typedef struct mdbv8_sym {
+	const char	*ms_name;	/* symbol name */
+	GElf_Sym	ms_sym;		/* symbol (with relocated value) */
+	mdbv8_object_t	*ms_object;	/* containing object */
+	uint_t		ms_table;	/* MDB_SYMTAB or MDB_DYNSYM */
+} mdbv8_sym_t;
+
+typedef struct mdbv8_target {
+	const uint8_t	*t_base;	/* our mapping of the core file */
+	size_t		t_size;		/* size of core file */
+	mdbv8_mapping_t	*t_maps;	/* process mappings */
+	size_t		t_nmaps;
+	mdbv8_region_t	*t_coreregions;	/* regions in core file, by address */
+	size_t		t_ncoreregions;
+	mdbv8_region_t	*t_objregions;	/* regions in objects, by address */
+	size_t		t_nobjregions;
+	mdbv8_object_t	*t_objects;	/* mapped objects */
+	size_t		t_nobjects;
+	mdbv8_sym_t	*t_syms;	/* symbols of all objects */
+	size_t		t_nsyms;
+	size_t		t_maxsyms;
+	mdbv8_sym_t	**t_byname;	/* symbols, sorted by name */
+	mdbv8_sym_t	**t_byaddr;	/* data and text symbols, by address */
+	size_t		t_naddrsyms;
+	uintptr_t	t_entry;	/* entry point of executable */
+	boolean_t	t_hasregs;	/* "t_regs" is valid */
+	elf_gregset_t	t_regs;		/* registers of the first thread */
+} mdbv8_target_t;
+
+static mdbv8_target_t mdbv8_target;
+
+static int
+mdbv8_cmp_regions(const void *l, const void *r)
+{
+	const mdbv8_region_t *lhs = l;
+	const mdbv8_region_t *rhs = r;
+
+	if (lhs->mr_vaddr < rhs->mr_vaddr)
+		return (-1);
+
+	return (lhs->mr_vaddr > rhs->mr_vaddr ? 1 : 0);
+}
+
+static int
+mdbv8_cmp_byname(const void *l, const void *r)
+{
+	const mdbv8_sym_t *lhs = *(const mdbv8_sym_t **)l;
+	const mdbv8_sym_t *rhs = *(const mdbv8_sym_t **)r;
+	int rv;
+
+	if ((rv = strcmp(lhs->ms_name, rhs->ms_name)) != 0)
+		return (rv);
+
+	/*
+	 * Prefer symbols from the executable, and dynamic symbols after that,
+	 * since that's what mdb would find first.
+	 */
+	if (lhs->ms_object->mo_exec != rhs->ms_object->mo_exec)
+		return (lhs->ms_object->mo_exec ? -1 : 1);
+
+	if (lhs->ms_table != rhs->ms_table)
+		return (lhs->ms_table == MDB_DYNSYM ? -1 : 1);
+
+	return (lhs < rhs ? -1 : lhs > rhs ? 1 : 0);
+}
+
+static int
+mdbv8_cmp_byaddr(const void *l, const void *r)
+{
+	const mdbv8_sym_t *lhs = *(const mdbv8_sym_t **)l;
+	const mdbv8_sym_t *rhs = *(const mdbv8_sym_t **)r;
+	int lbind, rbind;
+
+	if (lhs->ms_sym.st_value != rhs->ms_sym.st_value)
+		return (lhs->ms_sym.st_value < rhs->ms_sym.st_value ? -1 : 1);
+
+	/*
+	 * Among symbols at the same address, prefer global ones.
+	 */
+	lbind = ELF_ST_BIND(lhs->ms_sym.st_info);
+	rbind = ELF_ST_BIND(rhs->ms_sym.st_info);
+	if (lbind != rbind)
+		return (lbind == STB_GLOBAL ? -1 : 1);
+
+	return (lhs < rhs ? -1 : lhs > rhs ? 1 : 0);
+}
+
+/*
+ * Returns a pointer to the ELF header of the mapped file "base" if it's an
+ * ELF file of our class, or NULL otherwise.
+ */
+static const Elf_Ehdr *
+mdbv8_elf_header(const uint8_t *base, size_t size, int type)
+{
+	const Elf_Ehdr *ehdr = (const Elf_Ehdr *)base;
+
+	if (size < sizeof (*ehdr) || bcmp(base, ELFMAG, SELFMAG) != 0 ||
+	    base[EI_CLASS] != ELFCLASS || (type != ET_NONE &&
+	    ehdr->e_type != type))
+		return (NULL);
+
+	if (ehdr->e_phoff > size || ehdr->e_phentsize < sizeof (Elf_Phdr) ||
+	    (size_t)ehdr->e_phnum * ehdr->e_phentsize > size - ehdr->e_phoff)
+		return (NULL);
+
+	return (ehdr);
+}
+
+static const uint8_t *
+mdbv8_map_file(const char *path, size_t *sizep)
+{
+	struct stat st;
+	void *base;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) == -1)
+		return (NULL);
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		(void) close(fd);
+		return (NULL);
+	}
+
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	(void) close(fd);
+	if (base == MAP_FAILED)
+		return (NULL);
+
+	*sizep = st.st_size;
+	return (base);
+}
+
+static mdbv8_object_t *
+mdbv8_object_lookup(mdbv8_target_t *tp, const char *path)
+{
+	mdbv8_object_t *mop;
+	const char *p;
+	size_t i;
+
+	for (i = 0; i < tp->t_nobjects; i++) {
+		if (strcmp(tp->t_objects[i].mo_path, path) == 0)
+			return (&tp->t_objects[i]);
+	}
+
+	mop = &tp->t_objects[tp->t_nobjects++];
+	mop->mo_path = strdup(path);
+	if (mop->mo_path == NULL) {
+		tp->t_nobjects--;
+		return (NULL);
+	}
+
+	mop->mo_name = (p = strrchr(mop->mo_path, '/')) != NULL ?
+	    p + 1 : mop->mo_path;
+	return (mop);
+}
+
+/*
+ * Process the NT_FILE note, which lists the file-backed mappings in the
+ * process: the number of entries and the page size, followed by the start,
+ * end, and file offset (in pages) of each entry, followed by the path of each
+ * entry.
+ */
+static int
+mdbv8_note_file(mdbv8_target_t *tp, const uint8_t *desc, size_t descsz)
+{
+	const uintptr_t *words = (const uintptr_t *)desc;
+	const char *path, *end;
+	uintptr_t count, pagesize, start, vend, pgoff;
+	mdbv8_object_t *mop;
+	size_t i, j;
+
+	if (descsz < 2 * sizeof (uintptr_t))
+		return (-1);
+
+	count = words[0];
+	pagesize = words[1];
+	if (count > (descsz / sizeof (uintptr_t) - 2) / 3)
+		return (-1);
+
+	tp->t_objects = calloc(count, sizeof (tp->t_objects[0]));
+	if (count != 0 && tp->t_objects == NULL)
+		return (-1);
+
+	path = (const char *)&words[2 + 3 * count];
+	end = (const char *)desc + descsz;
+	for (i = 0; i < count && path < end; i++) {
+		start = words[2 + 3 * i];
+		vend = words[2 + 3 * i + 1];
+		pgoff = words[2 + 3 * i + 2];
+
+		if (memchr(path, '\0', end - path) == NULL)
+			return (-1);
+
+		if ((mop = mdbv8_object_lookup(tp, path)) == NULL)
+			return (-1);
+
+		for (j = 0; j < tp->t_nmaps; j++) {
+			mdbv8_mapping_t *mmp = &tp->t_maps[j];
+			if (mmp->mm_vaddr == start &&
+			    mmp->mm_size == vend - start) {
+				mmp->mm_object = mop;
+				mmp->mm_offset = (off_t)(pgoff * pagesize);
+				break;
+			}
+		}
+
+		path += strlen(path) + 1;
+	}
+
+	return (0);
+}
+
+static void
+mdbv8_note_auxv(mdbv8_target_t *tp, const uint8_t *desc, size_t descsz)
+{
+	const Elf_auxv_t *auxv = (const Elf_auxv_t *)desc;
+	size_t i;
+
+	for (i = 0; i < descsz / sizeof (auxv[0]); i++) {
+		if (auxv[i].a_type == AT_ENTRY)
+			tp->t_entry = auxv[i].a_un.a_val;
+	}
+}
+
+static void
+mdbv8_note_prstatus(mdbv8_target_t *tp, const uint8_t *desc, size_t descsz)
+{
+	const prstatus_t *prsp = (const prstatus_t *)desc;
+
+	/*
+	 * The first thread is the one that caused the process to dump core.
+	 */
+	if (tp->t_hasregs || descsz < sizeof (*prsp))
+		return;
+
+	bcopy(prsp->pr_reg, tp->t_regs, sizeof (tp->t_regs));
+	tp->t_hasregs = B_TRUE;
+}
+
+static int
+mdbv8_notes(mdbv8_target_t *tp, const Elf_Phdr *php)
+{
+	const uint8_t *notes, *end, *name, *desc;
+	const Elf_Nhdr *nhdr;
+	size_t namesz, descsz;
+
+	if (php->p_offset > tp->t_size ||
+	    php->p_filesz > tp->t_size - php->p_offset)
+		return (-1);
+
+	notes = tp->t_base + php->p_offset;
+	end = notes + php->p_filesz;
+	while (end - notes >= (ssize_t)sizeof (*nhdr)) {
+		nhdr = (const Elf_Nhdr *)notes;
+		namesz = (nhdr->n_namesz + 3) & ~3;
+		descsz = (nhdr->n_descsz + 3) & ~3;
+		name = notes + sizeof (*nhdr);
+		desc = name + namesz;
+		if (namesz > end - name || descsz > end - desc)
+			return (-1);
+
+		notes = desc + descsz;
+		if (nhdr->n_namesz != sizeof ("CORE") ||
+		    strcmp((const char *)name, "CORE") != 0)
+			continue;
+
+		switch (nhdr->n_type) {
+		case NT_PRSTATUS:
+			mdbv8_note_prstatus(tp, desc, nhdr->n_descsz);
+			break;
+		case NT_AUXV:
+			mdbv8_note_auxv(tp, desc, nhdr->n_descsz);
+			break;
+		case NT_FILE:
+			if (mdbv8_note_file(tp, desc, nhdr->n_descsz) != 0)
+				return (-1);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Load the symbols from the symbol table section "shp" of the ELF object
+ * "mop".
+ */
+static int
+mdbv8_object_symtab(mdbv8_target_t *tp, mdbv8_object_t *mop,
+    const Elf_Shdr *shp, const Elf_Shdr *strshp, uint_t table)
+{
+	const GElf_Sym *syms;
+	const char *strtab;
+	mdbv8_sym_t *msp;
+	size_t i, nsyms;
+
+	if (shp->sh_entsize != sizeof (GElf_Sym) ||
+	    shp->sh_offset > mop->mo_size ||
+	    shp->sh_size > mop->mo_size - shp->sh_offset ||
+	    strshp->sh_offset > mop->mo_size ||
+	    strshp->sh_size > mop->mo_size - strshp->sh_offset ||
+	    strshp->sh_size == 0 || mop->mo_base[strshp->sh_offset +
+	    strshp->sh_size - 1] != '\0')
+		return (-1);
+
+	syms = (const GElf_Sym *)(mop->mo_base + shp->sh_offset);
+	nsyms = shp->sh_size / sizeof (GElf_Sym);
+	strtab = (const char *)(mop->mo_base + strshp->sh_offset);
+
+	if (tp->t_nsyms + nsyms > tp->t_maxsyms) {
+		size_t newmax = MAX(tp->t_maxsyms * 2, tp->t_nsyms + nsyms);
+		mdbv8_sym_t *newsyms;
+
+		newsyms = realloc(tp->t_syms, newmax * sizeof (newsyms[0]));
+		if (newsyms == NULL)
+			return (-1);
+
+		tp->t_syms = newsyms;
+		tp->t_maxsyms = newmax;
+	}
+
+	for (i = 1; i < nsyms; i++) {
+		if (syms[i].st_shndx == SHN_UNDEF ||
+		    syms[i].st_name >= strshp->sh_size ||
+		    strtab[syms[i].st_name] == '\0')
+			continue;
+
+		msp = &tp->t_syms[tp->t_nsyms++];
+		msp->ms_name = strtab + syms[i].st_name;
+		msp->ms_sym = syms[i];
+		if (syms[i].st_shndx != SHN_ABS)
+			msp->ms_sym.st_value += mop->mo_bias;
+		msp->ms_object = mop;
+		msp->ms_table = table;
+	}
+
+	return (0);
+}
+
+/*
+ * Compute the load bias of ELF object "mop" and load its symbols.  The object
+ * is loaded at the start of its first mapping whose file offset is zero.
+ */
+static void
+mdbv8_object_load(mdbv8_target_t *tp, mdbv8_object_t *mop)
+{
+	const Elf_Ehdr *ehdr;
+	const Elf_Phdr *php;
+	const Elf_Shdr *shdrs;
+	uintptr_t lowaddr = UINTPTR_MAX, start = 0;
+	size_t i;
+
+	if ((ehdr = mdbv8_elf_header(mop->mo_base, mop->mo_size,
+	    ET_NONE)) == NULL)
+		return;
+
+	for (i = 0; i < tp->t_nmaps; i++) {
+		if (tp->t_maps[i].mm_object == mop &&
+		    tp->t_maps[i].mm_offset == 0) {
+			start = tp->t_maps[i].mm_vaddr;
+			break;
+		}
+	}
+
+	if (i == tp->t_nmaps)
+		return;
+
+	for (i = 0; i < ehdr->e_phnum; i++) {
+		php = (const Elf_Phdr *)(mop->mo_base + ehdr->e_phoff +
+		    i * ehdr->e_phentsize);
+		if (php->p_type == PT_LOAD && php->p_vaddr < lowaddr)
+			lowaddr = php->p_vaddr;
+	}
+
+	if (lowaddr == UINTPTR_MAX)
+		return;
+
+	mop->mo_bias = start - (lowaddr & ~(uintptr_t)(getpagesize() - 1));
+
+	if (ehdr->e_shoff == 0 || ehdr->e_shoff > mop->mo_size ||
+	    ehdr->e_shentsize != sizeof (Elf_Shdr) ||
+	    (size_t)ehdr->e_shnum * sizeof (Elf_Shdr) >
+	    mop->mo_size - ehdr->e_shoff)
+		return;
+
+	shdrs = (const Elf_Shdr *)(mop->mo_base + ehdr->e_shoff);
+	for (i = 0; i < ehdr->e_shnum; i++) {
+		if ((shdrs[i].sh_type != SHT_SYMTAB &&
+		    shdrs[i].sh_type != SHT_DYNSYM) ||
+		    shdrs[i].sh_link >= ehdr->e_shnum)
+			continue;
+
+		(void) mdbv8_object_symtab(tp, mop, &shdrs[i],
+		    &shdrs[shdrs[i].sh_link], shdrs[i].sh_type == SHT_DYNSYM ?
+		    MDB_DYNSYM : MDB_SYMTAB);
+	}
+}
+
+static int
+mdbv8_symbols_sort(mdbv8_target_t *tp)
+{
+	size_t i;
+	int type;
+
+	tp->t_byname = calloc(tp->t_nsyms + 1, sizeof (tp->t_byname[0]));
+	tp->t_byaddr = calloc(tp->t_nsyms + 1, sizeof (tp->t_byaddr[0]));
+	if (tp->t_byname == NULL || tp->t_byaddr == NULL)
+		return (-1);
+
+	for (i = 0; i < tp->t_nsyms; i++) {
+		tp->t_byname[i] = &tp->t_syms[i];
+		type = ELF_ST_TYPE(tp->t_syms[i].ms_sym.st_info);
+		if (type == STT_FUNC || type == STT_OBJECT)
+			tp->t_byaddr[tp->t_naddrsyms++] = &tp->t_syms[i];
+	}
+
+	qsort(tp->t_byname, tp->t_nsyms, sizeof (tp->t_byname[0]),
+	    mdbv8_cmp_byname);
+	qsort(tp->t_byaddr, tp->t_naddrsyms, sizeof (tp->t_byaddr[0]),
+	    mdbv8_cmp_byaddr);
+	return (0);
+}
+
+/*
+ * Build the tables of regions whose contents are available.  Memory is read
+ * from the core file where possible and from the mapped objects otherwise.
+ */
+static int
+mdbv8_regions(mdbv8_target_t *tp, const Elf_Ehdr *ehdr)
+{
+	const Elf_Phdr *php;
+	mdbv8_mapping_t *mmp;
+	mdbv8_object_t *mop;
+	mdbv8_region_t *mrp;
+	size_t i;
+
+	tp->t_coreregions = calloc(ehdr->e_phnum + 1, sizeof (*mrp));
+	tp->t_objregions = calloc(tp->t_nmaps + 1, sizeof (*mrp));
+	if (tp->t_coreregions == NULL || tp->t_objregions == NULL)
+		return (-1);
+
+	for (i = 0; i < ehdr->e_phnum; i++) {
+		php = (const Elf_Phdr *)(tp->t_base + ehdr->e_phoff +
+		    i * ehdr->e_phentsize);
+		if (php->p_type != PT_LOAD || php->p_filesz == 0)
+			continue;
+
+		if (php->p_offset > tp->t_size ||
+		    php->p_filesz > tp->t_size - php->p_offset) {
+			mdb_warn("segment %d extends past end of file\n",
+			    (int)i);
+			return (-1);
+		}
+
+		mrp = &tp->t_coreregions[tp->t_ncoreregions++];
+		mrp->mr_vaddr = php->p_vaddr;
+		mrp->mr_size = php->p_filesz;
+		mrp->mr_data = tp->t_base + php->p_offset;
+	}
+
+	for (i = 0; i < tp->t_nmaps; i++) {
+		mmp = &tp->t_maps[i];
+		if ((mop = mmp->mm_object) == NULL || mop->mo_base == NULL ||
+		    mmp->mm_offset >= mop->mo_size)
+			continue;
+
+		mrp = &tp->t_objregions[tp->t_nobjregions++];
+		mrp->mr_vaddr = mmp->mm_vaddr;
+		mrp->mr_size = MIN(mmp->mm_size, mop->mo_size - mmp->mm_offset);
+		mrp->mr_data = mop->mo_base + mmp->mm_offset;
+	}
+
+	qsort(tp->t_coreregions, tp->t_ncoreregions, sizeof (*mrp),
+	    mdbv8_cmp_regions);
+	qsort(tp->t_objregions, tp->t_nobjregions, sizeof (*mrp),
+	    mdbv8_cmp_regions);
+	return (0);
+}
+
+/*
+ * Open the core file "path".  If "execpath" is non-NULL, it's used in place of
+ * the path of the executable recorded in the core file.
+ */
+int
+mdbv8_target_open(const char *path, const char *execpath)
+{
+	mdbv8_target_t *tp = &mdbv8_target;
+	const Elf_Ehdr *ehdr;
+	const Elf_Phdr *php;
+	mdbv8_mapping_t *mmp;
+	mdbv8_object_t *mop;
+	size_t i;
+
+	bzero(tp, sizeof (*tp));
+	if ((tp->t_base = mdbv8_map_file(path, &tp->t_size)) == NULL) {
+		mdb_warn("failed to map \"%s\"", path);
+		return (-1);
+	}
+
+	if ((ehdr = mdbv8_elf_header(tp->t_base, tp->t_size,
+	    ET_CORE)) == NULL) {
+		mdb_warn("\"%s\" is not an ELF core file of this program's "
+		    "class\n", path);
+		mdbv8_target_close();
+		return (-1);
+	}
+
+	tp->t_maps = calloc(ehdr->e_phnum + 1, sizeof (tp->t_maps[0]));
+	if (tp->t_maps == NULL) {
+		mdb_warn("failed to allocate mappings");
+		mdbv8_target_close();
+		return (-1);
+	}
+
+	for (i = 0; i < ehdr->e_phnum; i++) {
+		php = (const Elf_Phdr *)(tp->t_base + ehdr->e_phoff +
+		    i * ehdr->e_phentsize);
+		if (php->p_type != PT_LOAD)
+			continue;
+
+		mmp = &tp->t_maps[tp->t_nmaps++];
+		mmp->mm_vaddr = php->p_vaddr;
+		mmp->mm_size = php->p_memsz;
+		mmp->mm_mflags =
+		    ((php->p_flags & PF_R) != 0 ? MA_READ : 0) |
+		    ((php->p_flags & PF_W) != 0 ? MA_WRITE : 0) |
+		    ((php->p_flags & PF_X) != 0 ? MA_EXEC : 0);
+	}
+
+	for (i = 0; i < ehdr->e_phnum; i++) {
+		php = (const Elf_Phdr *)(tp->t_base + ehdr->e_phoff +
+		    i * ehdr->e_phentsize);
+		if (php->p_type == PT_NOTE && mdbv8_notes(tp, php) != 0) {
+			mdb_warn("\"%s\": notes are corrupt\n", path);
+			mdbv8_target_close();
+			return (-1);
+		}
+	}
+
+	/*
+	 * Identify the executable by its entry point, falling back to the
+	 * first mapped object.
+	 */
+	for (i = 0; i < tp->t_nmaps; i++) {
+		mmp = &tp->t_maps[i];
+		if (mmp->mm_object != NULL && tp->t_entry >= mmp->mm_vaddr &&
+		    tp->t_entry < mmp->mm_vaddr + mmp->mm_size) {
+			mmp->mm_object->mo_exec = B_TRUE;
+			break;
+		}
+	}
+
+	if (i == tp->t_nmaps && tp->t_nobjects > 0)
+		tp->t_objects[0].mo_exec = B_TRUE;
+
+	for (i = 0; i < tp->t_nobjects; i++) {
+		const char *objpath;
+
+		mop = &tp->t_objects[i];
+		objpath = mop->mo_exec && execpath != NULL ?
+		    execpath : mop->mo_path;
+		mop->mo_base = mdbv8_map_file(objpath, &mop->mo_size);
+		if (mop->mo_base == NULL) {
+			if (mop->mo_exec || strstr(mop->mo_name, ".so") != NULL)
+				mdb_warn("warning: failed to map \"%s\"\n",
+				    objpath);
+			continue;
+		}
+
+		mdbv8_object_load(tp, mop);
+	}
+
+	if (mdbv8_regions(tp, ehdr) != 0 || mdbv8_symbols_sort(tp) != 0) {
+		mdb_warn("failed to load \"%s\"", path);
+		mdbv8_target_close();
+		return (-1);
+	}
+
+	return (0);
+}
+
+void
+mdbv8_target_close(void)
+{
+	mdbv8_target_t *tp = &mdbv8_target;
+	size_t i;
+
+	for (i = 0; i < tp->t_nobjects; i++) {
+		if (tp->t_objects[i].mo_base != NULL) {
+			(void) munmap((void *)tp->t_objects[i].mo_base,
+			    tp->t_objects[i].mo_size);
+		}
+
+		free(tp->t_objects[i].mo_path);
+	}
+
+	if (tp->t_base != NULL)
+		(void) munmap((void *)tp->t_base, tp->t_size);
+
+	free(tp->t_objects);
+	free(tp->t_maps);
+	free(tp->t_coreregions);
+	free(tp->t_objregions);
+	free(tp->t_syms);
+	free(tp->t_byname);
+	free(tp->t_byaddr);
+	bzero(tp, sizeof (*tp));
+}
+
+static const mdbv8_region_t *
+mdbv8_region_lookup(const mdbv8_region_t *regions, size_t nregions,
+    uintptr_t addr)
+{
+	size_t lower = 0, upper = nregions, mid;
+	const mdbv8_region_t *mrp;
+
+	while (lower < upper) {
+		mid = (lower + upper) / 2;
+		if (regions[mid].mr_vaddr <= addr)
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+
+	if (lower == 0)
+		return (NULL);
+
+	mrp = &regions[lower - 1];
+	return (addr - mrp->mr_vaddr < mrp->mr_size ? mrp : NULL);
+}
+
+ssize_t
+mdb_vread(void *buf, size_t size, uintptr_t addr)
+{
+	mdbv8_target_t *tp = &mdbv8_target;
+	const mdbv8_region_t *mrp;
+	uint8_t *bufp = buf;
+	size_t nread = 0, n;
+
+	while (nread < size) {
+		if ((mrp = mdbv8_region_lookup(tp->t_coreregions,
+		    tp->t_ncoreregions, addr + nread)) == NULL &&
+		    (mrp = mdbv8_region_lookup(tp->t_objregions,
+		    tp->t_nobjregions, addr + nread)) == NULL) {
+			errno = EFAULT;
+			return (-1);
+		}
+
+		n = MIN(size - nread,
+		    mrp->mr_size - (addr + nread - mrp->mr_vaddr));
+		bcopy(mrp->mr_data + (addr + nread - mrp->mr_vaddr),
+		    bufp + nread, n);
+		nread += n;
+	}
+
+	return (size);
+}
+
+ssize_t
+mdb_readstr(char *buf, size_t nbytes, uintptr_t addr)
+{
+	size_t i;
+
+	if (nbytes == 0)
+		return (0);
+
+	for (i = 0; i < nbytes - 1; i++) {
+		if (mdb_vread(&buf[i], 1, addr + i) != 1)
+			return (-1);
+
+		if (buf[i] == '\0')
+			return (i);
+	}
+
+	buf[i] = '\0';
+	return (i);
+}
+
+static mdbv8_sym_t *
+mdbv8_lookup_by_name(const char *name)
+{
+	mdbv8_target_t *tp = &mdbv8_target;
+	size_t lower = 0, upper = tp->t_nsyms, mid;
+	int rv;
+
+	while (lower < upper) {
+		mid = (lower + upper) / 2;
+		rv = strcmp(tp->t_byname[mid]->ms_name, name);
+		if (rv < 0)
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+
+	if (lower == tp->t_nsyms || strcmp(tp->t_byname[lower]->ms_name,
+	    name) != 0)
+		return (NULL);
+
+	return (tp->t_byname[lower]);
+}
+
+int
+mdb_lookup_by_name(const char *name, GElf_Sym *symp)
+{
+	mdbv8_sym_t *msp;
+
+	if ((msp = mdbv8_lookup_by_name(name)) == NULL) {
+		errno = ENOENT;
+		return (-1);
+	}
+
+	if (symp != NULL)
+		*symp = msp->ms_sym;
+
+	return (0);
+}
+
+ssize_t
+mdb_readsym(void *buf, size_t size, const char *name)
+{
+	GElf_Sym sym;
+
+	if (mdb_lookup_by_name(name, &sym) != 0)
+		return (-1);
+
+	return (mdb_vread(buf, size, sym.st_value));
+}
+
+int
+mdb_symbol_iter(const char *obj, uint_t which, uint_t type,
+    int (*func)(mdb_symbol_t *, void *), void *arg)
+{
+	mdbv8_target_t *tp = &mdbv8_target;
+	mdbv8_sym_t *msp;
+	mdb_symbol_t sym;
+	uint_t bind, symtype;
+	size_t i;
+	int rv;
+
+	for (i = 0; i < tp->t_nsyms; i++) {
+		msp = &tp->t_syms[i];
+		if (msp->ms_table != which)
+			continue;
+
+		if (obj == MDB_OBJ_EXEC ? !msp->ms_object->mo_exec :
+		    obj != MDB_OBJ_EVERY && obj != MDB_OBJ_RTLD &&
+		    strcmp(obj, msp->ms_object->mo_name) != 0)
+			continue;
+
+		switch (ELF_ST_BIND(msp->ms_sym.st_info)) {
+		case STB_LOCAL:
+			bind = MDB_BIND_LOCAL;
+			break;
+		case STB_GLOBAL:
+			bind = MDB_BIND_GLOBAL;
+			break;
+		case STB_WEAK:
+			bind = MDB_BIND_WEAK;
+			break;
+		default:
+			bind = 0;
+			break;
+		}
+
+		switch (ELF_ST_TYPE(msp->ms_sym.st_info)) {
+		case STT_NOTYPE:
+			symtype = MDB_TYPE_NOTYPE;
+			break;
+		case STT_OBJECT:
+			symtype = MDB_TYPE_OBJECT;
+			break;
+		case STT_FUNC:
+			symtype = MDB_TYPE_FUNC;
+			break;
+		case STT_SECTION:
+			symtype = MDB_TYPE_SECT;
+			break;
+		case STT_FILE:
+			symtype = MDB_TYPE_FILE;
+			break;
+		case STT_COMMON:
+			symtype = MDB_TYPE_COMMON;
+			break;
+		case STT_TLS:
+			symtype = MDB_TYPE_TLS;
+			break;
+		default:
+			symtype = 0;
+			break;
+		}
+
+		if ((bind & type) == 0 || (symtype & type) == 0)
+			continue;
+
+		sym.sym_name = msp->ms_name;
+		sym.sym_object = msp->ms_object->mo_name;
+		sym.sym_sym = &msp->ms_sym;
+		sym.sym_table = msp->ms_table;
+		sym.sym_id = (uint_t)i;
+
+		if ((rv = func(&sym, arg)) != 0)
+			return (rv);
+	}
+
+	return (0);
+}
+
+/*
+ * Look up the symbol containing "addr".  Returns the symbol's name, and stores
+ * the name of the containing object (or NULL for the executable) and the
+ * offset of "addr" into the symbol.
+ */
+const char *
+mdbv8_target_lookup_addr(uintptr_t addr, const char **objp, uintptr_t *offp)
+{
+	mdbv8_target_t *tp = &mdbv8_target;
+	size_t lower = 0, upper = tp->t_naddrsyms, mid, i;
+	mdbv8_sym_t *msp;
+
+	while (lower < upper) {
+		mid = (lower + upper) / 2;
+		if (tp->t_byaddr[mid]->ms_sym.st_value <= addr)
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+
+	/*
+	 * Symbols may overlap, so consider a few symbols preceding the last
+	 * one that starts before "addr".
+	 */
+	for (i = lower; i > 0 && lower - i < 16; i--) {
+		msp = tp->t_byaddr[i - 1];
+		if (addr - msp->ms_sym.st_value < msp->ms_sym.st_size ||
+		    addr == msp->ms_sym.st_value) {
+			*objp = msp->ms_object->mo_exec ?
+			    NULL : msp->ms_object->mo_name;
+			*offp = addr - msp->ms_sym.st_value;
+			return (msp->ms_name);
+		}
+	}
+
+	return (NULL);
+}
+
+/*
+ * Iterate the mappings in the core file.  This is the only part of libproc
+ * that mdb_v8 uses, and the process handle argument is ignored.
+ */
+/* ARGSUSED */
+int
+Pmapping_iter(struct ps_prochandle *P, proc_map_f *func, void *arg)
+{
+	mdbv8_target_t *tp = &mdbv8_target;
+	mdbv8_mapping_t *mmp;
+	prmap_t map;
+	size_t i;
+	int rv;
+
+	for (i = 0; i < tp->t_nmaps; i++) {
+		mmp = &tp->t_maps[i];
+		bzero(&map, sizeof (map));
+		map.pr_vaddr = mmp->mm_vaddr;
+		map.pr_size = mmp->mm_size;
+		map.pr_offset = mmp->mm_offset;
+		map.pr_mflags = mmp->mm_mflags;
+		map.pr_pagesize = getpagesize();
+		if (mmp->mm_object == NULL)
+			map.pr_mflags |= MA_ANON;
+		else
+			(void) strlcpy(map.pr_mapname,
+			    mmp->mm_object->mo_name, sizeof (map.pr_mapname));
+
+		if ((rv = func(arg, &map, mmp->mm_object == NULL ? NULL :
+		    mmp->mm_object->mo_path)) != 0)
+			return (rv);
+	}
+
+	return (0);
+}
+
+/*
+ * The only external data that mdb_v8 asks for is the libproc handle, which is
+ * only passed back to Pmapping_iter().
+ */
+ssize_t
+mdb_get_xdata(const char *name, void *buf, size_t nbytes)
+{
+	struct ps_prochandle *P = (struct ps_prochandle *)&mdbv8_target;
+
+	if (strcmp(name, "pshandle") != 0 || nbytes < sizeof (P)) {
+		errno = ENOENT;
+		return (-1);
+	}
+
+	bcopy(&P, buf, sizeof (P));
+	return (sizeof (P));
+}
+
+int
+mdb_get_state(void)
+{
+	return (MDB_STATE_DEAD);
+}
+
+/* ARGSUSED */
+int
+mdb_getareg(uint_t tid, const char *rname, mdb_reg_t *rp)
+{
+	mdbv8_target_t *tp = &mdbv8_target;
+	int reg;
+
+#if defined(__amd64)
+	if (strcmp(rname, "rbp") == 0)
+		reg = RBP;
+	else if (strcmp(rname, "rip") == 0)
+		reg = RIP;
+	else if (strcmp(rname, "rsp") == 0)
+		reg = RSP;
+	else
+		reg = -1;
+#elif defined(__i386)
+	if (strcmp(rname, "ebp") == 0)
+		reg = EBP;
+	else if (strcmp(rname, "eip") == 0)
+		reg = EIP;
+	else if (strcmp(rname, "esp") == 0)
+		reg = UESP;
+	else
+		reg = -1;
+#else
+	reg = -1;
+#endif
+
+	if (!tp->t_hasregs || reg == -1) {
+		errno = ENOENT;
+		return (-1);
+	}
+
+	*rp = (mdb_reg_t)tp->t_regs[reg];
+	return (0);
+}
@@ -0,0 +1,21 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2018, Joyent, Inc.
+ */
+
+/*
+ * sys/elf.h: illumos provides the ELF definitions here, while other systems
+ * provide them in <elf.h>.  This header is only used by the standalone build.
+ */
+
+#ifndef	_MDBV8_STANDALONE_SYS_ELF_H
+#define	_MDBV8_STANDALONE_SYS_ELF_H
+
+#include <elf.h>
+
+#endif	/* _MDBV8_STANDALONE_SYS_ELF_H */
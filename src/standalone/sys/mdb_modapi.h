@@ -0,0 +1,203 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2018, Joyent, Inc.
+ */
+
+/*
+ * sys/mdb_modapi.h: the subset of the MDB module API that mdb_v8 uses.  This
+ * header is used in place of the real one when the debugger module's sources
+ * are compiled into the standalone "mdbv8" program, which implements these
+ * interfaces itself on top of an ELF core file.  See mdbv8.c.
+ *
+ * The definitions here match the real ones closely enough for mdb_v8's
+ * purposes, but they're not complete, and they're not ABI-compatible with
+ * mdb.  Nothing here should be used outside of the standalone build.
+ */
+
+#ifndef	_MDBV8_STANDALONE_MDB_MODAPI_H
+#define	_MDBV8_STANDALONE_MDB_MODAPI_H
+
+#include <sys/types.h>
+#include <elf.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#ifdef	_LP64
+typedef Elf64_Sym	GElf_Sym;
+#else
+typedef Elf32_Sym	GElf_Sym;
+#endif
+
+/*
+ * Module API definitions.
+ */
+#ifndef	MDB_API_VERSION
+#define	MDB_API_VERSION	3
+#endif
+
+#define	DCMD_OK		0		/* dcmd completed successfully */
+#define	DCMD_ERR	1		/* dcmd failed due to an error */
+#define	DCMD_USAGE	2		/* dcmd usage error */
+#define	DCMD_NEXT	3		/* invoke next dcmd */
+#define	DCMD_ABORT	4		/* dcmd failed; abort current loop */
+
+#define	DCMD_ADDRSPEC	0x01		/* dcmd invoked with address */
+#define	DCMD_LOOP	0x02		/* dcmd invoked in loop with ,cnt */
+#define	DCMD_LOOPFIRST	0x04		/* first iteration of a loop */
+#define	DCMD_PIPE	0x08		/* dcmd invoked with input from pipe */
+#define	DCMD_PIPE_OUT	0x10		/* dcmd output is piped */
+
+#define	DCMD_HDRSPEC(fl)	(((fl) & DCMD_LOOPFIRST) || !((fl) & DCMD_LOOP))
+
+#define	WALK_ERR	-1		/* walk fails */
+#define	WALK_NEXT	0		/* walk continues to next step */
+#define	WALK_DONE	1		/* walk is complete (no error) */
+
+#define	UM_NOSLEEP	0x0		/* allocation may fail */
+#define	UM_SLEEP	0x1		/* allocation may not fail */
+#define	UM_GC		0x2		/* free at end of current command */
+
+#define	MDB_TYPE_STRING		0	/* a_un.a_str is valid */
+#define	MDB_TYPE_IMMEDIATE	1	/* a_un.a_val is valid */
+#define	MDB_TYPE_CHAR		2	/* a_un.a_char is valid */
+
+#define	MDB_OPT_SETBITS		1	/* set specified flag bits */
+#define	MDB_OPT_CLRBITS		2	/* clear specified flag bits */
+#define	MDB_OPT_STR		3	/* const char * argument */
+#define	MDB_OPT_UINTPTR		4	/* uintptr_t argument */
+#define	MDB_OPT_UINT64		5	/* uint64_t argument */
+#define	MDB_OPT_UINTPTR_SET	6	/* boolean_t+uintptr_t argument */
+
+#define	MDB_OBJ_EXEC		((const char *)0L)	/* primary executable */
+#define	MDB_OBJ_RTLD		((const char *)1L)	/* run-time linker */
+#define	MDB_OBJ_EVERY		((const char *)-1L)	/* all known symbols */
+
+#define	MDB_SYMTAB		1	/* normal symbol table (.symtab) */
+#define	MDB_DYNSYM		2	/* dynamic symbol table (.dynsym) */
+
+#define	MDB_BIND_LOCAL		0x0001	/* local symbols */
+#define	MDB_BIND_GLOBAL		0x0002	/* global symbols */
+#define	MDB_BIND_WEAK		0x0004	/* weak symbols */
+#define	MDB_BIND_ANY		0x0007	/* any of the above */
+
+#define	MDB_TYPE_NOTYPE		0x0100	/* symbol has no type */
+#define	MDB_TYPE_OBJECT		0x0200	/* symbol refers to data */
+#define	MDB_TYPE_FUNC		0x0400	/* symbol refers to text */
+#define	MDB_TYPE_SECT		0x0800	/* symbol refers to a section */
+#define	MDB_TYPE_FILE		0x1000	/* symbol refers to a source file */
+#define	MDB_TYPE_COMMON		0x2000	/* symbol refers to a common block */
+#define	MDB_TYPE_TLS		0x4000	/* symbol refers to TLS */
+#define	MDB_TYPE_ANY		0x7f00	/* any of the above */
+
+#define	MDB_STATE_IDLE		0	/* target is idle (not running yet) */
+#define	MDB_STATE_RUNNING	1	/* target is currently executing */
+#define	MDB_STATE_STOPPED	2	/* target is stopped */
+#define	MDB_STATE_UNDEAD	3	/* target is undead (zombie) */
+#define	MDB_STATE_DEAD		4	/* target is dead (core dump) */
+#define	MDB_STATE_LOST		5	/* target lost by debugger */
+
+typedef uint64_t mdb_reg_t;
+
+typedef struct mdb_arg {
+	uint_t a_type;
+	union {
+		const char *a_str;
+		uint64_t a_val;
+		char a_char;
+	} a_un;
+} mdb_arg_t;
+
+typedef int mdb_walk_cb_t(uintptr_t, const void *, void *);
+
+typedef struct mdb_walk_state {
+	mdb_walk_cb_t *walk_callback;	/* callback to issue */
+	void *walk_cbdata;		/* callback private data */
+	uintptr_t walk_addr;		/* current address */
+	void *walk_data;		/* walk private data */
+	void *walk_arg;			/* walk private argument */
+	const void *walk_layer;		/* data from underlying layer */
+} mdb_walk_state_t;
+
+typedef struct mdb_dcmd {
+	const char *dc_name;		/* command name */
+	const char *dc_usage;		/* usage message (optional) */
+	const char *dc_descr;		/* description */
+	int (*dc_funcp)(uintptr_t, uint_t, int, const mdb_arg_t *);
+	void (*dc_help)(void);		/* command help function (or NULL) */
+	void *dc_tabp;			/* tab completion function (unused) */
+} mdb_dcmd_t;
+
+typedef struct mdb_walker {
+	const char *walk_name;		/* walk type name */
+	const char *walk_descr;		/* walk description */
+	int (*walk_init)(mdb_walk_state_t *);
+	int (*walk_step)(mdb_walk_state_t *);
+	void (*walk_fini)(mdb_walk_state_t *);
+	void *walk_init_arg;		/* walk private argument */
+} mdb_walker_t;
+
+typedef struct mdb_modinfo {
+	ushort_t mi_dvers;		/* debugger version number */
+	const mdb_dcmd_t *mi_dcmds;	/* NULL-terminated list of dcmds */
+	const mdb_walker_t *mi_walkers;	/* NULL-terminated list of walks */
+} mdb_modinfo_t;
+
+typedef struct mdb_symbol {
+	const char *sym_name;		/* name of symbol */
+	const char *sym_object;		/* name of containing object */
+	const GElf_Sym *sym_sym;	/* ELF symbol information */
+	uint_t sym_table;		/* symbol table id */
+	uint_t sym_id;			/* symbol identifier */
+} mdb_symbol_t;
+
+typedef struct mdb_pipe {
+	uintptr_t *pipe_data;		/* array of pipe values */
+	size_t pipe_len;		/* array length */
+} mdb_pipe_t;
+
+extern int mdb_pwalk(const char *, mdb_walk_cb_t *, void *, uintptr_t);
+extern int mdb_walk(const char *, mdb_walk_cb_t *, void *);
+extern int mdb_pwalk_dcmd(const char *, const char *, int,
+    const mdb_arg_t *, uintptr_t);
+extern int mdb_call_dcmd(const char *, uintptr_t, uint_t, int,
+    const mdb_arg_t *);
+
+extern ssize_t mdb_vread(void *, size_t, uintptr_t);
+extern ssize_t mdb_readstr(char *, size_t, uintptr_t);
+extern ssize_t mdb_readsym(void *, size_t, const char *);
+extern int mdb_lookup_by_name(const char *, GElf_Sym *);
+extern int mdb_symbol_iter(const char *, uint_t, uint_t,
+    int (*)(mdb_symbol_t *, void *), void *);
+extern int mdb_getareg(uint_t, const char *, mdb_reg_t *);
+extern ssize_t mdb_get_xdata(const char *, void *, size_t);
+extern int mdb_get_state(void);
+
+extern int mdb_eval(const char *);
+extern uintptr_t mdb_get_dot(void);
+extern void mdb_set_dot(uintptr_t);
+extern void mdb_get_pipe(mdb_pipe_t *);
+extern u_longlong_t mdb_strtoull(const char *);
+extern int mdb_getopts(int, const mdb_arg_t *, ...);
+
+extern void *mdb_alloc(size_t, uint_t);
+extern void *mdb_zalloc(size_t, uint_t);
+extern void mdb_free(void *, size_t);
+
+extern int mdb_printf(const char *, ...);
+extern size_t mdb_snprintf(char *, size_t, const char *, ...);
+extern size_t mdb_vsnprintf(char *, size_t, const char *, va_list);
+extern void mdb_warn(const char *, ...);
+extern void mdb_inc_indent(ulong_t);
+extern void mdb_dec_indent(ulong_t);
+
+#endif	/* _MDBV8_STANDALONE_MDB_MODAPI_H */
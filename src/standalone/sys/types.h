@@ -0,0 +1,56 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2018, Joyent, Inc.
+ */
+
+/*
+ * sys/types.h: mdb_v8 relies on the illumos <sys/types.h> (and the headers it
+ * includes) for a number of definitions that other systems don't provide.  For
+ * the standalone build, this header wraps the system's <sys/types.h> and
+ * supplies those definitions.
+ */
+
+#ifndef	_MDBV8_STANDALONE_SYS_TYPES_H
+#define	_MDBV8_STANDALONE_SYS_TYPES_H
+
+#include_next <sys/types.h>
+#include <sys/param.h>
+#include <stdint.h>
+
+#if defined(__LP64__) && !defined(_LP64)
+#define	_LP64	1
+#endif
+
+typedef enum { B_FALSE = 0, B_TRUE = 1 } boolean_t;
+typedef unsigned char uchar_t;
+typedef unsigned short ushort_t;
+typedef unsigned int uint_t;
+typedef unsigned long ulong_t;
+typedef unsigned long long u_longlong_t;
+typedef long long hrtime_t;
+
+#define	MILLISEC	1000
+#define	MICROSEC	1000000
+#define	NANOSEC		1000000000LL
+
+#ifndef	MIN
+#define	MIN(a, b)	((a) < (b) ? (a) : (b))
+#endif
+#ifndef	MAX
+#define	MAX(a, b)	((a) > (b) ? (a) : (b))
+#endif
+
+/*
+ * Not every C library provides strlcpy(), so we always use our own.
+ */
+#define	strlcpy		mdbv8_strlcpy
+
+extern hrtime_t gethrtime(void);
+extern size_t mdbv8_strlcpy(char *, const char *, size_t);
+
+#endif	/* _MDBV8_STANDALONE_SYS_TYPES_H */
@@ -31,6 +31,7 @@ typedef struct v8_cfg {
 	int (*v8cfg_iter)(struct v8_cfg *, int (*)(mdb_symbol_t *, void *),
 	    void *);
 	int (*v8cfg_readsym)(struct v8_cfg *, const char *, intptr_t *);
+	int (*v8cfg_symvalue)(struct v8_cfg *, mdb_symbol_t *, intptr_t *);
 } v8_cfg_t;
 
 extern v8_cfg_t v8_cfg_04;
@@ -38,4 +39,8 @@ extern v8_cfg_t v8_cfg_06;
 extern v8_cfg_t v8_cfg_target;
 extern v8_cfg_t *v8_cfgs[];
 
+v8_cfg_t *v8cfg_cache_load(const char *, const char *);
+void v8cfg_cache_free(v8_cfg_t *);
+int v8cfg_cache_save(const char *, const char *);
+
 #endif /* V8CFG_H */
@@ -257,6 +257,13 @@ function createMdbSession(args, callback)
 		mdb.onExit(code);
 	});
 
+	/*
+	 * Decode output as a stream so that multi-byte UTF-8 characters split
+	 * across reads aren't mangled.
+	 */
+	mdb.mdb_child.stdout.setEncoding('utf8');
+	mdb.mdb_child.stderr.setEncoding('utf8');
+
 	mdb.mdb_child.stdout.on('data', function (chunk) {
 		mdb.mdb_stdout += chunk;
 		mdb.doWork();
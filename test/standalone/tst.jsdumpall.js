@@ -0,0 +1,170 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * tst.jsdumpall.js: checks "::jsdumpall" against the pipeline it replaces,
+ * "::findjsobjects -l | ::findjsobjects | ::jsprint -a", on the same core file.
+ * "::jsdumpall" should print exactly the objects listed by "::findjsobjects -l
+ * | ::findjsobjects", in ascending address order, and print each one exactly as
+ * "::jsprint -a" does.  With -o, it should write the same output to a file.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var util = require('util');
+
+var common = require('./common');
+
+var PRINTOPTS = '-d 1 -N 0t100';
+
+var testObject;
+
+/*
+ * Splits the output of "::jsprint -a" for any number of top-level objects
+ * into an object mapping each top-level object's address to its output.
+ * Each object's output starts with its address at the beginning of a line.
+ * Nested objects' addresses are indented.
+ */
+function splitObjects(output)
+{
+	var lines, rv, order, addr, match, i;
+
+	lines = common.splitMdbLines(output, {});
+	rv = {};
+	order = [];
+	addr = null;
+	for (i = 0; i < lines.length; i++) {
+		match = lines[i].match(/^([0-9a-fA-F]+): /);
+		if (match !== null) {
+			addr = match[1];
+			assert.ok(!rv.hasOwnProperty(addr),
+			    'object printed twice: ' + addr);
+			rv[addr] = [];
+			order.push(addr);
+		}
+
+		assert.notStrictEqual(addr, null,
+		    'unexpected output: ' + lines[i]);
+		rv[addr].push(lines[i]);
+	}
+
+	Object.keys(rv).forEach(function (k) {
+		rv[k] = rv[k].join('\n');
+	});
+
+	return ({ 'objects': rv, 'order': order });
+}
+
+function main()
+{
+	var testFuncs = [];
+	var addrTestObject;
+	var listed, dumped, dumpOutput, outfile;
+
+	testObject = {
+	    'aString': 'hello world',
+	    'aNumber': 42,
+	    'anArray': [ 1, 'two', { 'three': 3 } ],
+	    'aNested': { 'inner': { 'deeper': true } }
+	};
+
+	testFuncs.push(function findTestObjectAddress(mdb, callback) {
+		common.findTestObject(mdb, function (err, addr) {
+			addrTestObject = addr;
+			callback(err);
+		});
+	});
+
+	testFuncs.push(function listObjects(mdb, callback) {
+		mdb.runCmd('::findjsobjects -l | ::findjsobjects\n',
+		    function (output) {
+			listed = common.splitMdbLines(output, {});
+			assert.ok(listed.length > 0);
+			listed.forEach(function (line) {
+				assert.ok(/^[0-9a-fA-F]+$/.test(line),
+				    'unexpected output: ' + line);
+			});
+			callback();
+		    });
+	});
+
+	testFuncs.push(function checkDumpAll(mdb, callback) {
+		console.error('test: ::jsdumpall prints listed objects');
+		mdb.runCmd('::jsdumpall ' + PRINTOPTS + '\n',
+		    function (output, erroutput) {
+			var sorted;
+
+			assert.strictEqual(erroutput, '');
+			dumpOutput = output;
+			dumped = splitObjects(output);
+
+			sorted = listed.slice(0).sort(function (a, b) {
+				return (parseInt(a, 16) - parseInt(b, 16));
+			});
+			assert.deepEqual(dumped.order, sorted);
+			assert.ok(dumped.objects.hasOwnProperty(addrTestObject),
+			    'test object missing from output');
+			callback();
+		    });
+	});
+
+	testFuncs.push(function checkPipeline(mdb, callback) {
+		var cmdstr;
+
+		console.error('test: ::jsdumpall matches ::jsprint -a');
+		cmdstr = util.format('::findjsobjects -l | ::findjsobjects | ' +
+		    '::jsprint -a %s\n', PRINTOPTS);
+		mdb.runCmd(cmdstr, function (output) {
+			var printed = splitObjects(output);
+
+			assert.ok(printed.objects.hasOwnProperty(
+			    addrTestObject), 'test object missing from ' +
+			    '::jsprint output');
+			printed.order.forEach(function (addr) {
+				assert.strictEqual(dumped.objects[addr],
+				    printed.objects[addr],
+				    'output differs for object ' + addr);
+			});
+			callback();
+		});
+	});
+
+	testFuncs.push(function checkOutputFile(mdb, callback) {
+		var cmdstr;
+
+		console.error('test: ::jsdumpall -o');
+		outfile = mdb.mdb_target_name + '.jsdumpall';
+		cmdstr = util.format('::jsdumpall %s -o %s\n',
+		    PRINTOPTS, outfile);
+		mdb.runCmd(cmdstr, function (output, erroutput) {
+			var lines;
+
+			assert.strictEqual(erroutput, '');
+			lines = common.splitMdbLines(output, { 'count': 1 });
+			assert.strictEqual(lines[0], util.format(
+			    'wrote %d objects to %s', listed.length, outfile));
+			assert.strictEqual(fs.readFileSync(outfile, 'utf8'),
+			    dumpOutput);
+			fs.unlinkSync(outfile);
+			callback();
+		});
+	});
+
+	common.finalizeTestObject(testObject);
+	common.standaloneTest(testFuncs, function (err) {
+		if (err) {
+			throw (err);
+		}
+
+		console.log('%s passed', process.argv[1]);
+	});
+}
+
+main();
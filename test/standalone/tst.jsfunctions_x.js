@@ -0,0 +1,161 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * tst.jsfunctions_x.js: checks "::jsfunctions -x", which lists the functions
+ * whose compiled instructions include a given address.  For an address inside
+ * a known function's instructions, the function must be listed, every function
+ * listed must contain the address, and they must be listed in order of their
+ * starting addresses.  For an address outside all functions' instructions,
+ * nothing must be listed.
+ */
+
+var assert = require('assert');
+var util = require('util');
+
+var common = require('./common');
+
+/*
+ * An address well below anywhere the VM puts code.
+ */
+var OUTSIDE_ADDR = 0x10;
+
+var testObject;
+
+function jsfunctionsXTarget(n)
+{
+	var i, sum = 0;
+
+	for (i = 0; i < n; i++)
+		sum += i * i;
+
+	return (sum);
+}
+
+/*
+ * Parses the output of "::jsfunctions -X", skipping the header line, into an
+ * array of objects with the function's "name" and the "start" and "end" of its
+ * instructions.  Functions whose instructions aren't known are skipped.
+ */
+function parseRanges(lines)
+{
+	var rv = [];
+
+	assert.ok(lines.length > 0);
+	assert.ok(/^\s*FUNC\s+#FUNCS\s+START\s+END\s+NAME/.test(lines[0]),
+	    'unexpected header: ' + lines[0]);
+	lines.slice(1).forEach(function (line) {
+		var parts = line.trim().split(/\s+/);
+
+		if (parts[2] == '?')
+			return;
+
+		rv.push({
+		    'name': parts[4],
+		    'start': parseInt(parts[2], 16),
+		    'end': parseInt(parts[3], 16)
+		});
+	});
+
+	return (rv);
+}
+
+function main()
+{
+	var testFuncs = [];
+	var range, i;
+
+	/*
+	 * Call the function enough that it has instructions of its own.
+	 */
+	for (i = 0; i < 10000; i++)
+		jsfunctionsXTarget(100);
+
+	testObject = { 'func': jsfunctionsXTarget };
+
+	testFuncs.push(function findTestObjectAddress(mdb, callback) {
+		common.findTestObject(mdb, function (err) {
+			callback(err);
+		});
+	});
+
+	testFuncs.push(function findFunction(mdb, callback) {
+		mdb.runCmd('::jsfunctions -X -n jsfunctionsXTarget\n',
+		    function (output) {
+			var ranges;
+			ranges = parseRanges(common.splitMdbLines(output, {}));
+			assert.strictEqual(ranges.length, 1,
+			    'expected one function with known instructions');
+			assert.strictEqual(ranges[0].name,
+			    'jsfunctionsXTarget');
+			assert.ok(ranges[0].start < ranges[0].end);
+			range = ranges[0];
+			callback();
+		    });
+	});
+
+	testFuncs.push(function checkInside(mdb, callback) {
+		var addr, cmdstr;
+
+		console.error('test: ::jsfunctions -x inside a function');
+		addr = range.start + Math.floor((range.end - range.start) / 2);
+		cmdstr = util.format('::jsfunctions -X -x 0x%s\n',
+		    addr.toString(16));
+		mdb.runCmd(cmdstr, function (output, erroutput) {
+			var ranges, j, found;
+
+			assert.strictEqual(erroutput, '');
+			ranges = parseRanges(common.splitMdbLines(output, {}));
+			found = false;
+			for (j = 0; j < ranges.length; j++) {
+				assert.ok(ranges[j].start <= addr &&
+				    addr < ranges[j].end,
+				    'listed function does not contain address');
+				if (j > 0) {
+					assert.ok(ranges[j - 1].start <=
+					    ranges[j].start,
+					    'functions not in address order');
+				}
+				if (ranges[j].name == 'jsfunctionsXTarget')
+					found = true;
+			}
+			assert.ok(found, 'test function not listed');
+			callback();
+		});
+	});
+
+	testFuncs.push(function checkOutside(mdb, callback) {
+		var cmdstr;
+
+		console.error('test: ::jsfunctions -x outside all functions');
+		cmdstr = util.format('::jsfunctions -x 0x%s\n',
+		    OUTSIDE_ADDR.toString(16));
+		mdb.runCmd(cmdstr, function (output, erroutput) {
+			var lines;
+
+			assert.strictEqual(erroutput, '');
+			lines = common.splitMdbLines(output, { 'count': 1 });
+			assert.ok(/^\s*FUNC\s+#FUNCS\s+NAME\s+FROM$/.test(
+			    lines[0]), 'unexpected output: ' + lines[0]);
+			callback();
+		});
+	});
+
+	common.finalizeTestObject(testObject);
+	common.standaloneTest(testFuncs, function (err) {
+		if (err) {
+			throw (err);
+		}
+
+		console.log('%s passed', process.argv[1]);
+	});
+}
+
+main();
@@ -0,0 +1,148 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * tst.jsonl.js: checks that every line of the "-j" output of ::findjsobjects,
+ * ::jsfunctions, and ::jsstack is valid JSON.  The test object has property
+ * names with characters that must be escaped, and its record is checked to
+ * make sure they come through intact.
+ */
+
+var assert = require('assert');
+
+var common = require('./common');
+
+var testObject;
+
+/*
+ * Runs "cmdstr" and returns (via "callback") the records it printed, having
+ * parsed each line as JSON.
+ */
+function runJsonCmd(mdb, cmdstr, callback)
+{
+	console.error('test: %s', cmdstr.trim());
+	mdb.runCmd(cmdstr, function (output, erroutput) {
+		var lines, records;
+
+		assert.strictEqual(erroutput, '');
+		lines = common.splitMdbLines(output, {});
+		assert.ok(lines.length > 0, 'expected some output');
+		records = lines.map(function (line) {
+			var record;
+
+			try {
+				record = JSON.parse(line);
+			} catch (ex) {
+				throw (new Error('invalid JSON: ' + line));
+			}
+
+			assert.equal(typeof (record), 'object',
+			    'expected an object: ' + line);
+			return (record);
+		});
+
+		callback(records);
+	});
+}
+
+function main()
+{
+	var testFuncs = [];
+	var propnames;
+
+	propnames = [ 'jsonlMarker', 'quote"d', 'back\\slash', 'new\nline' ];
+	testObject = {};
+	propnames.forEach(function (name, i) {
+		testObject[name] = i;
+	});
+
+	testFuncs.push(function findTestObjectAddress(mdb, callback) {
+		common.findTestObject(mdb, function (err) {
+			callback(err);
+		});
+	});
+
+	testFuncs.push(function checkFindjsobjects(mdb, callback) {
+		runJsonCmd(mdb, '::findjsobjects -j\n', function (records) {
+			var found;
+
+			records.forEach(function (record) {
+				assert.equal(typeof (record.addr), 'string');
+				assert.ok(/^0x[0-9a-f]+$/.test(record.addr),
+				    'unexpected addr: ' + record.addr);
+				assert.equal(typeof (record.count), 'number');
+				assert.equal(typeof (record.nprops), 'number');
+				assert.ok(Array.isArray(record.props));
+			});
+
+			found = records.filter(function (record) {
+				return (record.props.indexOf(
+				    'jsonlMarker') !== -1);
+			});
+			assert.ok(found.length > 0,
+			    'did not find test object\'s kind');
+			propnames.forEach(function (name) {
+				assert.notStrictEqual(
+				    found[0].props.indexOf(name), -1,
+				    'missing property ' + JSON.stringify(name));
+			});
+			callback();
+		});
+	});
+
+	testFuncs.push(function checkJsfunctions(mdb, callback) {
+		runJsonCmd(mdb, '::jsfunctions -j\n', function (records) {
+			var found;
+
+			records.forEach(function (record) {
+				assert.equal(typeof (record.addr), 'string');
+				assert.ok(/^0x[0-9a-f]+$/.test(record.addr),
+				    'unexpected addr: ' + record.addr);
+				assert.equal(typeof (record.count), 'number');
+				assert.equal(typeof (record.name), 'string');
+				assert.equal(typeof (record.script), 'string');
+			});
+
+			found = records.filter(function (record) {
+				return (record.name == 'runJsonCmd' &&
+				    record.script == __filename);
+			});
+			assert.strictEqual(found.length, 1,
+			    'did not find runJsonCmd');
+			callback();
+		});
+	});
+
+	testFuncs.push(function checkJsstack(mdb, callback) {
+		runJsonCmd(mdb, '::jsstack -j\n', function (records) {
+			records.forEach(function (record) {
+				assert.ok(record.kind == 'js' ||
+				    record.kind == 'native',
+				    'unexpected kind: ' + record.kind);
+				assert.ok(/^0x[0-9a-f]+$/.test(record.frame),
+				    'unexpected frame: ' + record.frame);
+				assert.ok(/^0x[0-9a-f]+$/.test(record.pc),
+				    'unexpected pc: ' + record.pc);
+			});
+			callback();
+		});
+	});
+
+	common.finalizeTestObject(testObject);
+	common.standaloneTest(testFuncs, function (err) {
+		if (err) {
+			throw (err);
+		}
+
+		console.log('%s passed', process.argv[1]);
+	});
+}
+
+main();
@@ -0,0 +1,130 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * tst.jsprint_visited.js: checks that "::jsprint" prints a reference to an
+ * object it has already printed rather than printing it again: "[Circular
+ * <addr>]" for an object that contains itself (directly or through another
+ * object), and "[Shared <addr>]" for an object reachable through two
+ * properties.
+ */
+
+var assert = require('assert');
+var util = require('util');
+
+var common = require('./common');
+
+var testObject;
+
+function main()
+{
+	var testFuncs = [];
+	var cyclic, shared;
+	var addrTestObject;
+	var addrs = {};
+
+	cyclic = { 'marker': 1 };
+	cyclic.self = cyclic;
+	cyclic.other = { 'back': cyclic };
+
+	shared = { 'sharedMarker': 2 };
+
+	testObject = {
+	    'cyclic': cyclic,
+	    'holder': { 'first': shared, 'second': shared }
+	};
+
+	testFuncs.push(function findTestObjectAddress(mdb, callback) {
+		common.findTestObject(mdb, function (err, addr) {
+			addrTestObject = addr;
+			callback(err);
+		});
+	});
+
+	[ 'cyclic', 'holder', 'holder.first' ].forEach(function (member) {
+		testFuncs.push(function findMember(mdb, callback) {
+			var cmdstr = util.format('%s::jsprint -a %s\n',
+			    addrTestObject, member);
+			mdb.runCmd(cmdstr, function (output) {
+				var lines = common.splitMdbLines(output, {});
+				addrs[member] = lines[0].split(':')[0];
+				assert.ok(/^[0-9a-fA-F]+$/.test(addrs[member]),
+				    'unexpected output: ' + lines[0]);
+				callback();
+			});
+		});
+	});
+
+	testFuncs.push(function checkCircular(mdb, callback) {
+		console.error('test: ::jsprint of circular object');
+		mdb.runCmd(addrs['cyclic'] + '::jsprint -d 3\n',
+		    function (output, erroutput) {
+			var addr = addrs['cyclic'];
+			assert.strictEqual(erroutput, '');
+			assert.deepEqual(common.splitMdbLines(output, {}), [
+			    '{',
+			    '    "marker": 1,',
+			    '    "self": [Circular ' + addr + '],',
+			    '    "other": {',
+			    '        "back": [Circular ' + addr + '],',
+			    '    },',
+			    '}'
+			]);
+			callback();
+		    });
+	});
+
+	testFuncs.push(function checkShared(mdb, callback) {
+		console.error('test: ::jsprint of object reached twice');
+		mdb.runCmd(addrs['holder'] + '::jsprint\n',
+		    function (output, erroutput) {
+			var addr = addrs['holder.first'];
+			assert.strictEqual(erroutput, '');
+			assert.deepEqual(common.splitMdbLines(output, {}), [
+			    '{',
+			    '    "first": {',
+			    '        "sharedMarker": 2,',
+			    '    },',
+			    '    "second": [Shared ' + addr + '],',
+			    '}'
+			]);
+			callback();
+		    });
+	});
+
+	/*
+	 * Each invocation starts with no objects visited, so printing the
+	 * shared object on its own prints it in full.
+	 */
+	testFuncs.push(function checkSharedAlone(mdb, callback) {
+		console.error('test: ::jsprint of shared object alone');
+		mdb.runCmd(addrs['holder'] + '::jsprint second\n',
+		    function (output, erroutput) {
+			assert.strictEqual(erroutput, '');
+			assert.deepEqual(common.splitMdbLines(output, {}), [
+			    '{',
+			    '    "sharedMarker": 2,',
+			    '}'
+			]);
+			callback();
+		    });
+	});
+
+	common.finalizeTestObject(testObject);
+	common.standaloneTest(testFuncs, function (err) {
+		if (err) {
+			throw (err);
+		}
+
+		console.log('%s passed', process.argv[1]);
+	});
+}
+
+main();
@@ -0,0 +1,118 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * tst.jsscripts.js: checks that "::jsscripts" lists this script, and that
+ * "::jsscripts -o" saves its source as V8 loaded it.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var mod_module = require('module');
+var path = require('path');
+
+var common = require('./common');
+
+var testObject;
+
+/*
+ * Returns the name of the file that "::jsscripts -o" uses for a script named
+ * "name".
+ */
+function scriptFileName(name)
+{
+	return (name.replace(/^\/+/, '').replace(/[^a-zA-Z0-9._-]/g, '_'));
+}
+
+function main()
+{
+	var testFuncs = [];
+	var source, outdir;
+
+	source = fs.readFileSync(__filename, 'utf8');
+	testObject = {};
+
+	testFuncs.push(function findTestObjectAddress(mdb, callback) {
+		common.findTestObject(mdb, function (err) {
+			callback(err);
+		});
+	});
+
+	testFuncs.push(function checkListing(mdb, callback) {
+		console.error('test: ::jsscripts');
+		mdb.runCmd('::jsscripts\n', function (output, erroutput) {
+			var lines, found;
+
+			assert.strictEqual(erroutput, '');
+			lines = common.splitMdbLines(output, {});
+			assert.ok(/^\s*SCRIPT\s+#FUNCS\s+NAME$/.test(lines[0]),
+			    'unexpected header: ' + lines[0]);
+
+			found = lines.slice(1).filter(function (line) {
+				var parts = line.trim().split(/\s+/);
+				return (parts.length == 3 &&
+				    parts[2] == __filename &&
+				    parseInt(parts[1], 10) > 0);
+			});
+			assert.strictEqual(found.length, 1,
+			    'expected to find ' + __filename + ' once');
+			callback();
+		});
+	});
+
+	testFuncs.push(function checkSave(mdb, callback) {
+		console.error('test: ::jsscripts -o');
+		outdir = mdb.mdb_target_name + '.scripts';
+		mdb.runCmd('::jsscripts -o ' + outdir + '\n',
+		    function (output, erroutput) {
+			var lines, match, files, saved, wrapper;
+
+			assert.strictEqual(erroutput, '');
+			lines = common.splitMdbLines(output, { 'count': 1 });
+			match = lines[0].match(/^wrote (\d+) of (\d+) scripts/);
+			assert.notStrictEqual(match, null,
+			    'unexpected output: ' + lines[0]);
+			assert.strictEqual(match[1], match[2]);
+
+			files = fs.readdirSync(outdir);
+			assert.strictEqual(files.length,
+			    parseInt(match[1], 10));
+
+			/*
+			 * Depending on the Node version, modules' sources are
+			 * either compiled as they are or wrapped in a function
+			 * first.
+			 */
+			saved = fs.readFileSync(path.join(outdir,
+			    scriptFileName(__filename)), 'utf8');
+			wrapper = mod_module.wrapper;
+			assert.ok(saved === source || (wrapper !== undefined &&
+			    saved === wrapper[0] + source + wrapper[1]),
+			    'saved script does not match source');
+
+			files.forEach(function (file) {
+				fs.unlinkSync(path.join(outdir, file));
+			});
+			fs.rmdirSync(outdir);
+			callback();
+		    });
+	});
+
+	common.finalizeTestObject(testObject);
+	common.standaloneTest(testFuncs, function (err) {
+		if (err) {
+			throw (err);
+		}
+
+		console.log('%s passed', process.argv[1]);
+	});
+}
+
+main();
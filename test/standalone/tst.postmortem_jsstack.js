@@ -61,7 +61,6 @@ var dtrace = spawn('dtrace', [ '-qwn', 'syscall::getloadavg:entry/pid == ' +
     prefix + ' %d", pid); system("prun %d", pid); exit(0); }' ]);
 
 var output = '';
-var unlinkSync = require('fs').unlinkSync;
 
 dtrace.stderr.on('data', function (data) {
 	console.log('dtrace: ' + data);
@@ -168,8 +167,7 @@ dtrace.on('exit', function (code) {
 			    'did not find arg1 (' + straddr +
 			    ') to contain expected string' + retained);
 
-			unlinkSync(corefile);
-			process.exit(0);
+			checkFolded(retained);
 		});
 
 		mdb.stdout.on('data', function (data) {
@@ -198,4 +196,77 @@ dtrace.on('exit', function (code) {
 	mdb.stdin.end();
 });
 
+/*
+ * Finally, check the folded output of "::jsstack -F": one line with all of the
+ * frames, outermost first, separated by semicolons, and a count.  Our frames
+ * should appear consecutively, outermost (doogle) first.  -F can't be combined
+ * with options that only affect the regular output.
+ */
+function checkFolded(retained)
+{
+	var names = [ 'doogle', 'bagnoogle', 'stalloogle' ];
+	var badopts = [ '-a', '-f 0', '-p foo', '-v' ];
+
+	common.createMdbSession({
+	    'targetType': 'file',
+	    'targetName': corefile,
+	    'loadDmod': true,
+	    'removeOnSuccess': true
+	}, function (err, mdb) {
+		if (err) {
+			console.error('failed to start mdb: ' + err.message +
+			    retained);
+			process.exit(1);
+		}
+
+		mdb.runCmd('::jsstack -F\n', function (output, erroutput) {
+			var lines, stack, i, j;
+
+			assert.equal(erroutput, '', 'unexpected stderr' +
+			    retained);
+			lines = common.splitMdbLines(output, { 'count': 1 });
+			assert.ok(/;.* 1$/.test(lines[0]),
+			    'expected one folded stack with a count of 1: ' +
+			    lines[0] + retained);
+
+			stack = lines[0].replace(/ 1$/, '').split(';');
+			for (i = 0; i < stack.length; i++) {
+				if (stack[i].indexOf(names[0]) !== -1)
+					break;
+			}
+
+			for (j = 0; j < names.length; j++, i++) {
+				assert.ok(i < stack.length &&
+				    stack[i].indexOf(names[j]) !== -1 &&
+				    stack[i].indexOf(path.basename(
+				    __filename)) !== -1, 'expected frame for ' +
+				    names[j] + ' in folded stack: ' + lines[0] +
+				    retained);
+			}
+
+			checkBadOption(mdb, badopts, retained);
+		});
+	});
+}
+
+function checkBadOption(mdb, badopts, retained)
+{
+	var opt;
+
+	if (badopts.length === 0) {
+		mdb.finish();
+		process.exit(0);
+	}
+
+	opt = badopts.shift();
+	mdb.runCmd('::jsstack -F ' + opt + '\n', function (output, erroutput) {
+		assert.equal(output, '', 'unexpected output for -F ' + opt +
+		    retained);
+		assert.notEqual(erroutput.indexOf('cannot specify -F with ' +
+		    '-a, -f, -p, or -v'), -1, 'expected -F ' + opt +
+		    ' to be rejected' + retained);
+		checkBadOption(mdb, badopts, retained);
+	});
+}
+
 setTimeout(doogle, 10);
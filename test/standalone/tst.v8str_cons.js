@@ -0,0 +1,228 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * tst.v8str_cons.js: checks printing of ConsStrings that are thousands of
+ * levels deep, and of a ConsString that's malformed.
+ *
+ * Appending to a string one piece at a time produces a ConsString whose left
+ * child is the string so far, so the tree is as deep as the number of appends.
+ * Prepending does the same on the right.  With one-character pieces, these
+ * trees also have nearly as many nodes as mdb_v8 allows for a string of their
+ * length before deciding that the tree is malformed.
+ *
+ * A malformed tree can't be built from JavaScript, so we make one by copying
+ * the core file and changing one ConsString's first child to point to the
+ * ConsString itself.  Printing it must report the problem rather than loop.
+ */
+
+var assert = require('assert');
+var fs = require('fs');
+var util = require('util');
+
+var common = require('./common');
+
+var NPIECES = 20000;
+var PTRSIZE = process.arch == 'x64' ? 8 : 4;
+
+var testObject;
+
+function buildStrings()
+{
+	var appended, prepended, i, c;
+
+	appended = '';
+	prepended = '';
+	for (i = 0; i < NPIECES; i++) {
+		c = String.fromCharCode('a'.charCodeAt(0) + (i % 26));
+		appended += c;
+		prepended = c + prepended;
+	}
+
+	return ({
+	    'appended': appended,
+	    'prepended': prepended,
+	    /*
+	     * Both halves are flat, and together they're long enough that V8
+	     * makes a ConsString rather than copying them.
+	     */
+	    'shallow': 'shallow cons string ' + process.pid
+	});
+}
+
+/*
+ * Returns the bytes of pointer "hexaddr" as stored in memory (little-endian).
+ */
+function pointerBytes(hexaddr)
+{
+	var buf, i, hex;
+
+	hex = hexaddr.replace(/^0x/, '');
+	while (hex.length < 2 * PTRSIZE)
+		hex = '0' + hex;
+
+	buf = new Buffer(PTRSIZE);
+	for (i = 0; i < PTRSIZE; i++) {
+		buf[i] = parseInt(hex.substr(hex.length - 2 * (i + 1), 2), 16);
+	}
+
+	return (buf);
+}
+
+/*
+ * Returns the offset of the only occurrence of "needle" in "haystack", or -1 if
+ * it doesn't occur exactly once.
+ */
+function findUnique(haystack, needle)
+{
+	var i, j, found;
+
+	found = -1;
+	for (i = 0; i + needle.length <= haystack.length; i++) {
+		for (j = 0; j < needle.length; j++) {
+			if (haystack[i + j] != needle[j])
+				break;
+		}
+
+		if (j == needle.length) {
+			if (found != -1)
+				return (-1);
+			found = i;
+		}
+	}
+
+	return (found);
+}
+
+function main()
+{
+	var testFuncs = [];
+	var strings, addrTestObject;
+	var addrs = {};
+	var consChildren;
+
+	strings = buildStrings();
+	testObject = strings;
+
+	testFuncs.push(function findTestObjectAddress(mdb, callback) {
+		common.findTestObject(mdb, function (err, addr) {
+			addrTestObject = addr;
+			callback(err);
+		});
+	});
+
+	Object.keys(strings).forEach(function (k) {
+		testFuncs.push(function findString(mdb, callback) {
+			var cmdstr = util.format('%s::jsprint -a %s\n',
+			    addrTestObject, k);
+			mdb.runCmd(cmdstr, function (output) {
+				var lines = common.splitMdbLines(output, {});
+				addrs[k] = lines[0].split(':')[0];
+				assert.ok(/^[0-9a-fA-F]+$/.test(addrs[k]),
+				    'unexpected output: ' + lines[0]);
+				callback();
+			});
+		});
+	});
+
+	[ 'appended', 'prepended' ].forEach(function (k) {
+		testFuncs.push(function checkDeepString(mdb, callback) {
+			console.error('test: deep ConsString (%s)', k);
+			mdb.runCmd(addrs[k] + '::v8str\n',
+			    function (output, erroutput) {
+				var lines;
+				lines = common.splitMdbLines(output,
+				    { 'count': 1 });
+				assert.strictEqual(erroutput, '');
+				assert.strictEqual(lines[0],
+				    '"' + strings[k] + '"');
+				callback();
+			    });
+		});
+	});
+
+	testFuncs.push(function checkShallowString(mdb, callback) {
+		console.error('test: shallow ConsString');
+		mdb.runCmd(addrs['shallow'] + '::v8str -v\n',
+		    function (output) {
+			var lines, match;
+			lines = common.splitMdbLines(output, { 'count': 2 });
+			/* JSSTYLED */
+			match = lines[0].match(/cons of (?:0x)?([0-9a-f]+) and (?:0x)?([0-9a-f]+)$/i);
+			assert.notStrictEqual(match, null,
+			    'expected a ConsString: ' + lines[0]);
+			consChildren = [ match[1], match[2] ];
+			assert.strictEqual(lines[1],
+			    '"' + strings['shallow'] + '"');
+			callback();
+		    });
+	});
+
+	testFuncs.push(function checkMalformedString(mdb, callback) {
+		var corefile, badcore, contents, needle, off;
+
+		console.error('test: malformed ConsString');
+
+		/*
+		 * A ConsString's two children are stored next to each other,
+		 * so look for that pair of pointers in the core file and
+		 * replace the first with the ConsString itself.
+		 */
+		corefile = mdb.mdb_target_name;
+		badcore = corefile + '.malformed';
+		contents = fs.readFileSync(corefile);
+		needle = Buffer.concat([ pointerBytes(consChildren[0]),
+		    pointerBytes(consChildren[1]) ]);
+		off = findUnique(contents, needle);
+		assert.notStrictEqual(off, -1,
+		    'did not find ConsString children exactly once in core');
+		pointerBytes(addrs['shallow']).copy(contents, off);
+		fs.writeFileSync(badcore, contents);
+		contents = null;
+
+		common.createMdbSession({
+		    'targetType': 'file',
+		    'targetName': badcore,
+		    'loadDmod': true,
+		    'removeOnSuccess': true
+		}, function (err, badmdb) {
+			if (err) {
+				callback(err);
+				return;
+			}
+
+			/*
+			 * The default buffer is sized for the string, which is
+			 * shorter than the message we expect.
+			 */
+			badmdb.runCmd(addrs['shallow'] + '::v8str -N 1024\n',
+			    function (output) {
+				var lines;
+				lines = common.splitMdbLines(output,
+				    { 'count': 1 });
+				assert.strictEqual(lines[0],
+				    '"<string (cons string is malformed)>"');
+				badmdb.finish();
+				callback();
+			    });
+		});
+	});
+
+	common.finalizeTestObject(testObject);
+	common.standaloneTest(testFuncs, function (err) {
+		if (err) {
+			throw (err);
+		}
+
+		console.log('%s passed', process.argv[1]);
+	});
+}
+
+main();
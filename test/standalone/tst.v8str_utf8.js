@@ -0,0 +1,181 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * tst.v8str_utf8.js: checks how "::v8str" and "::jsprint" print non-ASCII
+ * strings, both as UTF-8 (with "-u") and with each non-ASCII code unit
+ * replaced by "?" (without it).
+ */
+
+var assert = require('assert');
+var util = require('util');
+
+var common = require('./common');
+
+/*
+ * Each of these strings is found in the core file and printed.  Together they
+ * cover one-byte (Latin-1) and two-byte strings, characters that need two,
+ * three, and four bytes as UTF-8 (the last being surrogate pairs), unpaired
+ * surrogates, and a string long enough that it's read in several chunks, with
+ * surrogate pairs falling at every possible offset relative to the ASCII runs
+ * that are copied in blocks.
+ */
+var testStrings = {
+    'latin1': 'café crème',
+    'bmp': '日本語の文字列',
+    'astral': 'smile 😀 and 🎉 done',
+    'loneHigh': 'x\ud800y',
+    'loneLow': 'x\udc00y',
+    'pairAtEnd': 'abc😀',
+    'long': ''
+};
+
+var testObject;
+
+/*
+ * The UTF-8 encoding of U+1F600 ("😀"), used to check raw bytes.
+ */
+var SMILE_UTF8 = 'f09f9880';
+
+function buildLongString()
+{
+	var parts = [];
+	var i;
+
+	for (i = 0; i < 300; i++) {
+		parts.push('abcdefg'.substr(0, i % 8));
+		parts.push('é世😀');
+	}
+
+	return (parts.join(''));
+}
+
+/*
+ * Returns what mdb_v8 should print for "str" with "-u": unpaired surrogates
+ * can't be represented in UTF-8, so they're replaced with "?".
+ */
+function expectedUtf8(str)
+{
+	return (str.replace(/[\ud800-\udbff](?![\udc00-\udfff])/g, '?').
+	    replace(/(^|[^\ud800-\udbff])[\udc00-\udfff]/g, '$1?'));
+}
+
+/*
+ * Returns what mdb_v8 should print for "str" without "-u": every non-ASCII
+ * UTF-16 code unit (so both halves of a surrogate pair) becomes "?".
+ */
+function expectedAscii(str)
+{
+	return (str.replace(/[^\x00-\x7f]/g, '?'));
+}
+
+function main()
+{
+	var testFuncs = [];
+	var addrTestObject;
+	var addrs = {};
+
+	testStrings['long'] = buildLongString();
+	testObject = {};
+	Object.keys(testStrings).forEach(function (k) {
+		testObject[k] = testStrings[k];
+	});
+
+	testFuncs.push(function findTestObjectAddress(mdb, callback) {
+		common.findTestObject(mdb, function (err, addr) {
+			addrTestObject = addr;
+			callback(err);
+		});
+	});
+
+	Object.keys(testStrings).forEach(function (k) {
+		testFuncs.push(function findString(mdb, callback) {
+			var cmdstr = util.format('%s::jsprint -a %s\n',
+			    addrTestObject, k);
+			mdb.runCmd(cmdstr, function (output) {
+				var lines = common.splitMdbLines(output, {});
+				addrs[k] = lines[0].split(':')[0];
+				assert.ok(/^[0-9a-fA-F]+$/.test(addrs[k]),
+				    'unexpected output: ' + lines[0]);
+				callback();
+			});
+		});
+
+		testFuncs.push(function checkV8strUtf8(mdb, callback) {
+			console.error('test: ::v8str -u of "%s"', k);
+			mdb.runCmd(addrs[k] + '::v8str -u\n',
+			    function (output, erroutput) {
+				var lines;
+				lines = common.splitMdbLines(output,
+				    { 'count': 1 });
+				assert.strictEqual(erroutput, '');
+				assert.strictEqual(lines[0],
+				    '"' + expectedUtf8(testStrings[k]) + '"');
+				callback();
+			    });
+		});
+
+		testFuncs.push(function checkV8strAscii(mdb, callback) {
+			console.error('test: ::v8str of "%s"', k);
+			mdb.runCmd(addrs[k] + '::v8str\n', function (output) {
+				var lines;
+				lines = common.splitMdbLines(output,
+				    { 'count': 1 });
+				assert.strictEqual(lines[0],
+				    '"' + expectedAscii(testStrings[k]) + '"');
+				callback();
+			});
+		});
+
+		testFuncs.push(function checkJsprintUtf8(mdb, callback) {
+			var cmdstr;
+			console.error('test: ::jsprint -u of "%s"', k);
+			cmdstr = util.format('%s::jsprint -u %s\n',
+			    addrTestObject, k);
+			mdb.runCmd(cmdstr, function (output) {
+				var lines;
+				lines = common.splitMdbLines(output,
+				    { 'count': 1 });
+				assert.strictEqual(lines[0],
+				    '"' + expectedUtf8(testStrings[k]) + '"');
+				callback();
+			});
+		});
+	});
+
+	/*
+	 * Check the bytes themselves for one of the four-byte characters, in
+	 * case both sides of the comparisons above were decoded the same wrong
+	 * way.
+	 */
+	testFuncs.push(function checkRawBytes(mdb, callback) {
+		console.error('test: raw UTF-8 bytes');
+		mdb.runCmd(addrs['pairAtEnd'] + '::v8str -u\n',
+		    function (output) {
+			var lines, hex;
+			lines = common.splitMdbLines(output, { 'count': 1 });
+			hex = new Buffer(lines[0], 'utf8').toString('hex');
+			assert.strictEqual(hex, new Buffer('"abc', 'utf8').
+			    toString('hex') + SMILE_UTF8 + '22');
+			callback();
+		    });
+	});
+
+	common.finalizeTestObject(testObject);
+	common.standaloneTest(testFuncs, function (err) {
+		if (err) {
+			throw (err);
+		}
+
+		console.log('%s passed', process.argv[1]);
+	});
+}
+
+main();
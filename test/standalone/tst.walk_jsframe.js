@@ -0,0 +1,94 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Copyright (c) 2026, Joyent, Inc.
+ */
+
+/*
+ * tst.walk_jsframe.js: checks that "::walk jsframe" stops when the chain of
+ * frame pointers doesn't advance toward callers' frames.
+ *
+ * We can't easily get a real stack with a broken frame pointer chain into a
+ * core file, so we fake one: a Buffer whose first word (the "saved frame
+ * pointer") points to a low address that's below the buffer itself.  Walking
+ * from the buffer's contents should report exactly one frame and stop without
+ * an error, rather than following the pointer.
+ */
+
+var assert = require('assert');
+var util = require('util');
+
+var common = require('./common');
+
+var FAKE_FRAME_POINTER = 0x1000;
+
+var testObject;
+
+function main()
+{
+	var testFuncs = [];
+	var addrTestObject, addrBuffer, addrData;
+	var frame;
+
+	frame = new Buffer(16);
+	frame.fill(0);
+	frame.writeUInt32LE(FAKE_FRAME_POINTER, 0);
+	testObject = { 'fakeFrame': frame };
+
+	testFuncs.push(function findTestObjectAddress(mdb, callback) {
+		common.findTestObject(mdb, function (err, addr) {
+			addrTestObject = addr;
+			callback(err);
+		});
+	});
+
+	testFuncs.push(function findBuffer(mdb, callback) {
+		var cmdstr = addrTestObject + '::jsprint -a fakeFrame\n';
+		mdb.runCmd(cmdstr, function (output) {
+			var lines = common.splitMdbLines(output, {});
+			addrBuffer = lines[0].split(':')[0];
+			assert.ok(/^[0-9a-fA-F]+$/.test(addrBuffer),
+			    'unexpected output: ' + lines[0]);
+			callback();
+		});
+	});
+
+	testFuncs.push(function findBufferData(mdb, callback) {
+		mdb.runCmd(addrBuffer + '::nodebuffer\n', function (output) {
+			var lines;
+			lines = common.splitMdbLines(output, { 'count': 1 });
+			addrData = lines[0];
+			assert.ok(/^[0-9a-fA-F]+$/.test(addrData),
+			    'unexpected output: ' + lines[0]);
+			callback();
+		});
+	});
+
+	testFuncs.push(function walkFakeFrame(mdb, callback) {
+		console.error('test: walk stops at non-advancing frame');
+		mdb.runCmd(addrData + '::walk jsframe\n',
+		    function (output, erroutput) {
+			var lines;
+			lines = common.splitMdbLines(output, { 'count': 1 });
+			assert.strictEqual(erroutput, '');
+			assert.strictEqual(parseInt(lines[0], 16),
+			    parseInt(addrData, 16));
+			callback();
+		    });
+	});
+
+	common.finalizeTestObject(testObject);
+	common.standaloneTest(testFuncs, function (err) {
+		if (err) {
+			throw (err);
+		}
+
+		console.log('%s passed', process.argv[1]);
+	});
+}
+
+main();